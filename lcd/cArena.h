@@ -0,0 +1,97 @@
+// cArena.h - bump allocator for per render temporaries, reset frees everything at once
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+
+//{{{
+class cArena {
+// - allocations bump through one buffer, beyond it overflow chunks are malloced
+// - reset frees overflow chunks and grows buffer to the high water mark,
+//   so once a workload has been seen again it allocates nothing
+public:
+  //{{{
+  cArena (const uint32_t size) {
+    if (size)
+      grow (size);
+    }
+  //}}}
+  //{{{
+  ~cArena() {
+    freeChunks();
+    free (mBuf);
+    }
+  //}}}
+
+  uint32_t getSize() const { return mSize; }
+  uint32_t getHighWater() const { return mHighWater; }
+
+  //{{{
+  void* alloc (uint32_t bytes) {
+  // 16 byte aligned, valid until reset
+
+    bytes = (bytes + 15) & ~15u;
+    mUsed += bytes;
+
+    if (mUsed <= mSize)
+      return mBuf + mUsed - bytes;
+
+    // overflow chunk, header padded to keep alignment
+    sChunk* chunk = (sChunk*)aligned_alloc (16, ((sizeof(sChunk) + 15) & ~15u) + bytes);
+    chunk->next = mChunks;
+    mChunks = chunk;
+    return (uint8_t*)chunk + ((sizeof(sChunk) + 15) & ~15u);
+    }
+  //}}}
+  //{{{
+  template <class T> T* alloc (const uint32_t num) {
+    return (T*)alloc (num * sizeof(T));
+    }
+  //}}}
+
+  //{{{
+  void reset() {
+  // free everything, grow to high water mark if anything overflowed
+
+    if (mUsed > mHighWater)
+      mHighWater = mUsed;
+
+    if (mChunks) {
+      freeChunks();
+      grow (mHighWater);
+      }
+
+    mUsed = 0;
+    }
+  //}}}
+
+private:
+  struct sChunk {
+    sChunk* next;
+    };
+
+  //{{{
+  void grow (const uint32_t size) {
+
+    free (mBuf);
+    mSize = (size + 127) & ~127u;
+    mBuf = (uint8_t*)aligned_alloc (128, mSize);
+    }
+  //}}}
+  //{{{
+  void freeChunks() {
+
+    while (mChunks) {
+      sChunk* next = mChunks->next;
+      free (mChunks);
+      mChunks = next;
+      }
+    }
+  //}}}
+
+  uint8_t* mBuf = nullptr;
+  uint32_t mSize = 0;
+  uint32_t mUsed = 0;
+  uint32_t mHighWater = 0;
+  sChunk* mChunks = nullptr;
+  };
+//}}}
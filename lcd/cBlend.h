@@ -0,0 +1,204 @@
+// cBlend.h - rgb565 row blenders
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+//{{{
+class cBlend {
+// magical rgb565 alpha composite
+// - linear interp back * (1.0 - alpha) + fore * alpha
+//   - factorized into: result = back + (fore - back) * alpha
+//   - alpha is in Q1.5 format, so 0.0 is represented by 0, and 1.0 is represented by 32
+// - Converts  0000000000000000rrrrrggggggbbbbb
+// -     into  00000gggggg00000rrrrr000000bbbbb
+public:
+  //{{{
+  static inline uint32_t expand (const uint16_t colour) {
+    uint32_t colour32 = colour;
+    return (colour32 | (colour32 << 16)) & 0x07e0f81f;
+    }
+  //}}}
+  //{{{
+  static inline uint16_t blend (const uint32_t fore32, const uint16_t back, const uint8_t alpha) {
+
+    uint32_t back32 = expand (back);
+    back32 += (((fore32 - back32) * ((alpha + 4) >> 3)) >> 5) & 0x07e0f81f;
+    return back32 | (back32 >> 16);
+    }
+  //}}}
+
+  //{{{
+  static inline void blend4 (uint16_t* dst, const uint16_t colour, const uint32_t fore32, const uint8_t* alpha) {
+  // 4 pixels, 4 alphas, as blend in uint32 lanes, alpha 0xFF lanes colour exactly as the scalar paths
+
+    typedef uint32_t v4u32 __attribute__ ((vector_size (16)));
+    typedef int32_t v4i32 __attribute__ ((vector_size (16)));
+
+    v4u32 a = { alpha[0], alpha[1], alpha[2], alpha[3] };
+    v4u32 back = { dst[0], dst[1], dst[2], dst[3] };
+
+    back = (back | (back << 16)) & 0x07e0f81f;
+    back += (((fore32 - back) * ((a + 4) >> 3)) >> 5) & 0x07e0f81f;
+    back = (back | (back >> 16)) & 0xFFFF;
+
+    v4u32 full = (v4u32)(v4i32)(a == 0xFF);
+    back = (back & ~full) | (colour & full);
+
+    dst[0] = back[0];
+    dst[1] = back[1];
+    dst[2] = back[2];
+    dst[3] = back[3];
+    }
+  //}}}
+
+  //{{{
+  static void fillRow (uint16_t* dst, const uint16_t colour, int num) {
+  // opaque fill, 4 pixels per 64bit store once aligned
+
+    while (num && ((uintptr_t)dst & 7)) {
+      *dst++ = colour;
+      num--;
+      }
+
+    uint64_t colour64 = colour;
+    colour64 |= (colour64 << 48) | (colour64 << 32) | (colour64 << 16);
+
+    uint64_t* dst64 = (uint64_t*)dst;
+    for (; num >= 4; num -= 4)
+      *dst64++ = colour64;
+
+    dst = (uint16_t*)dst64;
+    while (num--)
+      *dst++ = colour;
+    }
+  //}}}
+  //{{{
+  static void constRow (uint16_t* dst, const uint16_t colour, const uint8_t alpha, int num) {
+  // single colour, single alpha, fore expanded once
+
+    if (alpha == 0xFF)
+      fillRow (dst, colour, num);
+
+    else if (alpha) {
+      uint32_t fore32 = expand (colour);
+      while (num--) {
+        *dst = blend (fore32, *dst, alpha);
+        dst++;
+        }
+      }
+    }
+  //}}}
+  //{{{
+  static void maskRow (uint16_t* dst, const uint16_t colour, const uint8_t* mask, int num) {
+  // single colour through a8 coverage mask, 8 mask bytes tested at a time
+  // - full coverage blocks stored as fill, partial blocks blended 4 pixels per gcc vector
+
+    uint32_t fore32 = expand (colour);
+    uint64_t colour64 = colour;
+    colour64 |= (colour64 << 48) | (colour64 << 32) | (colour64 << 16);
+
+    for (; num >= 8; num -= 8, dst += 8, mask += 8) {
+      uint64_t mask8;
+      memcpy (&mask8, mask, 8);
+      if (mask8 == 0)
+        continue;
+      if (mask8 == 0xFFFFFFFFFFFFFFFFull) {
+        memcpy (dst, &colour64, 8);
+        memcpy (dst + 4, &colour64, 8);
+        }
+      else {
+        blend4 (dst, colour, fore32, mask);
+        blend4 (dst + 4, colour, fore32, mask + 4);
+        }
+      }
+
+    for (; num > 0; num--, dst++, mask++)
+      if (*mask)
+        *dst = (*mask == 0xFF) ? colour : blend (fore32, *dst, *mask);
+    }
+  //}}}
+  //{{{
+  static void subpixelRow (uint16_t* dst, const uint16_t colour, const uint8_t* mask, int num) {
+  // single colour through r,g,b coverage triple per pixel, each channel blended by its own coverage
+
+    int foreR = colour >> 11;
+    int foreG = (colour >> 5) & 0x3F;
+    int foreB = colour & 0x1F;
+
+    for (; num; num--, dst++, mask += 3) {
+      if (!(mask[0] | mask[1] | mask[2]))
+        continue;
+
+      if ((mask[0] & mask[1] & mask[2]) == 0xFF) {
+        *dst = colour;
+        continue;
+        }
+
+      int backR = *dst >> 11;
+      int backG = (*dst >> 5) & 0x3F;
+      int backB = *dst & 0x1F;
+      backR += ((foreR - backR) * ((mask[0] + 4) >> 3)) >> 5;
+      backG += ((foreG - backG) * ((mask[1] + 4) >> 3)) >> 5;
+      backB += ((foreB - backB) * ((mask[2] + 4) >> 3)) >> 5;
+      *dst = (backR << 11) | (backG << 5) | backB;
+      }
+    }
+  //}}}
+  //{{{
+  static void alphaRow (uint16_t* dst, const uint16_t* src, const uint8_t* alpha, int num) {
+  // src pixels through a8 alpha, 4 alpha bytes tested at a time
+
+    for (; num >= 4; num -= 4, dst += 4, src += 4, alpha += 4) {
+      uint32_t alpha4;
+      memcpy (&alpha4, alpha, 4);
+      if (alpha4 == 0)
+        continue;
+      if (alpha4 == 0xFFFFFFFF)
+        memcpy (dst, src, 8);
+      else
+        for (int i = 0; i < 4; i++)
+          if (alpha[i])
+            dst[i] = (alpha[i] == 0xFF) ? src[i] : blend (expand (src[i]), dst[i], alpha[i]);
+      }
+
+    for (; num > 0; num--, dst++, src++, alpha++)
+      if (*alpha)
+        *dst = (*alpha == 0xFF) ? *src : blend (expand (*src), *dst, *alpha);
+    }
+  //}}}
+  //{{{
+  static void copyAlphaRow (uint16_t* dst, const uint16_t* src, const uint8_t alpha, int num) {
+  // src pixels through single alpha
+
+    if (alpha == 0xFF)
+      memcpy (dst, src, num * 2);
+
+    else if (alpha)
+      for (; num > 0; num--, dst++, src++)
+        *dst = blend (expand (*src), *dst, alpha);
+    }
+  //}}}
+  //{{{
+  static void keyRow (uint16_t* dst, const uint16_t* src, const uint16_t colourKey, int num) {
+  // src pixels except colourKey
+
+    for (; num > 0; num--, dst++, src++)
+      if (*src != colourKey)
+        *dst = *src;
+    }
+  //}}}
+  //{{{
+  static void keyAlphaRow (uint16_t* dst, const uint16_t* src, const uint16_t colourKey, const uint8_t alpha, int num) {
+  // src pixels except colourKey, through single alpha
+
+    if (alpha == 0xFF)
+      keyRow (dst, src, colourKey, num);
+
+    else if (alpha)
+      for (; num > 0; num--, dst++, src++)
+        if (*src != colourKey)
+          *dst = blend (expand (*src), *dst, alpha);
+    }
+  //}}}
+  };
+//}}}
@@ -0,0 +1,154 @@
+// cCompositor.cpp
+#include "cCompositor.h"
+#include "cBlend.h"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// cLayer
+//{{{
+cLayer::cLayer (const uint16_t width, const uint16_t height)
+    : mWidth(width), mHeight(height), mKeyed(false), mColourKey(0), mOpacity(0xFF) {
+
+  mFrameBuf = (uint16_t*)aligned_alloc (128, width * height * 2);
+  for (int y = 0; y < mHeight; y++)
+    cBlend::fillRow (mFrameBuf + (y * mWidth), 0, mWidth);
+
+  invalidate();
+  }
+//}}}
+//{{{
+cLayer::cLayer (const uint16_t width, const uint16_t height, const uint16_t colourKey, const uint8_t opacity)
+    : mWidth(width), mHeight(height), mKeyed(true), mColourKey(colourKey), mOpacity(opacity) {
+
+  mFrameBuf = (uint16_t*)aligned_alloc (128, width * height * 2);
+  for (int y = 0; y < mHeight; y++)
+    cBlend::fillRow (mFrameBuf + (y * mWidth), colourKey, mWidth);
+
+  invalidate();
+  }
+//}}}
+//{{{
+cLayer::~cLayer() {
+  free (mFrameBuf);
+  }
+//}}}
+
+//{{{
+void cLayer::setOpacity (const uint8_t opacity) {
+
+  if (opacity != mOpacity) {
+    mOpacity = opacity;
+    invalidate();
+    }
+  }
+//}}}
+//{{{
+void cLayer::setVisible (const bool visible) {
+
+  if (visible != mVisible) {
+    mVisible = visible;
+    invalidate();
+    }
+  }
+//}}}
+
+//{{{
+void cLayer::invalidate() {
+  mDirty.set (cRect (0,0, mWidth,mHeight));
+  }
+//}}}
+//{{{
+void cLayer::invalidate (const cRect& r) {
+  mDirty.unite (r.intersect (cRect (0,0, mWidth,mHeight)));
+  }
+//}}}
+
+// cCompositor
+//{{{
+cCompositor::cCompositor (const uint16_t width, const uint16_t height) : mWidth(width), mHeight(height) {}
+//}}}
+//{{{
+cCompositor::~cCompositor() {
+
+  for (auto layer : mLayers)
+    delete layer;
+  }
+//}}}
+
+//{{{
+cLayer* cCompositor::addLayer() {
+
+  mLayers.push_back (new cLayer (mWidth, mHeight));
+  return mLayers.back();
+  }
+//}}}
+//{{{
+cLayer* cCompositor::addLayer (const uint16_t colourKey, const uint8_t opacity) {
+
+  mLayers.push_back (new cLayer (mWidth, mHeight, colourKey, opacity));
+  return mLayers.back();
+  }
+//}}}
+
+//{{{
+void cCompositor::invalidate() {
+// frameBufs unknown, compose everything into both
+
+  for (auto layer : mLayers)
+    layer->invalidate();
+  mPrevDirty.set (cRect (0,0, mWidth,mHeight));
+  }
+//}}}
+//{{{
+void cCompositor::compose (uint16_t* frameBuf) {
+// composite union of layer dirty regions, plus last frame dirty region stale in this frameBuf
+
+  mDirty.clear();
+  for (auto layer : mLayers) {
+    mDirty.unite (layer->getDirty());
+    layer->clean();
+    }
+
+  mComposeRegion = mDirty;
+  mComposeRegion.unite (mPrevDirty);
+  for (auto& r : mComposeRegion)
+    composeRect (frameBuf, r);
+
+  mPrevDirty = mDirty;
+  }
+//}}}
+
+// private
+//{{{
+void cCompositor::composeRect (uint16_t* frameBuf, const cRect& r) {
+// bottom visible layer copied over black, layers above blended row by row, each through its opacity
+
+  int numPix = r.right - r.left;
+  for (int y = r.top; y < r.bottom; y++) {
+    uint16_t* dst = frameBuf + (y * mWidth) + r.left;
+
+    bool first = true;
+    for (auto layer : mLayers) {
+      if (!layer->getVisible())
+        continue;
+
+      uint16_t* src = layer->getFrameBuf() + (y * mWidth) + r.left;
+      if (first && (layer->getOpacity() != 0xFF))
+        cBlend::fillRow (dst, 0, numPix);
+
+      if (first || !layer->isKeyed())
+        // unkeyed layer covers everything below, copied when opaque
+        cBlend::copyAlphaRow (dst, src, layer->getOpacity(), numPix);
+      else
+        cBlend::keyAlphaRow (dst, src, layer->getColourKey(), layer->getOpacity(), numPix);
+      first = false;
+      }
+
+    if (first)
+      cBlend::fillRow (dst, 0, numPix);
+    }
+  }
+//}}}
@@ -0,0 +1,71 @@
+// cCompositor.h - rgb565 layers, composited only where dirty
+#pragma once
+#include <vector>
+#include "cPointRect.h"
+#include "cRegion.h"
+
+//{{{
+class cLayer {
+// upper layers transparent where colourKey, every layer whole layer opacity, bottom layer over black
+public:
+  cLayer (const uint16_t width, const uint16_t height);
+  cLayer (const uint16_t width, const uint16_t height, const uint16_t colourKey, const uint8_t opacity = 0xFF);
+  ~cLayer();
+
+  uint16_t* getFrameBuf() { return mFrameBuf; }
+  bool isKeyed() const { return mKeyed; }
+  uint16_t getColourKey() const { return mColourKey; }
+  uint8_t getOpacity() const { return mOpacity; }
+  bool getVisible() const { return mVisible; }
+  const cRegion& getDirty() const { return mDirty; }
+
+  void setOpacity (const uint8_t opacity);
+  void setVisible (const bool visible);
+
+  void invalidate();
+  void invalidate (const cRect& r);
+  void clean() { mDirty.clear(); }
+
+private:
+  const uint16_t mWidth;
+  const uint16_t mHeight;
+
+  const bool mKeyed;
+  const uint16_t mColourKey;
+  uint8_t mOpacity;
+  bool mVisible = true;
+
+  uint16_t* mFrameBuf = nullptr;
+  cRegion mDirty;
+  };
+//}}}
+//{{{
+class cCompositor {
+// layers bottom first, composite union of this and last frame dirty, frameBufs alternate by frameDiff swap
+public:
+  cCompositor (const uint16_t width, const uint16_t height);
+  ~cCompositor();
+
+  int getNumLayers() const { return (int)mLayers.size(); }
+  cLayer* getLayer (int index) { return mLayers[index]; }
+
+  cLayer* addLayer();
+  cLayer* addLayer (const uint16_t colourKey, const uint8_t opacity = 0xFF);
+
+  void invalidate();
+  void compose (uint16_t* frameBuf);
+
+private:
+  void composeRect (uint16_t* frameBuf, const cRect& r);
+
+  const uint16_t mWidth;
+  const uint16_t mHeight;
+
+  std::vector<cLayer*> mLayers;
+
+  // dirty composited last frame, still stale in the other frameBuf
+  cRegion mDirty;
+  cRegion mPrevDirty;
+  cRegion mComposeRegion;
+  };
+//}}}
@@ -0,0 +1,128 @@
+// cConvert.h - rgb888, bgr888, xrgb8888, yuv420 rows to rgb565, optional 4x4 ordered dither
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+//{{{
+class cConvert {
+// dither adds a bayer threshold below the truncated bits before truncating, 0..7 for 5 bit, 0..3 for 6 bit
+// - dst x,y select the threshold, so dither pattern is fixed to the screen, not the src
+public:
+  //{{{
+  static inline uint16_t pack (int r, int g, int b, const int dither) {
+  // dither is bayer 0..15
+
+    r += dither >> 1;
+    g += dither >> 2;
+    b += dither >> 1;
+    r = r > 255 ? 255 : r;
+    g = g > 255 ? 255 : g;
+    b = b > 255 ? 255 : b;
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+  //}}}
+  //{{{
+  static inline uint32_t ditherRow (const int x, const int y, const bool dither) {
+  // four bayer thresholds of row y, rotated to start at x, one per byte
+
+    static constexpr uint8_t kBayer[4][4] = { {  0,  8,  2, 10 },
+                                              { 12,  4, 14,  6 },
+                                              {  3, 11,  1,  9 },
+                                              { 15,  7, 13,  5 } };
+    if (!dither)
+      return 0;
+
+    const uint8_t* row = kBayer[y & 3];
+    return row[x & 3] | (row[(x+1) & 3] << 8) | (row[(x+2) & 3] << 16) | (row[(x+3) & 3] << 24);
+    }
+  //}}}
+
+  //{{{
+  template <int kBytes, int kR, int kG, int kB>
+  static void rgbRow (uint16_t* dst, const uint8_t* src, int num, const int x, const int y, const bool dither) {
+  // packed 24 or 32 bit pixels, kR kG kB byte offsets in pixel
+
+    uint32_t thresholds = ditherRow (x, y, dither);
+
+    for (; num >= 4; num -= 4, dst += 4, src += 4 * kBytes) {
+      dst[0] = pack (src[kR], src[kG], src[kB], thresholds & 0xFF);
+      dst[1] = pack (src[kBytes + kR], src[kBytes + kG], src[kBytes + kB], (thresholds >> 8) & 0xFF);
+      dst[2] = pack (src[2*kBytes + kR], src[2*kBytes + kG], src[2*kBytes + kB], (thresholds >> 16) & 0xFF);
+      dst[3] = pack (src[3*kBytes + kR], src[3*kBytes + kG], src[3*kBytes + kB], thresholds >> 24);
+      }
+
+    for (; num > 0; num--, dst++, src += kBytes) {
+      *dst = pack (src[kR], src[kG], src[kB], thresholds & 0xFF);
+      thresholds = (thresholds >> 8) | (thresholds << 24);
+      }
+    }
+  //}}}
+  //{{{
+  static void rgb888Row (uint16_t* dst, const uint8_t* src, int num, const int x, const int y, const bool dither) {
+    rgbRow<3,0,1,2> (dst, src, num, x, y, dither);
+    }
+  //}}}
+  //{{{
+  static void bgr888Row (uint16_t* dst, const uint8_t* src, int num, const int x, const int y, const bool dither) {
+    rgbRow<3,2,1,0> (dst, src, num, x, y, dither);
+    }
+  //}}}
+  //{{{
+  static void xrgb8888Row (uint16_t* dst, const uint8_t* src, int num, const int x, const int y, const bool dither) {
+  // little endian uint32 0xXXRRGGBB, 4 pixels at a time in gcc vector, saturating add of thresholds
+
+    typedef uint32_t v4u32 __attribute__ ((vector_size (16)));
+    typedef int32_t v4i32 __attribute__ ((vector_size (16)));
+
+    uint32_t thresholds = ditherRow (x, y, dither);
+    v4u32 d5 = { (thresholds & 0xFF) >> 1, ((thresholds >> 8) & 0xFF) >> 1,
+                 ((thresholds >> 16) & 0xFF) >> 1, (thresholds >> 24) >> 1 };
+    v4u32 d6 = d5 >> 1;
+
+    for (; num >= 4; num -= 4, dst += 4, src += 16) {
+      v4u32 pixels;
+      memcpy (&pixels, src, 16);
+
+      v4u32 r = ((pixels >> 16) & 0xFF) + d5;
+      v4u32 g = ((pixels >> 8) & 0xFF) + d6;
+      v4u32 b = (pixels & 0xFF) + d5;
+      r |= (v4u32)(v4i32)(r > 255);
+      g |= (v4u32)(v4i32)(g > 255);
+      b |= (v4u32)(v4i32)(b > 255);
+
+      v4u32 rgb = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | ((b & 0xFF) >> 3);
+      dst[0] = rgb[0];
+      dst[1] = rgb[1];
+      dst[2] = rgb[2];
+      dst[3] = rgb[3];
+      }
+
+    for (; num > 0; num--, dst++, src += 4) {
+      *dst = pack (src[2], src[1], src[0], thresholds & 0xFF);
+      thresholds = (thresholds >> 8) | (thresholds << 24);
+      }
+    }
+  //}}}
+  //{{{
+  static void yuv420Row (uint16_t* dst, const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow,
+                         int srcX, int num, const int x, const int y, const bool dither) {
+  // bt601 limited range, chroma shared by pixel pairs, srcX first luma column
+
+    uint32_t thresholds = ditherRow (x, y, dither);
+
+    for (; num > 0; num--, dst++, srcX++) {
+      int c = 298 * (yRow[srcX] - 16) + 128;
+      int d = uRow[srcX >> 1] - 128;
+      int e = vRow[srcX >> 1] - 128;
+
+      int r = (c + (409 * e)) >> 8;
+      int g = (c - (100 * d) - (208 * e)) >> 8;
+      int b = (c + (516 * d)) >> 8;
+
+      *dst = pack (r < 0 ? 0 : r, g < 0 ? 0 : g, b < 0 ? 0 : b, thresholds & 0xFF);
+      thresholds = (thresholds >> 8) | (thresholds << 24);
+      }
+    }
+  //}}}
+  };
+//}}}
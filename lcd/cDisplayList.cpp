@@ -0,0 +1,327 @@
+// cDisplayList.cpp
+#include "cDisplayList.h"
+#include "cLcd.h"
+#include "cSprite.h"
+
+#include <cstring>
+#include <math.h>
+
+using namespace std;
+
+// public
+//{{{
+cDisplayList::cDisplayList() {
+  mSpans = (sSpan*)malloc (kMaxDamageRects * sizeof(sSpan));
+  }
+//}}}
+//{{{
+cDisplayList::~cDisplayList() {
+  free (mSpans);
+  }
+//}}}
+
+//{{{
+void cDisplayList::begin() {
+// start submitting next frame, current commands become previous only if they were diffed
+
+  if (mDiffed) {
+    mCommands.swap (mPrevCommands);
+    mPoints.swap (mPrevPoints);
+    mDiffed = false;
+    }
+
+  mCommands.clear();
+  mPoints.clear();
+  mFirstPathPoint = 0;
+  }
+//}}}
+
+//{{{
+void cDisplayList::clear (const uint16_t colour) {
+  rect (colour, cRect (0,0, 0x7FFF,0x7FFF));
+  }
+//}}}
+//{{{
+void cDisplayList::rect (const uint16_t colour, const cRect& r) {
+  add (eRect, r).mColour[0] = colour;
+  }
+//}}}
+//{{{
+void cDisplayList::rect (const uint16_t colour, const uint8_t alpha, const cRect& r) {
+
+  sCommand& command = add (eRectAlpha, r);
+  command.mColour[0] = colour;
+  command.mAlpha = alpha;
+  }
+//}}}
+//{{{
+void cDisplayList::hGrad (const uint16_t colourL, const uint16_t colourR, const cRect& r) {
+
+  sCommand& command = add (eHGrad, r);
+  command.mColour[0] = colourL;
+  command.mColour[1] = colourR;
+  }
+//}}}
+//{{{
+void cDisplayList::vGrad (const uint16_t colourT, const uint16_t colourB, const cRect& r) {
+
+  sCommand& command = add (eVGrad, r);
+  command.mColour[0] = colourT;
+  command.mColour[1] = colourB;
+  }
+//}}}
+//{{{
+void cDisplayList::grad (const uint16_t colourTL ,const uint16_t colourTR,
+                         const uint16_t colourBL, const uint16_t colourBR, const cRect& r) {
+
+  sCommand& command = add (eGrad, r);
+  command.mColour[0] = colourTL;
+  command.mColour[1] = colourTR;
+  command.mColour[2] = colourBL;
+  command.mColour[3] = colourBR;
+  }
+//}}}
+//{{{
+void cDisplayList::radialGrad (const cPoint& centre, const int radius, const uint16_t colourIn, const uint16_t colourOut) {
+
+  sCommand& command = add (eRadialGrad, cRect (centre, centre));
+  command.mColour[0] = colourIn;
+  command.mColour[1] = colourOut;
+  command.mValue = radius;
+  }
+//}}}
+//{{{
+void cDisplayList::text (const uint16_t colour, const cPoint& p, const int height, const string& str) {
+
+  sCommand& command = add (eText, cRect (p, p));
+  command.mColour[0] = colour;
+  command.mValue = height;
+  command.mStr = str;
+  }
+//}}}
+//{{{
+void cDisplayList::blit (const cSprite& sprite, const cPoint& p) {
+// sprite compared by pointer, its pixels must not change while it is in a list
+  add (eBlit, cRect (p, p)).mSprite = &sprite;
+  }
+//}}}
+
+//{{{
+void cDisplayList::moveToAA (const cPointF& p) {
+  mPoints.push_back ({ p, true });
+  }
+//}}}
+//{{{
+void cDisplayList::lineToAA (const cPointF& p) {
+  mPoints.push_back ({ p, false });
+  }
+//}}}
+//{{{
+void cDisplayList::renderAA (const uint16_t colour, bool fillNonZero) {
+// path points since last renderAA become one command
+
+  sCommand& command = add (ePathAA, cRect());
+  command.mColour[0] = colour;
+  command.mValue = fillNonZero;
+  command.mFirstPoint = mFirstPathPoint;
+  command.mNumPoints = uint32_t(mPoints.size()) - mFirstPathPoint;
+
+  mFirstPathPoint = uint32_t(mPoints.size());
+  }
+//}}}
+
+//{{{
+sSpan* cDisplayList::diff (cLcd* lcd) {
+// return damage spans from commands added, removed or changed since previous frame, nullptr if none
+// - damage region collapses to its bounds if more than kMaxDamageRects
+// - commands compared in submission order, a changed command damages its old and new bounds
+// - unchanged commands inherit previous bounds, so text is only measured when it changes
+
+  mScreen = lcd->getRect();
+  mDamage.clear();
+  mDiffed = true;
+
+  if (mInvalid) {
+    // everything
+    for (auto& command : mCommands)
+      getBounds (lcd, command);
+    addDamage (mScreen);
+    mInvalid = false;
+    }
+
+  else {
+    size_t i = 0;
+    for (; i < mCommands.size(); i++) {
+      sCommand& command = mCommands[i];
+      if (i < mPrevCommands.size()) {
+        const sCommand& prevCommand = mPrevCommands[i];
+        if (isSame (command, prevCommand)) {
+          command.mBounds = prevCommand.mBounds;
+          continue;
+          }
+        addDamage (prevCommand.mBounds);
+        }
+      addDamage (getBounds (lcd, command));
+      }
+
+    // removed commands
+    for (; i < mPrevCommands.size(); i++)
+      addDamage (mPrevCommands[i].mBounds);
+    }
+
+  return mDamage.toSpans (mSpans, kMaxDamageRects);
+  }
+//}}}
+//{{{
+void cDisplayList::render (cLcd* lcd, const cRect& clip) {
+// render, in order, every command touching clip, lcd clip already set to clip
+
+  for (auto& command : mCommands) {
+    if (!command.mBounds.intersects (clip))
+      continue;
+
+    switch (command.mType) {
+      case eRect:
+        lcd->rect (command.mColour[0], command.mRect);
+        break;
+
+      case eRectAlpha:
+        lcd->rect (command.mColour[0], command.mAlpha, command.mRect);
+        break;
+
+      case eHGrad:
+        lcd->hGrad (command.mColour[0], command.mColour[1], command.mRect);
+        break;
+
+      case eVGrad:
+        lcd->vGrad (command.mColour[0], command.mColour[1], command.mRect);
+        break;
+
+      case eGrad:
+        lcd->grad (command.mColour[0], command.mColour[1], command.mColour[2], command.mColour[3], command.mRect);
+        break;
+
+      case eRadialGrad:
+        lcd->radialGrad (command.mRect.getTL(), command.mValue, command.mColour[0], command.mColour[1]);
+        break;
+
+      case eText:
+        lcd->text (command.mColour[0], command.mRect.getTL(), command.mValue, command.mStr);
+        break;
+
+      case eBlit:
+        lcd->blit (*command.mSprite, command.mRect.getTL());
+        break;
+
+      case ePathAA: {
+        const sPathPoint* point = mPoints.data() + command.mFirstPoint;
+        for (uint32_t i = 0; i < command.mNumPoints; i++, point++)
+          if (point->mMove)
+            lcd->moveToAA (point->mPoint);
+          else
+            lcd->lineToAA (point->mPoint);
+        lcd->renderAA (command.mColour[0], command.mValue);
+        break;
+        }
+      }
+    }
+  }
+//}}}
+
+// private
+//{{{
+cDisplayList::sCommand& cDisplayList::add (const eType type, const cRect& r) {
+
+  mCommands.push_back (sCommand());
+
+  sCommand& command = mCommands.back();
+  command.mType = type;
+  memset (command.mColour, 0, sizeof(command.mColour));
+  command.mAlpha = 0xFF;
+  command.mRect = r;
+  command.mValue = 0;
+  command.mSprite = nullptr;
+  command.mFirstPoint = 0;
+  command.mNumPoints = 0;
+  return command;
+  }
+//}}}
+//{{{
+bool cDisplayList::isSame (const sCommand& command, const sCommand& prevCommand) const {
+
+  if ((command.mType != prevCommand.mType) ||
+      memcmp (command.mColour, prevCommand.mColour, sizeof(command.mColour)) ||
+      (command.mAlpha != prevCommand.mAlpha) ||
+      !(command.mRect == prevCommand.mRect) ||
+      (command.mValue != prevCommand.mValue) ||
+      (command.mSprite != prevCommand.mSprite) ||
+      (command.mStr != prevCommand.mStr) ||
+      (command.mNumPoints != prevCommand.mNumPoints))
+    return false;
+
+  // compare aa path points
+  const sPathPoint* point = mPoints.data() + command.mFirstPoint;
+  const sPathPoint* prevPoint = mPrevPoints.data() + prevCommand.mFirstPoint;
+  for (uint32_t i = 0; i < command.mNumPoints; i++, point++, prevPoint++)
+    if ((point->mPoint.x != prevPoint->mPoint.x) ||
+        (point->mPoint.y != prevPoint->mPoint.y) ||
+        (point->mMove != prevPoint->mMove))
+      return false;
+
+  return true;
+  }
+//}}}
+//{{{
+cRect cDisplayList::getBounds (cLcd* lcd, sCommand& command) {
+// calc, cache and return command bounds, clipped to screen
+
+  switch (command.mType) {
+    case eRadialGrad:
+      command.mBounds = cRect (command.mRect.left - command.mValue, command.mRect.top - command.mValue,
+                               command.mRect.left + command.mValue, command.mRect.top + command.mValue);
+      break;
+
+    case eText:
+      command.mBounds = lcd->measureText (command.mRect.getTL(), command.mValue, command.mStr);
+      break;
+
+    case eBlit:
+      command.mBounds = cRect (command.mRect.getTL(), command.mRect.getTL() + command.mSprite->getSize());
+      break;
+
+    case ePathAA: {
+      // point bounds, aa coverage can touch pixel either side
+      command.mBounds = cRect();
+      if (command.mNumPoints) {
+        const sPathPoint* point = mPoints.data() + command.mFirstPoint;
+        float minx = point->mPoint.x;
+        float miny = point->mPoint.y;
+        float maxx = minx;
+        float maxy = miny;
+        for (uint32_t i = 1; i < command.mNumPoints; i++) {
+          point++;
+          minx = fminf (minx, point->mPoint.x);
+          miny = fminf (miny, point->mPoint.y);
+          maxx = fmaxf (maxx, point->mPoint.x);
+          maxy = fmaxf (maxy, point->mPoint.y);
+          }
+        command.mBounds = cRect (int16_t(floorf (minx)) - 1, int16_t(floorf (miny)) - 1,
+                                 int16_t(ceilf (maxx)) + 1, int16_t(ceilf (maxy)) + 1);
+        }
+      break;
+      }
+
+    default:
+      command.mBounds = command.mRect;
+      break;
+    }
+
+  command.mBounds = command.mBounds.intersect (mScreen);
+  return command.mBounds;
+  }
+//}}}
+//{{{
+void cDisplayList::addDamage (const cRect& r) {
+  mDamage.unite (r.intersect (mScreen));
+  }
+//}}}
@@ -0,0 +1,88 @@
+// cDisplayList.h - retained draw commands, damage from command changes between frames
+#pragma once
+#include <string>
+#include <vector>
+#include "cPointRect.h"
+#include "cRegion.h"
+
+class cLcd;
+class cSprite;
+
+class cDisplayList {
+public:
+  cDisplayList();
+  ~cDisplayList();
+
+  // submit, begin swaps current commands to previous
+  void begin();
+
+  void clear (const uint16_t colour);
+  void rect (const uint16_t colour, const cRect& r);
+  void rect (const uint16_t colour, const uint8_t alpha, const cRect& r);
+  void hGrad (const uint16_t colourL, const uint16_t colourR, const cRect& r);
+  void vGrad (const uint16_t colourT, const uint16_t colourB, const cRect& r);
+  void grad (const uint16_t colourTL ,const uint16_t colourTR,
+             const uint16_t colourBL, const uint16_t colourBR, const cRect& r);
+  void radialGrad (const cPoint& centre, const int radius, const uint16_t colourIn, const uint16_t colourOut);
+  void text (const uint16_t colour, const cPoint& p, const int height, const std::string& str);
+  void blit (const cSprite& sprite, const cPoint& p);
+
+  void moveToAA (const cPointF& p);
+  void lineToAA (const cPointF& p);
+  void renderAA (const uint16_t colour, bool fillNonZero);
+
+  // present
+  sSpan* diff (cLcd* lcd);
+  void render (cLcd* lcd, const cRect& clip);
+  void invalidate() { mInvalid = true; }
+
+private:
+  enum eType { eRect, eRectAlpha, eHGrad, eVGrad, eGrad, eRadialGrad, eText, eBlit, ePathAA };
+  //{{{
+  struct sCommand {
+    eType mType;
+    uint16_t mColour[4];
+    uint8_t mAlpha;
+    cRect mRect;
+    int mValue;
+
+    std::string mStr;
+    const cSprite* mSprite;
+
+    // ePathAA points in mPoints, mStr unused
+    uint32_t mFirstPoint;
+    uint32_t mNumPoints;
+
+    // calculated only for new or changed commands, else copied from previous
+    cRect mBounds;
+    };
+  //}}}
+  //{{{
+  struct sPathPoint {
+    cPointF mPoint;
+    bool mMove;
+    };
+  //}}}
+
+  sCommand& add (const eType type, const cRect& r);
+  bool isSame (const sCommand& command, const sCommand& prevCommand) const;
+  cRect getBounds (cLcd* lcd, sCommand& command);
+  void addDamage (const cRect& r);
+
+  static constexpr int kMaxDamageRects = 16;
+
+  // current and previous frame commands, with their aa path points
+  std::vector<sCommand> mCommands;
+  std::vector<sCommand> mPrevCommands;
+  std::vector<sPathPoint> mPoints;
+  std::vector<sPathPoint> mPrevPoints;
+  uint32_t mFirstPathPoint = 0;
+
+  bool mInvalid = true;
+  bool mDiffed = false;
+
+  // damage
+  cRect mScreen;
+  cRegion mDamage;
+  sSpan* mSpans = nullptr;
+  };
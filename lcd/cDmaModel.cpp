@@ -0,0 +1,375 @@
+// cDmaModel.cpp
+#include "cDmaModel.h"
+#include <cstdlib>
+#include <cstring>
+
+#include "../../shared/fmt/format.h"
+#include "../../shared/utils/cLog.h"
+
+using namespace std;
+using namespace fmt;
+
+// public
+//{{{
+cDmaModel::~cDmaModel() {
+
+  for (auto& mem : mMems)
+    ::free (mem.virt);
+  }
+//}}}
+
+//{{{
+bool cDmaModel::open (const int spiSpeed, const uint8_t rsGpio) {
+// rs hi, as on the pi
+
+  mRsGpio = rsGpio;
+  mRs = true;
+  return true;
+  }
+//}}}
+
+//{{{
+bool cDmaModel::alloc (sMem& mem, const uint32_t size) {
+// zeroed, page gap between allocations so overruns read unmapped
+
+  mem.size = (size + 4095) & ~4095;
+  mem.virt = (uint8_t*)aligned_alloc (4096, mem.size);
+  memset (mem.virt, 0, mem.size);
+  mem.bus = mNextBus;
+  mem.handle = (uint32_t)mMems.size() + 1;
+  mNextBus += mem.size + 4096;
+
+  mMems.push_back (mem);
+  return true;
+  }
+//}}}
+//{{{
+void cDmaModel::free (sMem& mem) {
+
+  for (auto it = mMems.begin(); it != mMems.end(); ++it)
+    if (it->virt == mem.virt) {
+      ::free (it->virt);
+      mMems.erase (it);
+      break;
+      }
+
+  mem = sMem();
+  }
+//}}}
+
+//{{{
+bool cDmaModel::service() {
+// run until nothing can move, false if a channel is still active then
+
+  sync();
+
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    for (int channel = 0; channel < kNumChannels; channel++)
+      progress |= step (channel);
+    while (shift())
+      progress = true;
+    }
+
+  for (int channel = 0; channel < kNumChannels; channel++)
+    if (mChannels[channel].running) {
+      error ("stalled, channel active at control block", mDmaRegs[channel][kDmaConblkAd]);
+      return false;
+      }
+
+  return true;
+  }
+//}}}
+
+// private
+//{{{
+void cDmaModel::error (const char* what, const uint32_t address) {
+
+  mNumErrors++;
+  if (mNumErrors <= 8)
+    cLog::log (LOGERROR, format ("dma model {} {:08x}", what, address));
+  }
+//}}}
+//{{{
+uint8_t* cDmaModel::getMem (const uint32_t bus, const uint32_t bytes) {
+
+  for (auto& mem : mMems)
+    if ((bus >= mem.bus) && (bus + bytes <= mem.bus + mem.size))
+      return mem.virt + (bus - mem.bus);
+
+  return nullptr;
+  }
+//}}}
+
+//{{{
+void cDmaModel::sync() {
+// pick up register writes the cpu made since last service
+
+  for (int channel = 0; channel < kNumChannels; channel++) {
+    volatile uint32_t* regs = mDmaRegs[channel];
+    if (regs[kDmaCs] & kDmaReset) {
+      mChannels[channel] = sChannel();
+      regs[kDmaCs] = 0;
+      regs[kDmaConblkAd] = 0;
+      }
+    else if ((regs[kDmaCs] & kDmaActive) && !mChannels[channel].running)
+      load (channel, regs[kDmaConblkAd]);
+    }
+
+  if (mSpiRegs[kSpiCs] & kSpiClear)
+    writeSpiCs (mSpiRegs[kSpiCs]);
+  }
+//}}}
+//{{{
+bool cDmaModel::step (const int channel) {
+// one beat of up to 4 bytes, false if idle or waiting on dreq
+
+  sChannel& ch = mChannels[channel];
+  if (!ch.running)
+    return false;
+
+  uint32_t beat = (ch.x < 4) ? ch.x : 4;
+  if (beat) {
+    uint32_t perMap = ch.ti & (0x1F << 16);
+    if (ch.ti & kDmaSrcDreq) {
+      if (perMap != kDmaPerMapSpiRx) {
+        error ("src dreq not spi rx", ch.src);
+        stop (channel);
+        return true;
+        }
+      if ((mRxFifo < beat) && (mRemaining || !mRxFifo))
+        return false;
+      }
+    if (ch.ti & kDmaDestDreq) {
+      if (perMap != kDmaPerMapSpiTx) {
+        error ("dest dreq not spi tx", ch.dst);
+        stop (channel);
+        return true;
+        }
+      if (mTxFifo.size() + 4 > kFifoBytes)
+        return false;
+      }
+
+    uint32_t value = (ch.ti & kDmaSrcIgnore) ? 0 : read (ch.src, beat);
+    if (!(ch.ti & kDmaDestIgnore))
+      write (ch.dst, value, beat);
+    if (!ch.running)
+      // stopped by an error, or reset by its own write
+      return true;
+
+    if (ch.ti & kDmaSrcInc)
+      ch.src += beat;
+    if (ch.ti & kDmaDestInc)
+      ch.dst += beat;
+    ch.x -= beat;
+    }
+
+  if (!ch.x) {
+    if (ch.rows > 1) {
+      // next 2d row
+      ch.rows--;
+      ch.x = ch.xLength;
+      ch.src += ch.srcStride;
+      ch.dst += ch.dstStride;
+      }
+    else if (ch.next)
+      load (channel, ch.next);
+    else
+      stop (channel);
+    }
+
+  return true;
+  }
+//}}}
+//{{{
+bool cDmaModel::shift() {
+// one byte out of tx fifo onto the wire, one dummy byte into rx fifo
+
+  if (!(mSpiRegs[kSpiCs] & kSpiTa) || !mRemaining || mTxFifo.empty() || (mRxFifo >= kFifoBytes))
+    return false;
+
+  uint8_t byte = mTxFifo.front();
+  mTxFifo.pop_front();
+  if (mRs)
+    mWire->data (&byte, 1);
+  else
+    mWire->command (byte);
+
+  mRxFifo++;
+  mNumBytes++;
+  if (!--mRemaining)
+    mSpiRegs[kSpiCs] |= kSpiDone;
+
+  return true;
+  }
+//}}}
+
+//{{{
+void cDmaModel::load (const int channel, const uint32_t controlBlock) {
+
+  volatile uint32_t* regs = mDmaRegs[channel];
+  sChannel& ch = mChannels[channel];
+
+  const sControlBlock* cb = (controlBlock & 31) ? nullptr : (const sControlBlock*)getMem (controlBlock, 32);
+  if (!cb) {
+    error ("control block unaligned or unmapped", controlBlock);
+    stop (channel);
+    return;
+    }
+
+  ch.running = true;
+  ch.ti = cb->ti;
+  ch.src = cb->src;
+  ch.dst = cb->dst;
+  ch.next = cb->next;
+  if (cb->ti & kDmaTdMode) {
+    if (channel >= kDmaFirstLite)
+      error ("2d mode on lite channel", controlBlock);
+    ch.xLength = cb->len & 0xFFFF;
+    ch.rows = ((cb->len >> 16) & 0x3FFF) + 1;
+    ch.srcStride = int16_t(cb->stride & 0xFFFF);
+    ch.dstStride = int16_t(cb->stride >> 16);
+    }
+  else {
+    ch.xLength = cb->len & 0x3FFFFFFF;
+    ch.rows = 1;
+    ch.srcStride = 0;
+    ch.dstStride = 0;
+    }
+  ch.x = ch.xLength;
+
+  regs[kDmaConblkAd] = controlBlock;
+  regs[kDmaCs] = (regs[kDmaCs] & ~kDmaEnd) | kDmaActive;
+  mNumControlBlocks++;
+  }
+//}}}
+//{{{
+void cDmaModel::stop (const int channel) {
+
+  volatile uint32_t* regs = mDmaRegs[channel];
+  mChannels[channel].running = false;
+  regs[kDmaCs] = (regs[kDmaCs] & ~kDmaActive) | kDmaEnd;
+  regs[kDmaConblkAd] = 0;
+  }
+//}}}
+//{{{
+uint32_t cDmaModel::read (const uint32_t address, const uint32_t bytes) {
+
+  if (address == kSpiBus + (kSpiFifo * 4)) {
+    // rx fifo, contents never looked at
+    mRxFifo -= (mRxFifo < bytes) ? mRxFifo : bytes;
+    return 0;
+    }
+
+  const uint8_t* mem = getMem (address, bytes);
+  if (!mem) {
+    error ("read unmapped", address);
+    return 0;
+    }
+
+  uint32_t value = 0;
+  memcpy (&value, mem, bytes);
+  return value;
+  }
+//}}}
+//{{{
+void cDmaModel::write (const uint32_t address, const uint32_t value, const uint32_t bytes) {
+
+  uint8_t* mem = getMem (address, bytes);
+  if (mem) {
+    memcpy (mem, &value, bytes);
+    return;
+    }
+
+  if (address == kSpiBus + (kSpiCs * 4))
+    writeSpiCs (value);
+
+  else if (address == kSpiBus + (kSpiFifo * 4))
+    writeFifo (value);
+
+  else if ((address == kGpioSet0Bus) || (address == kGpioClr0Bus)) {
+    if (value & (1u << mRsGpio)) {
+      if (mRemaining)
+        error ("rs changed with dlen bytes remaining", mRemaining);
+      mRs = address == kGpioSet0Bus;
+      }
+    }
+
+  else if ((address >= kDmaBus) && (address < kDmaBus + (kNumChannels * kDmaChannelBytes))) {
+    //{{{  dma channel register, conblk_ad or cs
+    int channel = (address - kDmaBus) / kDmaChannelBytes;
+    int reg = ((address - kDmaBus) % kDmaChannelBytes) / 4;
+    volatile uint32_t* regs = mDmaRegs[channel];
+
+    if (reg == kDmaConblkAd) {
+      if (mChannels[channel].running)
+        error ("conblk_ad written on active channel", address);
+      regs[kDmaConblkAd] = value;
+      }
+
+    else if (reg == kDmaCs) {
+      if (value & kDmaReset) {
+        mChannels[channel] = sChannel();
+        regs[kDmaCs] = 0;
+        regs[kDmaConblkAd] = 0;
+        }
+      else {
+        regs[kDmaCs] &= ~(value & kDmaEnd);
+        if ((value & kDmaActive) && !mChannels[channel].running)
+          load (channel, regs[kDmaConblkAd]);
+        }
+      }
+
+    else
+      error ("dma register not modelled", address);
+    }
+    //}}}
+
+  else
+    error ("write unmapped", address);
+  }
+//}}}
+//{{{
+void cDmaModel::writeSpiCs (const uint32_t value) {
+// clear bits empty fifos, not stored
+
+  if (value & (1 << 4))
+    mTxFifo.clear();
+  if (value & (1 << 5))
+    mRxFifo = 0;
+
+  if (!(value & kSpiTa) && mRemaining) {
+    error ("ta cleared with dlen bytes remaining", mRemaining);
+    mRemaining = 0;
+    }
+
+  mSpiRegs[kSpiCs] = value & ~kSpiClear;
+  }
+//}}}
+//{{{
+void cDmaModel::writeFifo (const uint32_t value) {
+// dma mode, first write with ta clear is the dlen and cs header, then data packed 4 bytes a word
+
+  const uint32_t cs = mSpiRegs[kSpiCs];
+  if (!(cs & kSpiDmaEn))
+    error ("fifo written without dmaen", value);
+
+  if (!(cs & kSpiTa)) {
+    mRemaining = value >> 16;
+    mSpiRegs[kSpiDlen] = mRemaining;
+    mSpiRegs[kSpiCs] = (cs & ~0xFFu & ~kSpiDone) | (value & 0xFF);
+    if (!(value & kSpiTa) || !mRemaining)
+      error ("header without ta or dlen", value);
+    return;
+    }
+
+  if (!mRemaining)
+    error ("fifo written after dlen bytes", value);
+  if (mTxFifo.size() + 4 > kFifoBytes)
+    error ("tx fifo overrun", value);
+
+  for (int i = 0; i < 4; i++)
+    mTxFifo.push_back (uint8_t(value >> (i * 8)));
+  }
+//}}}
@@ -0,0 +1,86 @@
+// cDmaModel.h - simulated dma controller, main spi and gpio set/clr, runs cLcdBusDmaSpi chains on the cpu
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include "cLcdBusDma.h"
+
+//{{{
+class cDmaModel : public cDmaHost {
+// - memory from the heap at made up bus addresses, registers plain words the bus writes as it would the soc
+// - service steps the channels a beat at a time, tx and rx paced by spi fifo dreq, spi shifting a byte at a time
+// - bytes on the wire go to a bus, command with rs lo, data with rs hi, a recorder compares them with any other bus
+// - protocol errors counted and the first few logged, unmapped or unaligned addresses, 2d on a lite channel,
+//   fifo overrun, data with ta clear, rs or ta changed while dlen bytes remain
+public:
+  cDmaModel (cLcdBus* wire) : mWire(wire) {}
+  virtual ~cDmaModel();
+
+  virtual const char* getName() const { return "model"; }
+  virtual bool open (const int spiSpeed, const uint8_t rsGpio);
+
+  virtual bool alloc (sMem& mem, const uint32_t size);
+  virtual void free (sMem& mem);
+
+  virtual volatile uint32_t* getDmaChannel (const int channel) { return mDmaRegs[channel]; }
+  virtual volatile uint32_t* getSpi() { return mSpiRegs; }
+
+  virtual bool service();
+
+  uint32_t getNumErrors() const { return mNumErrors; }
+  uint32_t getNumControlBlocks() const { return mNumControlBlocks; }
+  uint64_t getNumBytes() const { return mNumBytes; }
+
+private:
+  static constexpr int kNumChannels = 15;
+  static constexpr uint32_t kFifoBytes = 64;
+
+  //{{{
+  struct sChannel {
+    bool running = false;
+    uint32_t ti = 0;
+    uint32_t src = 0;
+    uint32_t dst = 0;
+    uint32_t xLength = 0;
+    uint32_t x = 0;
+    uint32_t rows = 0;
+    int32_t srcStride = 0;
+    int32_t dstStride = 0;
+    uint32_t next = 0;
+    };
+  //}}}
+
+  void error (const char* what, const uint32_t address);
+  uint8_t* getMem (const uint32_t bus, const uint32_t bytes);
+
+  void sync();
+  bool step (const int channel);
+  bool shift();
+
+  void load (const int channel, const uint32_t controlBlock);
+  void stop (const int channel);
+  uint32_t read (const uint32_t address, const uint32_t bytes);
+  void write (const uint32_t address, const uint32_t value, const uint32_t bytes);
+  void writeSpiCs (const uint32_t value);
+  void writeFifo (const uint32_t value);
+
+  cLcdBus* mWire;
+  uint8_t mRsGpio = 0;
+  bool mRs = true;
+
+  std::vector<sMem> mMems;
+  uint32_t mNextBus = 0xC0000000;
+
+  volatile uint32_t mDmaRegs[kNumChannels][kDmaChannelBytes / 4] = {};
+  sChannel mChannels[kNumChannels];
+
+  volatile uint32_t mSpiRegs[6] = {};
+  std::deque<uint8_t> mTxFifo;
+  uint32_t mRxFifo = 0;
+  uint32_t mRemaining = 0;
+
+  uint32_t mNumErrors = 0;
+  uint32_t mNumControlBlocks = 0;
+  uint64_t mNumBytes = 0;
+  };
+//}}}
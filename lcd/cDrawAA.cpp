@@ -1,5 +1,7 @@
 // cDrawAA.cpp
 #include "cDrawAA.h"
+#include "cBlend.h"
+#include "cFrameBuf.h"
 #include <cstring>
 #include <math.h>
 
@@ -7,11 +9,16 @@
 //#include "../shared/utils/cLog.h"
 //using namespace std;
 
+// render bands, each at least this many cells
+constexpr uint32_t kMinBandCells = 1024;
+
+// radix sort key ranges up to this, wider paths qsort
+constexpr uint32_t kMaxRadixKeys = 4096;
+
 // cDrawAA public
 //{{{
 cDrawAA::cDrawAA() {
 
-  mNumCellsInBlock = 2048;
   mScanLine = new cScanLine();
 
   for (unsigned i = 0; i < 256; i++)
@@ -23,21 +30,30 @@ cDrawAA::cDrawAA() {
 //{{{
 cDrawAA::~cDrawAA() {
 
-  free (mSortedCells);
+  stopThreads();
+  delete mScanLine;
+  }
+//}}}
 
-  if (mNumBlockOfCells) {
-    sCell** ptr = mBlockOfCells + mNumBlockOfCells - 1;
-    while (mNumBlockOfCells--) {
-      // free a block of cells
-      free (*ptr);
-      ptr--;
-      }
+//{{{
+void cDrawAA::setThreads (int numThreads) {
+// main thread plus numThreads - 1 workers, each waiting on start barrier for its band
 
-    // free pointers to blockOfCells
-    free (mBlockOfCells);
-    }
+  stopThreads();
 
-  delete mScanLine;
+  numThreads = numThreads < 1 ? 1 : numThreads > kMaxThreads ? kMaxThreads : numThreads;
+  if (numThreads == 1)
+    return;
+
+  pthread_barrier_init (&mStartBarrier, nullptr, numThreads);
+  pthread_barrier_init (&mDoneBarrier, nullptr, numThreads);
+  mNumThreads = numThreads;
+
+  for (int thread = 1; thread < numThreads; thread++) {
+    mWorkers[thread].drawAA = this;
+    mWorkers[thread].band = thread;
+    pthread_create (&mThreads[thread], nullptr, &bandThread, &mWorkers[thread]);
+    }
   }
 //}}}
 
@@ -56,27 +72,19 @@ void cDrawAA::moveTo (int32_t x, int32_t y) {
   mClosex = x;
   mCury = y;
   mClosey = y;
+  if (mClipping)
+    mClipFlags = getClipFlags (x, y);
   }
 //}}}
 //{{{
 void cDrawAA::lineTo (int32_t x, int32_t y) {
 
   if (mSortRequired && ((mCurx ^ x) | (mCury ^ y))) {
-    int c = mCurx >> 8;
-    if (c < mMinx)
-      mMinx = c;
-    ++c;
-    if (c > mMaxx)
-      mMaxx = c;
-
-    c = x >> 8;
-    if (c < mMinx)
-      mMinx = c;
-    ++c;
-    if (c > mMaxx)
-      mMaxx = c;
-
-    addLine (mCurx, mCury, x, y);
+    if (mClipping)
+      clipLine (mCurx, mCury, x, y);
+    else
+      addEdge (mCurx, mCury, x, y);
+
     mCurx = x;
     mCury = y;
     mClosed = false;
@@ -84,28 +92,156 @@ void cDrawAA::lineTo (int32_t x, int32_t y) {
   }
 //}}}
 //{{{
-void cDrawAA::render (const uint16_t colour, bool fillNonZero, uint16_t* frameBuf, uint16_t width, uint16_t height) {
+void cDrawAA::render (const uint16_t colour, bool fillNonZero, uint16_t* frameBuf, uint16_t width, const cRect& clip) {
 
-  const sCell* const* sortedCells = getSortedCells();
+  const sCell* cell = getSortedCells();
   uint32_t numCells = getNumCells();
   if (!numCells)
     return;
 
-  mScanLine->init (getMinx(), getMaxx());
+  // bands only when enough cells to pay for waking workers
+  uint32_t numBands = numCells / kMinBandCells;
+  if (numBands > (uint32_t)mNumThreads)
+    numBands = mNumThreads;
+
+  if (numBands > 1)
+    renderBands (numBands, colour, fillNonZero, frameBuf, width, clip);
+  else {
+    mScanLine->init (getMinx(), getMaxx(), mArena);
+    renderCells (mScanLine, cell, cell + numCells, colour, fillNonZero, frameBuf, width, clip);
+    }
+
+  // clear down for next time
+  init();
+  }
+//}}}
+
+//{{{
+bool cDrawAA::addStyle (const uint16_t colour, bool fillNonZero) {
+// following paths drawn in this style, false if styles full or unstyled paths added, renderCompound to flush
+
+  if (mNumStyles >= kMaxStyles)
+    return false;
+
+  // close and flush cell of previous style, cells never span styles
+  close();
+  addCurCell();
+  mCurCell.set (0x7FFF, 0x7FFF, 0, 0);
+
+  // cells before first style would take style 0, the colour of this style
+  if (!mNumStyles && mNumCells)
+    return false;
+
+  mStyle = mNumStyles++;
+  mStyles[mStyle] = { colour, fillNonZero };
+  return true;
+  }
+//}}}
+//{{{
+bool cDrawAA::renderCompound (uint16_t* frameBuf, uint16_t width, const cRect& clip) {
+// one sort for all styles, by row, then style, then x, so each row composites style by style,
+// each style's coverage carried across rows as render carries its single coverage
+// - false if cells added without any style were dropped unrendered
+
+  const sCell* cell = getSortedCells (true);
+  uint32_t numCells = getNumCells();
+  if (!numCells || !mNumStyles) {
+    init();
+    return !numCells;
+    }
+  const sCell* endCell = cell + numCells;
+
+  mScanLine->init (getMinx(), getMaxx(), mArena);
+
+  int* coverage = mArena.alloc<int> (mNumStyles);
+  memset (coverage, 0, mNumStyles * sizeof(int));
+
+  while (cell < endCell)
+    cell = renderStyleRow (cell, endCell, coverage[cell->mStyle], frameBuf, width, clip);
+
+  // clear down for next time
+  init();
+  return true;
+  }
+//}}}
+//{{{
+bool cDrawAA::renderCompoundNative (cNativeFrameBuf& frameBuf, const cRect& clip) {
+
+  mNative = &frameBuf;
+  bool rendered = renderCompound (nullptr, 0, clip);
+  mNative = nullptr;
+  return rendered;
+  }
+//}}}
+
+//{{{
+void cDrawAA::renderMask (bool fillNonZero, uint8_t* mask, const cRect& bounds) {
+// gamma corrected coverage into mask, bounds sized, rows of bounds width, for cMaskCache
+
+  mMask = mask;
+  mMaskBounds = bounds;
+  render (0, fillNonZero, nullptr, 0, bounds);
+  mMask = nullptr;
+  }
+//}}}
+//{{{
+void cDrawAA::renderNative (const uint16_t colour, bool fillNonZero, cNativeFrameBuf& frameBuf, const cRect& clip) {
+// gamma corrected coverage blended into native frameBuf rows, bands still split rows across threads
+
+  mNative = &frameBuf;
+  render (colour, fillNonZero, nullptr, 0, clip);
+  mNative = nullptr;
+  }
+//}}}
+
+//{{{
+void cDrawAA::setClipBox (const cRect& clip) {
+
+  mClipping = true;
+  mClipLeft = clip.left << 8;
+  mClipTop = clip.top << 8;
+  mClipRight = clip.right << 8;
+  mClipBottom = clip.bottom << 8;
+  mClipFlags = getClipFlags (mCurx, mCury);
+  }
+//}}}
+//{{{
+void cDrawAA::close() {
+
+  if (!mClosed) {
+    lineTo (mClosex, mClosey);
+    mClosed = true;
+    }
+  }
+//}}}
+//{{{
+cRect cDrawAA::getBounds() const {
+// pixel bounds of path added since last render, empty if none
+
+  if ((mMinx >= mMaxx) || (mMiny >= mMaxy))
+    return cRect();
+
+  return cRect (mMinx < -0x7FFF ? -0x7FFF : mMinx, mMiny < -0x7FFF ? -0x7FFF : mMiny,
+                mMaxx > 0x7FFF ? 0x7FFF : mMaxx, mMaxy > 0x7FFF ? 0x7FFF : mMaxy);
+  }
+//}}}
+
+// cDrawAA private
+//{{{
+void cDrawAA::renderCells (cScanLine* scanLine, const sCell* cell, const sCell* endCell,
+                           const uint16_t colour, bool fillNonZero, uint16_t* frameBuf, uint16_t width, const cRect& clip) {
+// spans of sorted cells, rows composited as they complete, coverage carried across rows sums to 0 at each row end
 
   int coverage = 0;
-  const sCell* cell = *sortedCells++;
   while (true) {
-    int x = cell->mPackedCoord & 0xFFFF;
-    int y = cell->mPackedCoord >> 16;
+    int x = cell->getX();
+    int y = cell->getY();
     int packedCoord = cell->mPackedCoord;
     int area = cell->mArea;
     coverage += cell->mCoverage;
 
     // accumulate all start cells
-    while ((cell = *sortedCells++) != 0) {
-      if (cell->mPackedCoord != packedCoord)
-        break;
+    for (++cell; (cell < endCell) && (cell->mPackedCoord == packedCoord); ++cell) {
       area += cell->mArea;
       coverage += cell->mCoverage;
       }
@@ -113,41 +249,110 @@ void cDrawAA::render (const uint16_t colour, bool fillNonZero, uint16_t* frameBu
     if (area) {
       uint8_t alpha = calcAlpha ((coverage << 9) - area, fillNonZero);
       if (alpha) {
-        if (mScanLine->isReady (y)) {
-          renderScanLine (colour, frameBuf, width, height);
-          mScanLine->initSpans();
+        if (scanLine->isReady (y)) {
+          renderScanLine (scanLine, colour, frameBuf, width, clip);
+          scanLine->initSpans();
           }
-        mScanLine->addSpan (x, y, 1, mGamma[alpha]);
+        scanLine->addSpan (x, y, 1, mGamma[alpha]);
         }
       x++;
       }
 
-    if (!cell)
+    if (cell == endCell)
       break;
 
-    if (int16_t(cell->mPackedCoord & 0xFFFF) > x) {
+    if (cell->getX() > x) {
       uint8_t alpha = calcAlpha (coverage << 9, fillNonZero);
       if (alpha) {
-        if (mScanLine->isReady (y)) {
-           renderScanLine (colour, frameBuf, width, height);
-           mScanLine->initSpans();
+        if (scanLine->isReady (y)) {
+           renderScanLine (scanLine, colour, frameBuf, width, clip);
+           scanLine->initSpans();
            }
-         mScanLine->addSpan (x, y, int16_t(cell->mPackedCoord & 0xFFFF) - x, mGamma[alpha]);
+         scanLine->addSpan (x, y, cell->getX() - x, mGamma[alpha]);
          }
       }
     }
 
-  if (mScanLine->getNumSpans())
-    renderScanLine (colour, frameBuf, width, height);
+  if (scanLine->getNumSpans())
+    renderScanLine (scanLine, colour, frameBuf, width, clip);
+  }
+//}}}
+//{{{
+void cDrawAA::renderBands (uint32_t numBands, const uint16_t colour, bool fillNonZero,
+                           uint16_t* frameBuf, uint16_t width, const cRect& clip) {
+// sorted cells split into bands of about equal cells, each extended to a whole row,
+// so bands write disjoint frameBuf rows, workers need no locks, main thread renders band 0
+
+  const sCell* cell = mSortedCells;
+  const sCell* endCell = cell + mNumCells;
+
+  const sCell* bandCell = cell;
+  for (uint32_t band = 0; band < (uint32_t)mNumThreads; band++) {
+    const sCell* bandEndCell = bandCell;
+    if (band < numBands) {
+      bandEndCell = (band == numBands - 1) ? endCell : cell + ((mNumCells * (band + 1)) / numBands);
+      if (bandEndCell < bandCell)
+        bandEndCell = bandCell;
+      while ((bandEndCell < endCell) && (bandEndCell > cell) && (bandEndCell->getY() == bandEndCell[-1].getY()))
+        bandEndCell++;
+      }
 
-  // clear down for next time
-  init();
+    // scanLine arrays from arena here, arena not touched by workers
+    mBands[band].cell = bandCell;
+    mBands[band].endCell = bandEndCell;
+    if (bandEndCell > bandCell)
+      mBands[band].scanLine.init (getMinx(), getMaxx(), mArena);
+    bandCell = bandEndCell;
+    }
+
+  mBandColour = colour;
+  mBandFillNonZero = fillNonZero;
+  mBandFrameBuf = frameBuf;
+  mBandWidth = width;
+  mBandClip = clip;
+
+  // barriers order band setup before workers and their rows before return
+  pthread_barrier_wait (&mStartBarrier);
+  renderBand (0);
+  pthread_barrier_wait (&mDoneBarrier);
+  }
+//}}}
+//{{{
+void cDrawAA::renderBand (int band) {
+
+  sBand& bandRef = mBands[band];
+  if (bandRef.endCell > bandRef.cell)
+    renderCells (&bandRef.scanLine, bandRef.cell, bandRef.endCell,
+                 mBandColour, mBandFillNonZero, mBandFrameBuf, mBandWidth, mBandClip);
+  }
+//}}}
+//{{{
+void cDrawAA::stopThreads() {
+
+  if (mNumThreads > 1) {
+    mExitThreads = true;
+    pthread_barrier_wait (&mStartBarrier);
+    for (int thread = 1; thread < mNumThreads; thread++)
+      pthread_join (mThreads[thread], nullptr);
+
+    pthread_barrier_destroy (&mStartBarrier);
+    pthread_barrier_destroy (&mDoneBarrier);
+    mExitThreads = false;
+    }
+
+  mNumThreads = 1;
   }
 //}}}
 
-// cDrawAA private
 //{{{
 void cDrawAA::init() {
+// arena reset releases cells, sorted cells and scanLine
+
+  mArena.reset();
+  mNumBlockOfCells = 0;
+
+  mNumStyles = 0;
+  mStyle = 0;
 
   mNumCells = 0;
   mCurCell.set (0x7FFF, 0x7FFF, 0, 0);
@@ -162,7 +367,7 @@ void cDrawAA::init() {
 //}}}
 
 //{{{
-const cDrawAA::sCell* const* cDrawAA::getSortedCells() {
+const cDrawAA::sCell* cDrawAA::getSortedCells (const bool byStyle) {
 
   if (!mClosed) {
     lineTo (mClosex, mClosey);
@@ -175,6 +380,7 @@ const cDrawAA::sCell* const* cDrawAA::getSortedCells() {
     if (mNumCells == 0)
       return 0;
 
+    mSortByStyle = byStyle && (mNumStyles > 1);
     sortCells();
     mSortRequired = false;
     }
@@ -187,20 +393,17 @@ const cDrawAA::sCell* const* cDrawAA::getSortedCells() {
 void cDrawAA::addCurCell() {
 
   if (mCurCell.mArea | mCurCell.mCoverage) {
-    if ((mNumCells % mNumCellsInBlock) == 0) {
+    if ((mNumCells % kNumCellsInBlock) == 0) {
       // use next block of sCells
-      uint32_t block = mNumCells / mNumCellsInBlock;
-      if (block >= mNumBlockOfCells) {
-        // allocate new block of sCells
-        mBlockOfCells = (sCell**)realloc (mBlockOfCells, (mNumBlockOfCells + 1) * sizeof(sCell*));
-        mBlockOfCells[mNumBlockOfCells] = (sCell*)malloc (mNumCellsInBlock * sizeof(sCell));
-        mNumBlockOfCells++;
-        //cLog::log (LOGINFO, "allocated new blockOfCells %d of %d", block, mNumBlockOfCells);
-        }
+      uint32_t block = mNumCells / kNumCellsInBlock;
+      if (block >= mNumBlockOfCells)
+        // allocate new block of sCells from arena
+        mBlockOfCells[mNumBlockOfCells++] = mArena.alloc<sCell> (kNumCellsInBlock);
       mCurCellPtr = mBlockOfCells[block];
       }
 
-    *mCurCellPtr++ = mCurCell;
+    *mCurCellPtr = mCurCell;
+    mCurCellPtr++->mStyle = mStyle;
     mNumCells++;
     }
   }
@@ -223,37 +426,106 @@ void cDrawAA::swapCells (cDrawAA::sCell** a, cDrawAA::sCell** b) {
 //}}}
 //{{{
 void cDrawAA::sortCells() {
+// sort cells by packedCoord into contiguous mSortedCells
+// - radix, two stable counting passes, x then y, when both key ranges are small
+// - sorting by style, stable style pass between x and y passes, each row's cells grouped by style
+// - else qsort pointers, then gather
 
   if (mNumCells == 0)
     return;
 
-  // allocate mSortedCells, a contiguous vector of sCell pointers
-  if (mNumCells > mNumSortedCells) {
-    mSortedCells = (sCell**)realloc (mSortedCells, (mNumCells + 1) * 4);
-    mNumSortedCells = mNumCells;
-    }
-
-  // point mSortedCells at sCells
-  sCell** blockPtr = mBlockOfCells;
-  sCell** sortedPtr = mSortedCells;
-  uint16_t numBlocks = mNumCells / mNumCellsInBlock;
-  while (numBlocks--) {
-    sCell* cellPtr = *blockPtr++;
-    unsigned cellInBlock = mNumCellsInBlock;
-    while (cellInBlock--)
+  // allocate contiguous sorted cells and qsort pointers
+  mSortedCells = mArena.alloc<sCell> (mNumCells);
+  mSortedCellPtrs = mArena.alloc<sCell*> (mNumCells + 1);
+
+  // point mSortedCellPtrs at sCells, find key ranges, packedCoord order is y then x
+  int32_t minY = 0x7FFFFFFF;
+  int32_t maxY = -0x7FFFFFFF;
+  int32_t minX = 0x7FFFFFFF;
+  int32_t maxX = -0x7FFFFFFF;
+
+  sCell** sortedPtr = mSortedCellPtrs;
+  for (uint32_t block = 0; block * kNumCellsInBlock < mNumCells; block++) {
+    sCell* cellPtr = mBlockOfCells[block];
+    uint32_t numCellsInBlock = mNumCells - (block * kNumCellsInBlock);
+    if (numCellsInBlock > kNumCellsInBlock)
+      numCellsInBlock = kNumCellsInBlock;
+
+    while (numCellsInBlock--) {
+      int32_t y = cellPtr->getY();
+      int32_t x = cellPtr->getX();
+      minY = y < minY ? y : minY;
+      maxY = y > maxY ? y : maxY;
+      minX = x < minX ? x : minX;
+      maxX = x > maxX ? x : maxX;
       *sortedPtr++ = cellPtr++;
+      }
     }
 
-  sCell* cellPtr = *blockPtr++;
-  unsigned cellInBlock = mNumCells % mNumCellsInBlock;
-  while (cellInBlock--)
-    *sortedPtr++ = cellPtr++;
+  // terminate mSortedCellPtrs with nullptr
+  *sortedPtr = nullptr;
 
-  // terminate mSortedCells with nullptr
-  mSortedCells[mNumCells] = nullptr;
+  uint32_t numY = maxY - minY + 1;
+  uint32_t numX = maxX - minX + 1;
+  if (mRadixSort && (numY <= kMaxRadixKeys) && (numX <= kMaxRadixKeys))
+    radixSortCells (minY, numY, minX, numX);
 
-  // sort it
-  qsortCells (mSortedCells, mNumCells);
+  else {
+    qsortCells (mSortedCellPtrs, mNumCells);
+    for (uint32_t i = 0; i < mNumCells; i++)
+      mSortedCells[i] = *mSortedCellPtrs[i];
+    }
+  }
+//}}}
+//{{{
+void cDrawAA::radixSortCells (int32_t minY, uint32_t numY, int32_t minX, uint32_t numX) {
+// counting sort by x from mSortedCellPtrs into mRadixCells, then stable by y into mSortedCells
+// - sorting by style, stable by style between them, buffers swapped to keep result in mSortedCells
+
+  mRadixCells = mArena.alloc<sCell> (mNumCells);
+  uint32_t numCounts = numX > numY ? numX : numY;
+  if (mSortByStyle && (mNumStyles > numCounts))
+    numCounts = mNumStyles;
+  mRadixCounts = mArena.alloc<uint32_t> (numCounts + 1);
+
+  // x pass, counts to start offsets
+  memset (mRadixCounts, 0, (numX + 1) * sizeof(uint32_t));
+  for (uint32_t i = 0; i < mNumCells; i++)
+    mRadixCounts[mSortedCellPtrs[i]->getX() - minX + 1]++;
+  for (uint32_t i = 1; i <= numX; i++)
+    mRadixCounts[i] += mRadixCounts[i-1];
+  for (uint32_t i = 0; i < mNumCells; i++) {
+    const sCell* cell = mSortedCellPtrs[i];
+    mRadixCells[mRadixCounts[cell->getX() - minX]++] = *cell;
+    }
+
+  sCell* from = mRadixCells;
+  sCell* to = mSortedCells;
+  if (mSortByStyle) {
+    // style pass
+    memset (mRadixCounts, 0, (mNumStyles + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < mNumCells; i++)
+      mRadixCounts[from[i].mStyle + 1]++;
+    for (uint32_t i = 1; i <= mNumStyles; i++)
+      mRadixCounts[i] += mRadixCounts[i-1];
+    for (uint32_t i = 0; i < mNumCells; i++)
+      to[mRadixCounts[from[i].mStyle]++] = from[i];
+
+    from = mSortedCells;
+    to = mRadixCells;
+    }
+
+  // y pass
+  memset (mRadixCounts, 0, (numY + 1) * sizeof(uint32_t));
+  for (uint32_t i = 0; i < mNumCells; i++)
+    mRadixCounts[from[i].getY() - minY + 1]++;
+  for (uint32_t i = 1; i <= numY; i++)
+    mRadixCounts[i] += mRadixCounts[i-1];
+  for (uint32_t i = 0; i < mNumCells; i++)
+    to[mRadixCounts[from[i].getY() - minY]++] = from[i];
+
+  mSortedCells = to;
+  mRadixCells = from;
   }
 //}}}
 //{{{
@@ -283,20 +555,20 @@ void cDrawAA::qsortCells (cDrawAA::sCell** start, unsigned numCells) {
       i = base + 1;
       j = limit - 1;
       // now ensure that *i <= *base <= *j
-      if ((*j)->mPackedCoord < (*i)->mPackedCoord)
+      if (lessCell (*j, *i))
         swapCells (i, j);
-      if ((*base)->mPackedCoord < (*i)->mPackedCoord)
+      if (lessCell (*base, *i))
         swapCells (base, i);
-      if ((*j)->mPackedCoord < (*base)->mPackedCoord)
+      if (lessCell (*j, *base))
         swapCells (base, j);
 
       while (true) {
         do {
           i++;
-          } while ((*i)->mPackedCoord < (*base)->mPackedCoord);
+          } while (lessCell (*i, *base));
         do {
           j--;
-          } while ((*base)->mPackedCoord < (*j)->mPackedCoord);
+          } while (lessCell (*base, *j));
         if ( i > j )
           break;
         swapCells (i, j);
@@ -322,7 +594,7 @@ void cDrawAA::qsortCells (cDrawAA::sCell** start, unsigned numCells) {
       i = j + 1;
 
       for (; i < limit; j = i, i++) {
-        for (; (*(j+1))->mPackedCoord < (*j)->mPackedCoord; j--) {
+        for (; lessCell (*(j+1), *j); j--) {
           swapCells (j + 1, j);
           if (j == base)
             break;
@@ -530,17 +802,66 @@ void cDrawAA::addLine (int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
 //}}}
 
 //{{{
-void cDrawAA::renderScanLine (const uint16_t colour, uint16_t* frameBuf, uint16_t width, uint16_t height) {
+const cDrawAA::sCell* cDrawAA::renderStyleRow (const sCell* cell, const sCell* endCell, int& coverage,
+                                              uint16_t* frameBuf, uint16_t width, const cRect& clip) {
+// spans of one row of one style's cells, as render, composited in style colour, return cell after them
+
+  int row = cell->getY();
+  uint32_t style = cell->mStyle;
+  const sStyle& rowStyle = mStyles[style];
+  mScanLine->initSpans();
+
+  // end of this row's cells of this style
+  const sCell* groupEnd = cell + 1;
+  while ((groupEnd < endCell) && (groupEnd->mStyle == style) && (groupEnd->getY() == row))
+    groupEnd++;
+
+  while (true) {
+    int x = cell->getX();
+    int packedCoord = cell->mPackedCoord;
+    int area = cell->mArea;
+    coverage += cell->mCoverage;
 
-  cScanLine* scanLine = mScanLine;
+    // accumulate all start cells
+    for (++cell; (cell < groupEnd) && (cell->mPackedCoord == packedCoord); ++cell) {
+      area += cell->mArea;
+      coverage += cell->mCoverage;
+      }
+
+    if (area) {
+      uint8_t alpha = calcAlpha ((coverage << 9) - area, rowStyle.mFillNonZero);
+      if (alpha)
+        mScanLine->addSpan (x, row, 1, mGamma[alpha]);
+      x++;
+      }
+
+    if (cell == groupEnd)
+      break;
+
+    if (cell->getX() > x) {
+      uint8_t alpha = calcAlpha (coverage << 9, rowStyle.mFillNonZero);
+      if (alpha)
+        mScanLine->addSpan (x, row, cell->getX() - x, mGamma[alpha]);
+      }
+    }
+
+  if (mScanLine->getNumSpans())
+    renderScanLine (mScanLine, rowStyle.mColour, frameBuf, width, clip);
+
+  return cell;
+  }
+//}}}
+//{{{
+void cDrawAA::renderScanLine (cScanLine* scanLine, const uint16_t colour, uint16_t* frameBuf, uint16_t width,
+                              const cRect& clip) {
 
   // clip top
   auto y = scanLine->getY();
-  if (y < 0)
+  if (y < clip.top)
     return;
 
   // clip bottom
-  if (y >= height)
+  if (y >= clip.bottom)
     return;
 
   int baseX = scanLine->getBaseX();
@@ -553,48 +874,211 @@ void cDrawAA::renderScanLine (const uint16_t colour, uint16_t* frameBuf, uint16_
 
     // clip left
     int16_t numPix = span.getNumPix();
-    if (p.x < 0) {
-      numPix += p.x;
+    if (p.x < clip.left) {
+      numPix -= clip.left - p.x;
       if (numPix <= 0)
         continue;
-      coverage -= p.x;
-      p.x = 0;
+      coverage += clip.left - p.x;
+      p.x = clip.left;
       }
 
     // clip right
-    if (p.x + numPix >= width) {
-      numPix = width - p.x;
+    if (p.x + numPix >= clip.right) {
+      numPix = clip.right - p.x;
       if (numPix <= 0)
         continue;
       }
 
-    uint16_t* ptr = frameBuf + (p.y * width) + p.x;
-    for (uint16_t i = 0; i < numPix; i++) {
-      // inline pix without clip and better ptr usage
-      uint8_t alpha = *coverage++;
-      if (alpha == 0xFF)
-        // simple case - set frameBuf pixel to colour
-        *ptr++ = colour;
-      else {
-        // get colour
-        uint32_t fore = colour;
-        fore = (fore | (fore << 16)) & 0x07e0f81f;
-
-        // get frameBuf back, composite and write back
-        uint32_t back = *ptr;
-        back = (back | (back << 16)) & 0x07e0f81f;
-        back += (((fore - back) * ((alpha + 4) >> 3)) >> 5) & 0x07e0f81f;
-        back |= back >> 16;
-        *ptr++ = back;
-        }
-      }
-
+    if (mMask)
+      // rendering mask, spans never overlap within a render, so copied
+      memcpy (mMask + ((p.y - mMaskBounds.top) * (mMaskBounds.right - mMaskBounds.left)) + p.x - mMaskBounds.left,
+              coverage, numPix);
+    else if (mNative)
+      mNative->maskRow (colour, p.x, p.y, coverage, numPix);
+    else
+      // coverage already gamma corrected, full runs filled, partial blended by cBlend
+      cBlend::maskRow (frameBuf + (p.y * width) + p.x, colour, coverage, numPix);
     } while (--numSpans);
   }
 //}}}
 
+//{{{
+void cDrawAA::addEdge (int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+// edge cells, start cell set in case clipping broke continuity with previous edge
+
+  int c = x1 >> 8;
+  if (c < mMinx)
+    mMinx = c;
+  ++c;
+  if (c > mMaxx)
+    mMaxx = c;
+
+  c = x2 >> 8;
+  if (c < mMinx)
+    mMinx = c;
+  ++c;
+  if (c > mMaxx)
+    mMaxx = c;
+
+  setCurCell (x1 >> 8, y1 >> 8);
+  addLine (x1, y1, x2, y2);
+  }
+//}}}
+
+//{{{
+uint32_t cDrawAA::getClipFlags (int32_t x, int32_t y) const {
+// 1 right, 2 below, 4 left, 8 above
+
+  return (x > mClipRight) | ((y > mClipBottom) << 1) | ((x < mClipLeft) << 2) | ((y < mClipTop) << 3);
+  }
+//}}}
+//{{{
+uint32_t cDrawAA::getClipFlagsY (int32_t y) const {
+
+  return ((y > mClipBottom) << 1) | ((y < mClipTop) << 3);
+  }
+//}}}
+//{{{
+void cDrawAA::clipLine (int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+// split at left, right of box, parts beyond moved onto box edge as vertical edges, then clipped in y
+// - parts right of box still added, their coverage returns each row to 0 for the next
+
+  uint32_t f1 = mClipFlags;
+  uint32_t f2 = getClipFlags (x2, y2);
+  mClipFlags = f2;
+
+  // both above or both below, invisible
+  if (((f1 & 10) == (f2 & 10)) && (f1 & 10))
+    return;
+
+  //{{{
+  auto yAtX = [&](int32_t x) {
+    return y1 + (int32_t)((int64_t(x - x1) * (y2 - y1)) / (x2 - x1));
+    };
+  //}}}
+
+  int32_t y3;
+  int32_t y4;
+  switch (((f1 & 5) << 1) | (f2 & 5)) {
+    case 0: // inside x
+      clipLineY (x1, y1, x2, y2, f1, f2);
+      break;
+
+    case 1: // x2 right
+      y3 = yAtX (mClipRight);
+      clipLineY (x1, y1, mClipRight, y3, f1, getClipFlagsY (y3));
+      clipLineY (mClipRight, y3, mClipRight, y2, getClipFlagsY (y3), f2);
+      break;
+
+    case 2: // x1 right
+      y3 = yAtX (mClipRight);
+      clipLineY (mClipRight, y1, mClipRight, y3, f1, getClipFlagsY (y3));
+      clipLineY (mClipRight, y3, x2, y2, getClipFlagsY (y3), f2);
+      break;
+
+    case 3: // both right
+      clipLineY (mClipRight, y1, mClipRight, y2, f1, f2);
+      break;
+
+    case 4: // x2 left
+      y3 = yAtX (mClipLeft);
+      clipLineY (x1, y1, mClipLeft, y3, f1, getClipFlagsY (y3));
+      clipLineY (mClipLeft, y3, mClipLeft, y2, getClipFlagsY (y3), f2);
+      break;
+
+    case 6: // x1 right, x2 left
+      y3 = yAtX (mClipRight);
+      y4 = yAtX (mClipLeft);
+      clipLineY (mClipRight, y1, mClipRight, y3, f1, getClipFlagsY (y3));
+      clipLineY (mClipRight, y3, mClipLeft, y4, getClipFlagsY (y3), getClipFlagsY (y4));
+      clipLineY (mClipLeft, y4, mClipLeft, y2, getClipFlagsY (y4), f2);
+      break;
+
+    case 8: // x1 left
+      y3 = yAtX (mClipLeft);
+      clipLineY (mClipLeft, y1, mClipLeft, y3, f1, getClipFlagsY (y3));
+      clipLineY (mClipLeft, y3, x2, y2, getClipFlagsY (y3), f2);
+      break;
+
+    case 9: // x1 left, x2 right
+      y3 = yAtX (mClipLeft);
+      y4 = yAtX (mClipRight);
+      clipLineY (mClipLeft, y1, mClipLeft, y3, f1, getClipFlagsY (y3));
+      clipLineY (mClipLeft, y3, mClipRight, y4, getClipFlagsY (y3), getClipFlagsY (y4));
+      clipLineY (mClipRight, y4, mClipRight, y2, getClipFlagsY (y4), f2);
+      break;
+
+    case 12: // both left
+      clipLineY (mClipLeft, y1, mClipLeft, y2, f1, f2);
+      break;
+    }
+  }
+//}}}
+//{{{
+void cDrawAA::clipLineY (int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t f1, uint32_t f2) {
+// clip to top, bottom of box, rows outside get no cells
+
+  f1 &= 10;
+  f2 &= 10;
+  if (!(f1 | f2)) {
+    addEdge (x1, y1, x2, y2);
+    return;
+    }
+
+  if (f1 == f2)
+    return;
+
+  //{{{
+  auto xAtY = [&](int32_t y) {
+    return x1 + (int32_t)((int64_t(y - y1) * (x2 - x1)) / (y2 - y1));
+    };
+  //}}}
+
+  int32_t tx1 = x1;
+  int32_t ty1 = y1;
+  int32_t tx2 = x2;
+  int32_t ty2 = y2;
+  if (f1 & 8) {
+    tx1 = xAtY (mClipTop);
+    ty1 = mClipTop;
+    }
+  else if (f1 & 2) {
+    tx1 = xAtY (mClipBottom);
+    ty1 = mClipBottom;
+    }
+
+  if (f2 & 8) {
+    tx2 = xAtY (mClipTop);
+    ty2 = mClipTop;
+    }
+  else if (f2 & 2) {
+    tx2 = xAtY (mClipBottom);
+    ty2 = mClipBottom;
+    }
+
+  addEdge (tx1, ty1, tx2, ty2);
+  }
+//}}}
+
 // cDrawAA private static
 //{{{
+void* cDrawAA::bandThread (void* arg) {
+
+  sWorker* worker = (sWorker*)arg;
+  cDrawAA* drawAA = worker->drawAA;
+
+  while (true) {
+    pthread_barrier_wait (&drawAA->mStartBarrier);
+    if (drawAA->mExitThreads)
+      break;
+    drawAA->renderBand (worker->band);
+    pthread_barrier_wait (&drawAA->mDoneBarrier);
+    }
+
+  return nullptr;
+  }
+//}}}
+//{{{
 uint8_t cDrawAA::calcAlpha (int area, bool fillNonZero) {
 
   int coverage = area >> 9;
@@ -616,14 +1100,6 @@ uint8_t cDrawAA::calcAlpha (int area, bool fillNonZero) {
 
 // cDrawAA::cScanline
 //{{{
-cDrawAA::cScanLine::~cScanLine() {
-
-  free (mCounts);
-  free (mStartPtrs);
-  free (mCoverage);
-  }
-//}}}
-//{{{
 void cDrawAA::cScanLine::initSpans() {
 
   mNumSpans = 0;
@@ -636,21 +1112,13 @@ void cDrawAA::cScanLine::initSpans() {
   }
 //}}}
 //{{{
-void cDrawAA::cScanLine::init (int16_t minx, int16_t maxx) {
+void cDrawAA::cScanLine::init (int16_t minx, int16_t maxx, cArena& arena) {
+// arrays from arena, released with it after render
 
   uint16_t maxLen = maxx - minx + 2;
-  if (maxLen > mMaxlen) {
-    // increase allocations
-    mMaxlen = maxLen;
-
-    free (mStartPtrs);
-    free (mCounts);
-    free (mCoverage);
-
-    mCoverage = (uint8_t*)malloc (maxLen);
-    mCounts = (uint16_t*)malloc (maxLen * 2);
-    mStartPtrs = (uint8_t**)malloc (maxLen * 4);
-    }
+  mCoverage = arena.alloc<uint8_t> (maxLen);
+  mCounts = arena.alloc<uint16_t> (maxLen);
+  mStartPtrs = arena.alloc<uint8_t*> (maxLen);
 
   mMinx = minx;
   initSpans();
@@ -1,6 +1,10 @@
 // cDrawAA - anti aliased drawing
 #pragma once
+#include <pthread.h>
 #include "cPointRect.h"
+#include "cArena.h"
+
+class cNativeFrameBuf;
 
 class cDrawAA {
 public:
@@ -9,7 +13,35 @@ public:
 
   void moveTo (int32_t x, int32_t y);
   void lineTo (int32_t x, int32_t y);
-  void render (const uint16_t colour, bool fillNonZero, uint16_t* frameBuf, uint16_t width, uint16_t height);
+  void render (const uint16_t colour, bool fillNonZero, uint16_t* frameBuf, uint16_t width, const cRect& clip);
+  void renderMask (bool fillNonZero, uint8_t* mask, const cRect& bounds);
+  void renderNative (const uint16_t colour, bool fillNonZero, cNativeFrameBuf& frameBuf, const cRect& clip);
+
+  // compound, paths after each addStyle take its style, renderCompound sorts all cells once,
+  // then composites each scanline style by style in the order added
+  // - paths before first addStyle have no style, addStyle refuses until renderCompound drops them
+  bool addStyle (const uint16_t colour, bool fillNonZero);
+  bool renderCompound (uint16_t* frameBuf, uint16_t width, const cRect& clip);
+  bool renderCompoundNative (cNativeFrameBuf& frameBuf, const cRect& clip);
+
+  // close open path, its closing edge clipped like any other, so getBounds then covers it
+  void close();
+  cRect getBounds() const;
+
+  // drop paths and styles added since last render, without rendering them
+  void discard() { init(); }
+
+  // clip box, segments clipped as added, invisible above and below dropped,
+  // beyond left or right kept as vertical edges on the box, so winding inside is unchanged
+  void setClipBox (const cRect& clip);
+  void resetClipBox() { mClipping = false; }
+
+  // band parallel render, sorted cells split by rows across numThreads, 1 renders on caller only
+  void setThreads (int numThreads);
+  int getThreads() const { return mNumThreads; }
+
+  // cell sort, radix by default, qsort kept for comparison
+  void setRadixSort (const bool radixSort) { mRadixSort = radixSort; }
 
 private:
   //{{{
@@ -38,9 +70,20 @@ private:
       }
     //}}}
 
+    // packed (y << 16) + x, int order is y then x, y recovered with x's borrow undone
+    int getX() const { return int16_t(mPackedCoord & 0xFFFF); }
+    int getY() const { return (mPackedCoord + 0x8000) >> 16; }
+
     int32_t mPackedCoord;
     int32_t mCoverage;
     int32_t mArea;
+    uint32_t mStyle;
+    };
+  //}}}
+  //{{{
+  struct sStyle {
+    uint16_t mColour;
+    bool mFillNonZero;
     };
   //}}}
   //{{{
@@ -70,7 +113,6 @@ private:
     friend class iterator;
 
     cScanLine() {}
-    ~cScanLine();
 
     int16_t getY() const { return mLastY; }
     int16_t getBaseX() const { return mMinx;  }
@@ -78,12 +120,11 @@ private:
     int isReady (int16_t y) const { return mNumSpans && (y ^ mLastY); }
 
     void initSpans();
-    void init (int16_t minx, int16_t maxx);
+    void init (int16_t minx, int16_t maxx, cArena& arena);
     void addSpan (int16_t x, int16_t y, uint16_t num, uint16_t coverage);
 
   private:
     int16_t mMinx = 0;
-    uint16_t mMaxlen = 0;
     int16_t mLastX = 0x7FFF;
     int16_t mLastY = 0x7FFF;
 
@@ -107,27 +148,73 @@ private:
   int32_t getMaxx() const { return mMaxx; }
   int32_t getMaxy() const { return mMaxy; }
   uint16_t getNumCells() const { return mNumCells; }
-  const sCell* const* getSortedCells();
+  const sCell* getSortedCells (const bool byStyle = false);
 
   void addCurCell();
   void setCurCell (int16_t x, int16_t y);
   void swapCells (sCell** a, sCell** b);
+  //{{{
+  bool lessCell (const sCell* a, const sCell* b) const {
+  // packedCoord order, or row, style, x order if sorting by style
+
+    if (!mSortByStyle)
+      return a->mPackedCoord < b->mPackedCoord;
+
+    int64_t keyA = (int64_t(a->getY()) << 32) | (a->mStyle << 16) | (a->getX() + 0x8000);
+    int64_t keyB = (int64_t(b->getY()) << 32) | (b->mStyle << 16) | (b->getX() + 0x8000);
+    return keyA < keyB;
+    }
+  //}}}
   void sortCells();
+  void radixSortCells (int32_t minY, uint32_t numY, int32_t minX, uint32_t numX);
   void qsortCells (sCell** start, unsigned numCells);
 
   void addScanLine (int32_t ey, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
   void addLine (int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+  void addEdge (int32_t x1, int32_t y1, int32_t x2, int32_t y2);
 
-  void renderScanLine (const uint16_t colour, uint16_t* frameBuf, uint16_t width, uint16_t height);
+  uint32_t getClipFlags (int32_t x, int32_t y) const;
+  uint32_t getClipFlagsY (int32_t y) const;
+  void clipLine (int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+  void clipLineY (int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t f1, uint32_t f2);
+
+  const sCell* renderStyleRow (const sCell* cell, const sCell* endCell, int& coverage,
+                               uint16_t* frameBuf, uint16_t width, const cRect& clip);
+  void renderScanLine (cScanLine* scanLine, const uint16_t colour, uint16_t* frameBuf, uint16_t width,
+                       const cRect& clip);
+  void renderCells (cScanLine* scanLine, const sCell* cell, const sCell* endCell,
+                    const uint16_t colour, bool fillNonZero, uint16_t* frameBuf, uint16_t width, const cRect& clip);
+  void renderBands (uint32_t numBands, const uint16_t colour, bool fillNonZero,
+                    uint16_t* frameBuf, uint16_t width, const cRect& clip);
+  void renderBand (int band);
+  void stopThreads();
+  static void* bandThread (void* arg);
 
   static uint8_t calcAlpha (int area, bool fillNonZero);
 
   //{{{  vars
-  uint16_t mNumCellsInBlock = 0;
+  // all temporaries from arena, reset after each render, sized to high water mark
+  cArena mArena { 0x10000 };
+
+  // blocks of cells, numCells limits cells to 0x10000
+  static constexpr uint16_t kNumCellsInBlock = 2048;
+  static constexpr uint16_t kMaxBlockOfCells = 0x10000 / kNumCellsInBlock;
   uint16_t mNumBlockOfCells = 0;
-  uint16_t mNumSortedCells = 0;
-  sCell** mBlockOfCells = nullptr;
-  sCell** mSortedCells = nullptr;
+  sCell* mBlockOfCells[kMaxBlockOfCells];
+
+  // sorted cells contiguous, radix pass temp, qsort pointers, radix counts
+  bool mRadixSort = true;
+  bool mSortByStyle = false;
+  sCell* mSortedCells = nullptr;
+  sCell* mRadixCells = nullptr;
+  sCell** mSortedCellPtrs = nullptr;
+  uint32_t* mRadixCounts = nullptr;
+
+  // compound styles, cells carry index of style current when added
+  static constexpr uint16_t kMaxStyles = 256;
+  uint16_t mNumStyles = 0;
+  uint16_t mStyle = 0;
+  sStyle mStyles[kMaxStyles];
 
   uint16_t mNumCells;
   sCell mCurCell;
@@ -146,6 +233,50 @@ private:
   bool mClosed;
   bool mSortRequired;
 
+  // clip box 24.8, flags of current point
+  bool mClipping = false;
+  int32_t mClipLeft = 0;
+  int32_t mClipTop = 0;
+  int32_t mClipRight = 0;
+  int32_t mClipBottom = 0;
+  uint32_t mClipFlags = 0;
+
+  // band threads, band 0 on caller, others each on own worker, render params shared read only
+  static constexpr int kMaxThreads = 8;
+  //{{{
+  struct sBand {
+    const sCell* cell;
+    const sCell* endCell;
+    cScanLine scanLine;
+    };
+  //}}}
+  //{{{
+  struct sWorker {
+    cDrawAA* drawAA;
+    int band;
+    };
+  //}}}
+  int mNumThreads = 1;
+  bool mExitThreads = false;
+  pthread_t mThreads[kMaxThreads];
+  sWorker mWorkers[kMaxThreads];
+  pthread_barrier_t mStartBarrier;
+  pthread_barrier_t mDoneBarrier;
+  sBand mBands[kMaxThreads];
+
+  uint16_t mBandColour = 0;
+  bool mBandFillNonZero = true;
+  uint16_t* mBandFrameBuf = nullptr;
+  uint16_t mBandWidth = 0;
+  cRect mBandClip;
+
+  // renderMask target, coverage copied instead of blended
+  uint8_t* mMask = nullptr;
+  cRect mMaskBounds;
+
+  // renderNative target, coverage blended in its pixel format
+  cNativeFrameBuf* mNative = nullptr;
+
   uint8_t mGamma[256];
   cScanLine* mScanLine = nullptr;
   //}}}
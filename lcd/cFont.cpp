@@ -0,0 +1,139 @@
+// cFont.cpp
+#include "cFont.h"
+#include <cstdlib>
+#include "cDrawAA.h"
+#include "cPath.h"
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "../stb_truetype/stb_truetype.h"
+
+using namespace std;
+
+// public
+//{{{
+cFont::cFont (const uint8_t* font, const int fontSize) {
+// fontinfo only indexes font tables, no glyph parsed until used
+
+  stbtt_fontinfo* info = (stbtt_fontinfo*)malloc (sizeof(stbtt_fontinfo));
+  mInfo = info;
+
+  mOk = (fontSize > 0) && stbtt_InitFont (info, font, stbtt_GetFontOffsetForIndex (font, 0));
+  if (mOk)
+    // em sized as FreeType pixel sizes, height pixels to the em
+    mEmScale = stbtt_ScaleForMappingEmToPixels (info, 1.f);
+  }
+//}}}
+//{{{
+cFont::~cFont() {
+
+  for (auto& glyph : mGlyphs)
+    free (glyph.second);
+
+  free (mInfo);
+  }
+//}}}
+
+//{{{
+const cFont::sGlyph* cFont::getGlyph (const uint32_t codepoint) {
+// outline parsed on first use, header and vertices in one allocation
+
+  auto it = mGlyphs.find (codepoint);
+  if (it != mGlyphs.end())
+    return it->second;
+
+  stbtt_fontinfo* info = (stbtt_fontinfo*)mInfo;
+  int index = stbtt_FindGlyphIndex (info, codepoint);
+
+  stbtt_vertex* vertices = nullptr;
+  int numVertices = mOk ? stbtt_GetGlyphShape (info, index, &vertices) : 0;
+
+  sGlyph* glyph = (sGlyph*)malloc (sizeof(sGlyph) + (numVertices * sizeof(sVertex)));
+  glyph->numVertices = numVertices;
+  glyph->vertices = (sVertex*)(glyph + 1);
+
+  int advance = 0;
+  int leftSideBearing = 0;
+  if (mOk)
+    stbtt_GetGlyphHMetrics (info, index, &advance, &leftSideBearing);
+  glyph->advance = advance * mEmScale;
+
+  // font units y up to em units y down
+  int x0 = 0;
+  int y0 = 0;
+  int x1 = 0;
+  int y1 = 0;
+  if (numVertices)
+    stbtt_GetGlyphBox (info, index, &x0, &y0, &x1, &y1);
+  glyph->topLeft = cPointF (x0 * mEmScale, -y1 * mEmScale);
+  glyph->bottomRight = cPointF (x1 * mEmScale, -y0 * mEmScale);
+
+  for (int i = 0; i < numVertices; i++) {
+    sVertex& vertex = glyph->vertices[i];
+    vertex.type = vertices[i].type;
+    vertex.p = cPointF (vertices[i].x * mEmScale, -vertices[i].y * mEmScale);
+    vertex.c = cPointF (vertices[i].cx * mEmScale, -vertices[i].cy * mEmScale);
+    vertex.c1 = cPointF (vertices[i].cx1 * mEmScale, -vertices[i].cy1 * mEmScale);
+    }
+  stbtt_FreeShape (info, vertices);
+
+  mGlyphs[codepoint] = glyph;
+  return glyph;
+  }
+//}}}
+//{{{
+uint8_t* cFont::getSdf (const uint32_t codepoint, const float emPixels, const int padding, const uint8_t onEdge,
+                        const float distScale, int& width, int& height, int& left, int& top) {
+// signed distance field of glyph at emPixels, onEdge on outline, distScale per pixel inside, padding beyond box,
+// malloced, caller frees, nullptr if glyph empty
+
+  width = 0;
+  height = 0;
+  left = 0;
+  top = 0;
+  if (!mOk)
+    return nullptr;
+
+  return stbtt_GetCodepointSDF ((stbtt_fontinfo*)mInfo, stbtt_ScaleForMappingEmToPixels ((stbtt_fontinfo*)mInfo, emPixels),
+                                codepoint, padding, onEdge, distScale, &width, &height, &left, &top);
+  }
+//}}}
+//{{{
+void cFont::addGlyph (cDrawAA& drawAA, const sGlyph* glyph, const cPointF& origin, const float height,
+                      const float cosA, const float sinA, const float tolerance, const float stretchX) const {
+// outline scaled to height, rotated by angle of cosA, sinA about its baseline origin, curves flattened in pixels
+// - stretchX scales x after rotation, 3 rasterises subpixel glyphs, origin then in stretched units
+
+  //{{{
+  auto transform = [&](const cPointF& p) {
+    return cPointF (origin.x + (((p.x * cosA) - (p.y * sinA)) * height * stretchX),
+                    origin.y + (((p.x * sinA) + (p.y * cosA)) * height));
+    };
+  //}}}
+  //{{{
+  auto lineTo = [&](const cPointF& p) {
+    drawAA.lineTo (cPath::toFixed (p.x), cPath::toFixed (p.y));
+    };
+  //}}}
+
+  cPointF last;
+  for (int i = 0; i < glyph->numVertices; i++) {
+    const sVertex& vertex = glyph->vertices[i];
+    cPointF p = transform (vertex.p);
+    switch (vertex.type) {
+      case STBTT_vmove:
+        drawAA.moveTo (cPath::toFixed (p.x), cPath::toFixed (p.y));
+        break;
+      case STBTT_vline:
+        lineTo (p);
+        break;
+      case STBTT_vcurve:
+        cPath::flattenQuad (last, transform (vertex.c), p, tolerance, lineTo);
+        break;
+      case STBTT_vcubic:
+        cPath::flattenCubic (last, transform (vertex.c), transform (vertex.c1), p, tolerance, lineTo);
+        break;
+      }
+    last = p;
+    }
+  }
+//}}}
@@ -0,0 +1,54 @@
+// cFont.h - truetype glyph outlines from stb_truetype, cached per codepoint, added as paths to cDrawAA
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include "cPointRect.h"
+
+class cDrawAA;
+
+//{{{
+class cFont {
+// - outlines stored in em units, y down, so any height, position or rotation reuses one parse
+// - curves flattened at draw time in pixels, same tolerance as cPath
+public:
+  //{{{
+  struct sVertex {
+    uint8_t type;
+    cPointF p;
+    cPointF c;
+    cPointF c1;
+    };
+  //}}}
+  //{{{
+  struct sGlyph {
+    float advance;
+    cPointF topLeft;
+    cPointF bottomRight;
+
+    int numVertices;
+    sVertex* vertices;
+    };
+  //}}}
+
+  cFont (const uint8_t* font, const int fontSize);
+  ~cFont();
+
+  bool isOk() const { return mOk; }
+  uint32_t getNumGlyphs() const { return (uint32_t)mGlyphs.size(); }
+
+  const sGlyph* getGlyph (const uint32_t codepoint);
+  uint8_t* getSdf (const uint32_t codepoint, const float emPixels, const int padding, const uint8_t onEdge,
+                   const float distScale, int& width, int& height, int& left, int& top);
+
+  void addGlyph (cDrawAA& drawAA, const sGlyph* glyph, const cPointF& origin, const float height,
+                 const float cosA = 1.f, const float sinA = 0.f, const float tolerance = 0.25f,
+                 const float stretchX = 1.f) const;
+
+private:
+  bool mOk = false;
+  float mEmScale = 0.f;
+  void* mInfo = nullptr;
+
+  std::unordered_map<uint32_t, sGlyph*> mGlyphs;
+  };
+//}}}
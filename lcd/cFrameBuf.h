@@ -0,0 +1,214 @@
+// cFrameBuf.h - frameBuf and row diff in a panel's native pixel format
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "cPointRect.h"
+#include "cPixelFormat.h"
+
+//{{{
+class cNativeFrameBuf {
+// frameBuf and previous frame of any pixel format, what cLcd draws and presents for a native panel
+// - diff compares rows against previous frame, spans are runs of changed rows,
+//   x extents from first and last changed byte, so 1bpp diffs 16x fewer bytes than rgb565
+// - primitives virtual, each implemented once per format by cFrameBuf<tFormat>
+public:
+  //{{{
+  cNativeFrameBuf (const uint16_t width, const uint16_t height, const int bitsPerPixel)
+      : mWidth(width), mHeight(height), mBitsPerPixel(bitsPerPixel), mStride(((width * bitsPerPixel) + 7) / 8) {
+
+    mFrameBuf = (uint8_t*)aligned_alloc (128, getAllocBytes());
+    mPrevFrameBuf = (uint8_t*)aligned_alloc (128, getAllocBytes());
+    memset (mFrameBuf, 0, getNumBytes());
+    memset (mPrevFrameBuf, 0, getNumBytes());
+
+    mSpans = (sSpan*)malloc (height * sizeof(sSpan));
+    }
+  //}}}
+  //{{{
+  virtual ~cNativeFrameBuf() {
+
+    free (mFrameBuf);
+    free (mPrevFrameBuf);
+    free (mSpans);
+    }
+  //}}}
+
+  uint16_t getWidth() const { return mWidth; }
+  uint16_t getHeight() const { return mHeight; }
+  cRect getRect() const { return cRect (0,0, mWidth,mHeight); }
+  int getStride() const { return mStride; }
+  int getNumBytes() const { return mStride * mHeight; }
+
+  uint8_t* getFrameBuf() { return mFrameBuf; }
+  uint8_t* getRow (const int y) { return mFrameBuf + (y * mStride); }
+
+  // rgb565 colour converted once per call, rect clipped to frameBuf, maskRow unclipped a8 coverage
+  virtual void clear (const uint16_t colour) = 0;
+  virtual void rect (const uint16_t colour, const uint8_t alpha, const cRect& r) = 0;
+  virtual void maskRow (const uint16_t colour, const int x, const int y, const uint8_t* mask, const int num) = 0;
+
+  //{{{
+  sSpan* diff() {
+  // return spans of changed rows against previous frame, nullptr if unchanged
+
+    int numSpans = 0;
+    for (int y = 0; y < mHeight; y++) {
+      const uint8_t* row = mFrameBuf + (y * mStride);
+      const uint8_t* prevRow = mPrevFrameBuf + (y * mStride);
+      if (!memcmp (row, prevRow, mStride))
+        continue;
+
+      // changed byte extents as pixel extents
+      int first = 0;
+      while (row[first] == prevRow[first])
+        first++;
+      int last = mStride - 1;
+      while (row[last] == prevRow[last])
+        last--;
+      int left = (first * 8) / mBitsPerPixel;
+      int right = min ((((last + 1) * 8) + mBitsPerPixel - 1) / mBitsPerPixel, (int)mWidth);
+
+      sSpan* span = mSpans + numSpans - 1;
+      if (numSpans && (span->r.bottom == y)) {
+        // extend span of previous row
+        span->r.left = min ((int)span->r.left, left);
+        span->r.right = max ((int)span->r.right, right);
+        span->r.bottom = y + 1;
+        }
+      else {
+        span = mSpans + numSpans++;
+        span->r = cRect (left, y, right, y + 1);
+        }
+      span->lastScanRight = span->r.right;
+      span->size = span->r.getNumPixels();
+      span->next = nullptr;
+      if (numSpans > 1)
+        span[-1].next = span;
+      }
+
+    return numSpans ? mSpans : nullptr;
+    }
+  //}}}
+  //{{{
+  void swap() {
+  // previous frame becomes this frame, frameBuf holds frame before, as cFrameDiff::swap
+
+    uint8_t* temp = mPrevFrameBuf;
+    mPrevFrameBuf = mFrameBuf;
+    mFrameBuf = temp;
+    }
+  //}}}
+  //{{{
+  void copy() {
+  // previous frame becomes this frame, frameBuf kept for incremental drawing
+    memcpy (mPrevFrameBuf, mFrameBuf, getNumBytes());
+    }
+  //}}}
+  //{{{
+  void copy (const sSpan* spans) {
+  // previous frame takes only spans of this frame, rows outside spans already equal after diff
+
+    for (const sSpan* span = spans; span; span = span->next) {
+      int first = (span->r.left * mBitsPerPixel) / 8;
+      int last = ((span->r.right * mBitsPerPixel) + 7) / 8;
+      for (int y = span->r.top; y < span->r.bottom; y++)
+        memcpy (mPrevFrameBuf + (y * mStride) + first, mFrameBuf + (y * mStride) + first, last - first);
+      }
+    }
+  //}}}
+
+protected:
+  static int min (const int a, const int b) { return a < b ? a : b; }
+  static int max (const int a, const int b) { return a > b ? a : b; }
+
+  const uint16_t mWidth;
+  const uint16_t mHeight;
+
+private:
+  int getAllocBytes() const { return ((getNumBytes() + 127) / 128) * 128; }
+
+  const int mBitsPerPixel;
+  const int mStride;
+
+  uint8_t* mFrameBuf = nullptr;
+  uint8_t* mPrevFrameBuf = nullptr;
+  sSpan* mSpans = nullptr;
+  };
+//}}}
+//{{{
+template <class tFormat> class cFrameBuf : public cNativeFrameBuf {
+// - primitives take rgb565 colours, converted once per primitive, stored as tFormat
+// - alpha and coverage through tFormat::blend, full alpha stored straight
+public:
+  typedef typename tFormat::tPixel tPixel;
+
+  cFrameBuf (const uint16_t width, const uint16_t height) : cNativeFrameBuf (width, height, tFormat::kBitsPerPixel) {}
+  virtual ~cFrameBuf() {}
+
+  //{{{
+  virtual void clear (const uint16_t colour) {
+
+    tPixel pixel = tFormat::fromRgb565 (colour);
+    for (int y = 0; y < mHeight; y++)
+      tFormat::fillRow (getRow (y), 0, mWidth, pixel);
+    }
+  //}}}
+  //{{{
+  void rect (const uint16_t colour, const cRect& r) {
+    rect (colour, 0xFF, r);
+    }
+  //}}}
+  //{{{
+  virtual void rect (const uint16_t colour, const uint8_t alpha, const cRect& r) {
+
+    cRect clipped = r.intersect (getRect());
+    if (clipped.isEmpty() || !alpha)
+      return;
+
+    tPixel pixel = tFormat::fromRgb565 (colour);
+    for (int y = clipped.top; y < clipped.bottom; y++) {
+      uint8_t* row = getRow (y);
+      if (alpha == 0xFF)
+        tFormat::fillRow (row, clipped.left, clipped.right, pixel);
+      else
+        for (int x = clipped.left; x < clipped.right; x++)
+          tFormat::setPixel (row, x, tFormat::blend (tFormat::getPixel (row, x), pixel, alpha));
+      }
+    }
+  //}}}
+  //{{{
+  virtual void maskRow (const uint16_t colour, const int x, const int y, const uint8_t* mask, const int num) {
+
+    tPixel pixel = tFormat::fromRgb565 (colour);
+    uint8_t* row = getRow (y);
+    for (int i = x; i < x + num; i++, mask++)
+      if (*mask == 0xFF)
+        tFormat::setPixel (row, i, pixel);
+      else if (*mask)
+        tFormat::setPixel (row, i, tFormat::blend (tFormat::getPixel (row, i), pixel, *mask));
+    }
+  //}}}
+  //{{{
+  void pix (const uint16_t colour, const cPoint& p) {
+
+    if ((p.x >= 0) && (p.y >= 0) && (p.x < mWidth) && (p.y < mHeight))
+      tFormat::setPixel (getRow (p.y), p.x, tFormat::fromRgb565 (colour));
+    }
+  //}}}
+  //{{{
+  void copy (const uint16_t* src, const uint16_t srcStride, const cRect& r) {
+  // import rgb565 rect, src at r.left,r.top, for content not drawn natively
+
+    cRect clipped = r.intersect (getRect());
+    for (int y = clipped.top; y < clipped.bottom; y++) {
+      uint8_t* row = getRow (y);
+      const uint16_t* srcRow = src + ((y - r.top) * srcStride) - r.left;
+      for (int x = clipped.left; x < clipped.right; x++)
+        tFormat::setPixel (row, x, tFormat::fromRgb565 (srcRow[x]));
+      }
+    }
+  //}}}
+  using cNativeFrameBuf::copy;
+  };
+//}}}
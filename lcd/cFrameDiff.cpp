@@ -93,21 +93,21 @@ void cFrameDiff::merge (int pixelThreshold) {
 
 // cSingleFrameDiff
 //{{{
-sSpan* cSingleFrameDiff::diff (uint16_t* frameBuf) {
+sSpan* cSingleFrameDiff::diff (uint16_t* frameBuf, const int top, const int bottom) {
 // return 1, if single bounding span is different, else 0
 
   sSpan* spans = mSpans;
   mNumSpans = 0;
 
-  int minY = 0;
+  int minY = top;
   int minX = -1;
 
   // stride as uint16 elements.
   const int stride = mWidth;
   const int widthAligned4 = (uint32_t)mWidth & ~3u;
 
-  uint16_t* scanline = frameBuf;
-  uint16_t* prevFrameScanline = mPrevFrameBuf;
+  uint16_t* scanline = frameBuf + (top * stride);
+  uint16_t* prevFrameScanline = mPrevFrameBuf + (top * stride);
 
   #ifdef COARSE_DIFF_ALLOWED
     //{{{  coarse diff
@@ -131,7 +131,7 @@ sSpan* cSingleFrameDiff::diff (uint16_t* frameBuf) {
   #else
     //{{{  fine diff
     {
-    while (minY < mHeight) {
+    while (minY < bottom) {
       int x = 0;
       // diff 4 pixels at a time
       for (; x < widthAligned4; x += 4) {
@@ -164,7 +164,7 @@ sSpan* cSingleFrameDiff::diff (uint16_t* frameBuf) {
 
 foundTop:
   int maxX = -1;
-  int maxY = mHeight - 1;
+  int maxY = bottom - 1;
 
   #ifdef COARSE_DIFF_ALLOWED
     //{{{  coarse diff
@@ -186,8 +186,8 @@ foundTop:
   #else
     //{{{  fine diff
     {
-    scanline = frameBuf + (mHeight-1) * stride;
-    prevFrameScanline = mPrevFrameBuf + (mHeight-1) * stride;
+    scanline = frameBuf + (bottom-1) * stride;
+    prevFrameScanline = mPrevFrameBuf + (bottom-1) * stride;
 
     while (maxY >= minY) {
       int x = mWidth-1;
@@ -386,13 +386,13 @@ int cSingleFrameDiff::coarseLinearDiffBack (uint16_t* frameBuf, uint16_t* prevFr
 
 // cCoarseFrameDiff
 //{{{
-sSpan* cCoarseFrameDiff::diff (uint16_t* frameBuf) {
+sSpan* cCoarseFrameDiff::diff (uint16_t* frameBuf, const int top, const int bottom) {
 // return numSpans, 4pix (64bit) alignment
 
   sSpan* spans = mSpans;
   int numSpans = 0;
 
-  int y =  0;
+  int y = top;
   int yInc = 1;
 
   const int width64 = mWidth >> 2;
@@ -401,7 +401,7 @@ sSpan* cCoarseFrameDiff::diff (uint16_t* frameBuf) {
   sSpan* span = spans;
   uint64_t* scanline = (uint64_t*)(frameBuf + (y * mWidth));
   uint64_t* prevFrameScanline = (uint64_t*)(mPrevFrameBuf + (y * mWidth));
-  while (y < mHeight) {
+  while (y < bottom) {
     uint16_t* scanlineStart = (uint16_t*)scanline;
 
     for (int x = 0; x < width64;) {
@@ -469,7 +469,7 @@ sSpan* cCoarseFrameDiff::diff (uint16_t* frameBuf) {
 
 // cExactFrameDiff
 //{{{
-sSpan* cExactFrameDiff::diff (uint16_t* frameBuf) {
+sSpan* cExactFrameDiff::diff (uint16_t* frameBuf, const int top, const int bottom) {
 // return numSpans
 
   //constexpr uint32_t kDiffMask = 0xFFFFFFFF;  // all bits
@@ -480,13 +480,13 @@ sSpan* cExactFrameDiff::diff (uint16_t* frameBuf) {
   sSpan* spans = mSpans;
   int numSpans = 0;
 
-  int y =  0;
+  int y = top;
   int yInc = 1;
 
   sSpan* span = spans;
   uint16_t* scanline = frameBuf + y * mWidth;
   uint16_t* prevFrameScanline = mPrevFrameBuf + y * mWidth;
-  while (y < mHeight) {
+  while (y < bottom) {
     uint16_t* scanlineStart = scanline;
     uint16_t* scanlineEnd = scanline + mWidth;
     while (scanline < scanlineEnd) {
@@ -13,8 +13,9 @@ public:
   virtual uint16_t* swap (uint16_t* frameBuf);
   virtual void copy (uint16_t* frameBuf);
 
-  // diff
-  virtual sSpan* diff (uint16_t* frameBuf) = 0;
+  // diff, optionally only rows top to bottom, rows outside known unchanged
+  sSpan* diff (uint16_t* frameBuf) { return diff (frameBuf, 0, mHeight); }
+  virtual sSpan* diff (uint16_t* frameBuf, const int top, const int bottom) = 0;
 
 protected:
   void allocateResources();
@@ -44,7 +45,7 @@ public:
 
   virtual uint16_t* swap (uint16_t* frameBuf) { return frameBuf; }
   virtual void copy (uint16_t* frameBuf) {}
-  virtual sSpan* diff (uint16_t* frameBuf) { return mSpans; };
+  virtual sSpan* diff (uint16_t* frameBuf, const int top, const int bottom) { return mSpans; };
   };
 //}}}
 //{{{
@@ -57,7 +58,7 @@ public:
   //}}}
   virtual ~cSingleFrameDiff() {}
 
-  virtual sSpan* diff (uint16_t* frameBuf);
+  virtual sSpan* diff (uint16_t* frameBuf, const int top, const int bottom);
 
 private:
   static int coarseLinearDiff (uint16_t* frameBuf, uint16_t* prevFrameBuf, uint16_t* frameBufEnd);
@@ -74,7 +75,7 @@ public:
   //}}}
   virtual ~cCoarseFrameDiff() {}
 
-  virtual sSpan* diff (uint16_t* frameBuf);
+  virtual sSpan* diff (uint16_t* frameBuf, const int top, const int bottom);
   };
 //}}}
 //{{{
@@ -87,6 +88,6 @@ public:
   //}}}
   virtual ~cExactFrameDiff() {}
 
-  virtual sSpan* diff (uint16_t* frameBuf);
+  virtual sSpan* diff (uint16_t* frameBuf, const int top, const int bottom);
   };
 //}}}
@@ -2,11 +2,20 @@
 //{{{  includes
 #include "cLcd.h"
 
+#include "cCompositor.h"
+#include "cConvert.h"
+#include "cDisplayList.h"
 #include "cDrawAA.h"
+#include "cFont.h"
 #include "cFrameDiff.h"
+#include "cFrameBuf.h"
+#include "cLcdBus.h"
+#include "cLcdBusDma.h"
+#include "cMaskCache.h"
+#include "cSdfAtlas.h"
 #include "cSnapshot.h"
-
-#include <byteswap.h>
+#include "cBlend.h"
+#include "cSprite.h"
 
 #include "../pigpio/pigpioLite.h"
 
@@ -17,13 +26,6 @@
 using namespace std;
 using namespace fmt;
 //}}}
-//{{{  include static freetype - assumes singleton cLcd
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
-static FT_Library mLibrary;
-static FT_Face mFace;
-//}}}
 //{{{  raspberry pi J8 connnector pins
 // parallel 16bit J8
 //      3.3v led -  1  2  - 5v
@@ -62,30 +64,59 @@ constexpr uint8_t k16ReadGpio       = 22;
 constexpr uint8_t k16ChipSelectGpio = 23;
 constexpr uint8_t k16BacklightGpio  = 27;
 
-constexpr uint32_t k16DataMask     = 0x0000FFFF;
-constexpr uint32_t k16WriteMask    = 0x00020000;
-constexpr uint32_t k16WriteClrMask = 0x0002FFFF;
-
 constexpr uint8_t kSpiBacklightGpio = 24;
 constexpr uint8_t kSpiCe0Gpio = 8;
 //}}}
 
+//{{{
+struct sHalfWidths {
+// ellipse half width at dy, widest x whose centre is inside ellipse of radius + 0.5
+// - doubled coords keep it integer, x only decreases as dy increases, so dy asked in increasing order
+  sHalfWidths (const int radiusX, const int radiusY)
+    : a2(int64_t((2 * radiusX) + 1) * ((2 * radiusX) + 1)),
+      b2(int64_t((2 * radiusY) + 1) * ((2 * radiusY) + 1)),
+      limit(a2 * b2), x(radiusX) {}
+
+  int operator[] (const int dy) {
+    int64_t yTerm = 4 * int64_t(dy) * dy * a2;
+    while ((x > 0) && ((4 * int64_t(x) * x * b2) + yTerm > limit))
+      x--;
+    return x;
+    }
+
+  const int64_t a2;
+  const int64_t b2;
+  const int64_t limit;
+  int x;
+  };
+//}}}
+
 // cLcd public
 //{{{
-cLcd::cLcd (const int16_t width, const int16_t height, const eRotate rotate, const eInfo info, const eMode mode)
+cLcd::cLcd (const int16_t width, const int16_t height, const eRotate rotate, const eInfo info, const eMode mode,
+            cLcdBus* bus)
   : mRotate(rotate), mInfo(info), mMode(mode),
     mWidth(((rotate == e90) || (rotate == e270)) ? height : width),
     mHeight(((rotate == e90) || (rotate == e270)) ? width : height),
-    mSnapshotEnabled(true), mTypeEnabled(true) {}
+    mBus(bus), mSnapshotEnabled(true), mTypeEnabled(true) {}
 //}}}
 //{{{
 cLcd::~cLcd() {
 
+  // bus closes its spi before gpio terminates
+  delete mBus;
   gpioTerminate();
 
   free (mFrameBuf);
+  free (mScratchRow);
   free (mSpanAll);
+  free (mUpdateRow);
 
+  // indexFrameBuf, once set, is nativeFrameBuf
+  delete mNativeFrameBuf;
+  delete mMaskCache;
+  delete mSdfAtlas;
+  delete mFont;
   delete mDrawAA;
   delete mFrameDiff;
   }
@@ -104,11 +135,20 @@ bool cLcd::initialise() {
   if (gpioInitialise() <= 0)
     return false;
 
-  // allocate and clear frameBufs, align to data cache
-  mFrameBuf = (uint16_t*)aligned_alloc (128, getNumPixels() * 2);
+  if (!mBus->open())
+    return false;
+  cLog::log (LOGINFO, format ("bus {}", mBus->getName()));
+
+  // allocate and clear frameBufs, align to data cache, native panel has its own
+  if (!mNativeFrameBuf)
+    mFrameBuf = (uint16_t*)aligned_alloc (128, getNumPixels() * 2);
+  mScratchRow = (uint16_t*)malloc (mWidth * 2);
+  mClip = getRect();
   clear();
 
+  // aa paths clipped to frameBuf as added, off screen geometry makes no cells
   mDrawAA = new cDrawAA();
+  mDrawAA->setClipBox (getRect());
 
   // gamma table, !!! duplicate of cDrawAA !!!
   for (unsigned i = 0; i < 256; i++)
@@ -118,23 +158,24 @@ bool cLcd::initialise() {
   mSpanAll = (sSpan*)malloc (sizeof (sSpan));
   *mSpanAll = { getRect(), mWidth, getNumPixels(), nullptr};
 
-  // allocate frameDiff
-  switch (mMode) {
-    case eAll:
-      mFrameDiff = new cAllFrameDiff (mWidth, mHeight);
-      break;
-    case eSingle:
-      mFrameDiff = new cSingleFrameDiff (mWidth, mHeight);
-      break;
-    case eCoarse:
-      mFrameDiff = new cCoarseFrameDiff (mWidth, mHeight);
-      break;
-    case eExact:
-      mFrameDiff = new cExactFrameDiff (mWidth, mHeight);
-      break;
-    }
+  // allocate frameDiff, native panel diffs its native frameBuf
+  if (!mNativeFrameBuf)
+    switch (mMode) {
+      case eAll:
+        mFrameDiff = new cAllFrameDiff (mWidth, mHeight);
+        break;
+      case eSingle:
+        mFrameDiff = new cSingleFrameDiff (mWidth, mHeight);
+        break;
+      case eCoarse:
+        mFrameDiff = new cCoarseFrameDiff (mWidth, mHeight);
+        break;
+      case eExact:
+        mFrameDiff = new cExactFrameDiff (mWidth, mHeight);
+        break;
+      }
 
-  if (mSnapshotEnabled)
+  if (mSnapshotEnabled && !mNativeFrameBuf)
     mSnapshot = new cSnapshot (mWidth, mHeight);
 
   if (mTypeEnabled)
@@ -146,22 +187,45 @@ bool cLcd::initialise() {
 
 //{{{
 void cLcd::clear (const uint16_t colour) {
-// start update
+// start update, if frameBuf already cleared to colour, reset only what was drawn since
+
+  if (drawNative()) {
+    if (!mTrack.cleared || (mTrack.colour != colour))
+      mNativeFrameBuf->clear (colour);
+    else
+      mNativeFrameBuf->rect (colour, 0xFF, mTrack.drawn);
+    }
 
-  uint64_t colour64 = colour;
-  colour64 |= (colour64 << 48) | (colour64 << 32) | (colour64 << 16);
+  else if (mInLayer || !mTrack.cleared || (mTrack.colour != colour)) {
+    uint64_t colour64 = colour;
+    colour64 |= (colour64 << 48) | (colour64 << 32) | (colour64 << 16);
 
-  uint64_t* ptr = (uint64_t*)mFrameBuf;
-  for (uint32_t i = 0; i < getNumPixels()/4; i++)
-    *ptr++ = colour64;
+    uint64_t* ptr = (uint64_t*)mFrameBuf;
+    for (uint32_t i = 0; i < getNumPixels()/4; i++)
+      *ptr++ = colour64;
+    }
+  else
+    for (int y = mTrack.drawn.top; y < mTrack.drawn.bottom; y++)
+      cBlend::fillRow (mFrameBuf + (y * mWidth) + mTrack.drawn.left, colour, mTrack.drawn.getWidth());
+
+  if (!mInLayer) {
+    mTrack.cleared = true;
+    mTrack.colour = colour;
+    mTrack.drawn = cRect();
+    }
   }
 //}}}
 //{{{
 void cLcd::snapshot() {
 // start update, snapshot main display to frameBuffer
 
-  if (mSnapshotEnabled)
+  if (rejectNative ("snapshot"))
+    return;
+
+  if (mSnapshotEnabled) {
     mSnapshot->snap (mFrameBuf);
+    mTrack.cleared = false;
+    }
   else
     cLog::log (LOGERROR, "snapahot not enabled");
   }
@@ -170,8 +234,24 @@ void cLcd::snapshot() {
 bool cLcd::present() {
 // present update
 
+  mCompositor = nullptr;
+  if (mNativeFrameBuf)
+    return presentNative();
+
   double diffStartTime = timeUs();
-  sSpan* spans = mFrameDiff->diff (mFrameBuf);
+  sSpan* spans;
+  if (mDisplayList) {
+    // displayList frames were not swapped through frameDiff, update everything this once
+    mDisplayList = nullptr;
+    spans = mSpanAll;
+    }
+  else if (mTrack.cleared && mPrevTrack.cleared && (mTrack.colour == mPrevTrack.colour)) {
+    // both frameBufs cleared to same colour, only rows drawn in either can differ
+    cRect changed = mTrack.drawn.combine (mPrevTrack.drawn);
+    spans = changed.isEmpty() ? nullptr : mFrameDiff->diff (mFrameBuf, changed.top, changed.bottom);
+    }
+  else
+    spans = mFrameDiff->diff (mFrameBuf);
   mDiffUs = int((timeUs() - diffStartTime) * 1000000.0);
 
   if (!spans) {
@@ -180,8 +260,11 @@ bool cLcd::present() {
     return false;
     }
 
-  if (mInfo == eOverlay) // copy frameBuf to prevFrameBuf without overlays
+  if (mInfo == eOverlay) {
+    // copy frameBuf to prevFrameBuf without overlays
     mFrameDiff->copy (mFrameBuf);
+    mPrevTrack = mTrack;
+    }
 
   // updateLcd with diff spans list
   double updateStartTime = timeUs();
@@ -203,13 +286,212 @@ bool cLcd::present() {
 
   cLog::log (LOGINFO1, getInfoString());
 
-  if (mInfo != eOverlay)
+  if (mInfo != eOverlay) {
+    uint16_t* frameBuf = mFrameBuf;
     mFrameBuf = mFrameDiff->swap (mFrameBuf);
+    if (mFrameBuf != frameBuf)
+      swap (mTrack, mPrevTrack);
+    else
+      mPrevTrack = mTrack;
+    }
+
+  return true;
+  }
+//}}}
+//{{{
+bool cLcd::present (cDisplayList& displayList) {
+// present retained displayList
+// - render only damage from changed commands, into retained frameBuf, update only damage, no frameDiff
+// - no info overlay, it would be retained in frameBuf
+// - not indexed or native, displayList renders into rgb565 frameBuf
+
+  if (mNativeFrameBuf) {
+    cLog::log (LOGERROR, "present displayList while indexed or native");
+    return false;
+    }
+
+  if (&displayList != mDisplayList) {
+    // frameBuf not what is on screen, or not from this displayList, render everything
+    displayList.invalidate();
+    mDisplayList = &displayList;
+    }
+  mCompositor = nullptr;
+  mTrack.cleared = false;
+  mPrevTrack.cleared = false;
 
+  double diffStartTime = timeUs();
+  sSpan* spans = displayList.diff (this);
+  if (!spans) {
+    // nothing changed
+    mDiffUs = int((timeUs() - diffStartTime) * 1000000.0);
+    mUpdateUs = 0;
+    return false;
+    }
+
+  for (sSpan* it = spans; it; it = it->next) {
+    pushClip (it->r);
+    displayList.render (this, it->r);
+    popClip();
+    }
+  mDiffUs = int((timeUs() - diffStartTime) * 1000000.0);
+
+  double updateStartTime = timeUs();
+  mUpdatePixels = updateLcd (spans);
+  mUpdateUs = int((timeUs() - updateStartTime) * 1000000.0);
+
+  cLog::log (LOGINFO1, getInfoString());
   return true;
   }
 //}}}
 
+//{{{
+bool cLcd::present (cCompositor& compositor) {
+// present layers, composite only dirty layer rects into frameBuf, then usual frameDiff present
+// - eOverlay draws into frameBuf, so composite everything each frame
+// - not indexed or native, compositor composes into rgb565 frameBuf
+
+  if (mNativeFrameBuf) {
+    cLog::log (LOGERROR, "present compositor while indexed or native");
+    return false;
+    }
+
+  if ((&compositor != mCompositor) || (mInfo == eOverlay))
+    // frameBufs not from this compositor
+    compositor.invalidate();
+
+  compositor.compose (mFrameBuf);
+  mTrack.cleared = false;
+  bool changed = present();
+
+  mCompositor = &compositor;
+  return changed;
+  }
+//}}}
+
+//{{{
+void cLcd::setIndexed (const uint16_t* palette) {
+// indexFrameBuf becomes nativeFrameBuf, drawn and presented from now on, colour arguments are indices
+// - rgb565 frameBuf, frameDiff and snapshot, or panel's own nativeFrameBuf, freed, not used again
+
+  if (mInLayer) {
+    cLog::log (LOGERROR, "setIndexed inside beginLayer");
+    return;
+    }
+
+  if (!mIndexFrameBuf) {
+    mIndexFrameBuf = new cFrameBuf<cIndex8> (mWidth, mHeight);
+    mUpdateRow = (uint16_t*)aligned_alloc (128, ((mWidth * 2 + 127) / 128) * 128);
+
+    delete mNativeFrameBuf;
+    mNativeFrameBuf = mIndexFrameBuf;
+
+    free (mFrameBuf);
+    mFrameBuf = nullptr;
+    delete mFrameDiff;
+    mFrameDiff = nullptr;
+    delete mSnapshot;
+    mSnapshot = nullptr;
+
+    // nothing drawn into indexFrameBuf yet
+    mTrack.cleared = false;
+    }
+
+  setPalette (palette);
+  }
+//}}}
+//{{{
+void cLcd::setPalette (const uint16_t* palette) {
+// 256 rgb565 entries, next present resends everything without redrawing
+
+  memcpy (mPalette, palette, sizeof(mPalette));
+  mPaletteChanged = true;
+  }
+//}}}
+//{{{
+void cLcd::setPaletteEntry (const uint8_t index, const uint16_t colour) {
+
+  if (mPalette[index] != colour) {
+    mPalette[index] = colour;
+    mPaletteChanged = true;
+    }
+  }
+//}}}
+
+//{{{
+void cLcd::beginLayer (cLayer& layer) {
+  beginLayer (layer, getRect());
+  }
+//}}}
+//{{{
+void cLcd::beginLayer (cLayer& layer, const cRect& r) {
+// draw into layer, clipped to r, r marked dirty, layers don't nest
+
+  if (mInLayer) {
+    cLog::log (LOGERROR, "beginLayer inside beginLayer");
+    return;
+    }
+
+  mInLayer = true;
+  mLayerSavedFrameBuf = mFrameBuf;
+  mLayerSavedClip = mClip;
+
+  mFrameBuf = layer.getFrameBuf();
+  setClip (r);
+  layer.invalidate (mClip);
+  }
+//}}}
+//{{{
+void cLcd::endLayer() {
+
+  if (mInLayer) {
+    mFrameBuf = mLayerSavedFrameBuf;
+    mClip = mLayerSavedClip;
+    mLayerSavedFrameBuf = nullptr;
+    mInLayer = false;
+    }
+  }
+//}}}
+
+//{{{
+void cLcd::setClip (const cRect& r) {
+// primitives draw only inside clip, clip limited to screen
+  mClip = r.intersect (getRect());
+  }
+//}}}
+//{{{
+void cLcd::resetClip() {
+
+  mClip = getRect();
+  mNumClips = 0;
+  }
+//}}}
+//{{{
+void cLcd::pushClip (const cRect& r) {
+// save clip, clip to r inside it
+
+  if (mNumClips < kMaxClips)
+    mClipStack[mNumClips] = mClip;
+  else
+    cLog::log (LOGERROR, "pushClip too deep");
+  mNumClips++;
+
+  mClip = mClip.intersect (r);
+  }
+//}}}
+//{{{
+void cLcd::popClip() {
+
+  if (mNumClips <= 0) {
+    cLog::log (LOGERROR, "popClip without pushClip");
+    return;
+    }
+
+  mNumClips--;
+  if (mNumClips < kMaxClips)
+    mClip = mClipStack[mNumClips];
+  }
+//}}}
+
 //{{{
 void cLcd::pix (const uint16_t colour, const uint8_t alpha, const cPoint& p) {
 // blend with clip
@@ -220,9 +502,12 @@ void cLcd::pix (const uint16_t colour, const uint8_t alpha, const cPoint& p) {
 // - Converts  0000000000000000rrrrrggggggbbbbb
 // -     into  00000gggggg00000rrrrr000000bbbbb
 
-  if ((alpha > 0) && (p.x >= 0) && (p.y >= 0) && (p.x < mWidth) && (p.y < mHeight)) {
+  if ((alpha > 0) && (p.x >= mClip.left) && (p.y >= mClip.top) && (p.x < mClip.right) && (p.y < mClip.bottom)) {
     // clip opaque and offscreen
-    if (alpha == 0xFF)
+    drawn (cRect (p.x, p.y, p.x+1, p.y+1));
+    if (drawNative())
+      mNativeFrameBuf->rect (colour, alpha, cRect (p.x, p.y, p.x+1, p.y+1));
+    else if (alpha == 0xFF)
       // simple case - set frameBuf pixel to colour
       mFrameBuf[(p.y*mWidth) + p.x] = colour;
     else {
@@ -243,33 +528,152 @@ void cLcd::pix (const uint16_t colour, const uint8_t alpha, const cPoint& p) {
 //}}}
 //{{{
 void cLcd::copy (const uint16_t* src, cRect& srcRect, const uint16_t srcStride, const cPoint& dstPoint) {
-// copy line by line
+// copy line by line, dst rect clipped, src rect offset to match
+
+  if (rejectNative ("copy"))
+    return;
+
+  cRect clipped = (srcRect + (dstPoint - srcRect.getTL())).intersect (mClip);
+  if (clipped.isEmpty())
+    return;
+
+  drawn (clipped);
+  const uint16_t* srcPtr = src + ((srcRect.top + clipped.top - dstPoint.y) * srcStride) +
+                                  srcRect.left + clipped.left - dstPoint.x;
+  for (int y = clipped.top; y < clipped.bottom; y++, srcPtr += srcStride)
+    memcpy (mFrameBuf + (y * mWidth) + clipped.left, srcPtr, clipped.getWidth() * 2);
+  }
+//}}}
+//{{{
+void cLcd::copyScaled (const uint16_t* src, const cRect& srcRect, const uint16_t srcStride,
+                       const cRect& dstRect, const eFilter filter) {
+// copy srcRect scaled to dstRect, clipped
+// - src positions stepped in 16.16 fixed point, pixel centres mapped to pixel centres
+// - eBox is exact 2:1 average, any other scale falls back to eBilinear
+
+  if (rejectNative ("copyScaled"))
+    return;
+
+  cRect clipped = dstRect.intersect (mClip);
+  if (clipped.isEmpty() || srcRect.isEmpty())
+    return;
+  drawn (clipped);
+
+  int srcWidth = srcRect.right - srcRect.left;
+  int srcHeight = srcRect.bottom - srcRect.top;
+  int dstWidth = dstRect.right - dstRect.left;
+  int dstHeight = dstRect.bottom - dstRect.top;
+
+  if ((filter == eBox) && (srcWidth == dstWidth * 2) && (srcHeight == dstHeight * 2)) {
+    copyBox2 (src + ((srcRect.top + (clipped.top - dstRect.top) * 2) * srcStride) +
+                     srcRect.left + (clipped.left - dstRect.left) * 2,
+              srcStride, clipped);
+    return;
+    }
+
+  int xStep = (srcWidth << 16) / dstWidth;
+  int yStep = (srcHeight << 16) / dstHeight;
+
+  // src position of first clipped dst pixel centre, relative to srcRect
+  int xStart = (xStep / 2) + ((clipped.left - dstRect.left) * xStep);
+  int yStart = (yStep / 2) + ((clipped.top - dstRect.top) * yStep);
+
+  if (filter == eNearest)
+    copyNearest (src + (srcRect.top * srcStride) + srcRect.left, srcStride, clipped, xStart, yStart, xStep, yStep);
+  else
+    // bilinear samples are centred between pixels
+    copyBilinear (src, srcRect, srcStride, clipped, xStart - 0x8000, yStart - 0x8000, xStep, yStep);
+  }
+//}}}
+//{{{
+void cLcd::copyRgb (const uint8_t* src, const int srcStride, const eRgbFormat format,
+                    const cRect& dstRect, const bool dither) {
+// convert rows, clipped, src offset to match
+
+  if (rejectNative ("copyRgb"))
+    return;
+
+  cRect clipped = dstRect.intersect (mClip);
+  if (clipped.isEmpty())
+    return;
+  drawn (clipped);
+
+  int pixelBytes = (format == eXrgb8888) ? 4 : 3;
+  const uint8_t* srcRow = src + ((clipped.top - dstRect.top) * srcStride) + ((clipped.left - dstRect.left) * pixelBytes);
+
+  for (int y = clipped.top; y < clipped.bottom; y++, srcRow += srcStride) {
+    uint16_t* dst = mFrameBuf + (y * mWidth) + clipped.left;
+    switch (format) {
+      case eRgb888:
+        cConvert::rgb888Row (dst, srcRow, clipped.getWidth(), clipped.left, y, dither);
+        break;
+      case eBgr888:
+        cConvert::bgr888Row (dst, srcRow, clipped.getWidth(), clipped.left, y, dither);
+        break;
+      case eXrgb8888:
+        cConvert::xrgb8888Row (dst, srcRow, clipped.getWidth(), clipped.left, y, dither);
+        break;
+      }
+    }
+  }
+//}}}
+//{{{
+void cLcd::copyYuv420 (const uint8_t* yPlane, const uint8_t* uPlane, const uint8_t* vPlane,
+                       const int yStride, const int uvStride, const cRect& dstRect, const bool dither) {
+// convert planar yuv420 rows, clipped, src offset to match, chroma rows shared by row pairs
+
+  if (rejectNative ("copyYuv420"))
+    return;
+
+  cRect clipped = dstRect.intersect (mClip);
+  if (clipped.isEmpty())
+    return;
+  drawn (clipped);
+
+  int srcX = clipped.left - dstRect.left;
+  for (int y = clipped.top; y < clipped.bottom; y++) {
+    int srcY = y - dstRect.top;
+    cConvert::yuv420Row (mFrameBuf + (y * mWidth) + clipped.left,
+                         yPlane + (srcY * yStride), uPlane + ((srcY >> 1) * uvStride), vPlane + ((srcY >> 1) * uvStride),
+                         srcX, clipped.getWidth(), clipped.left, y, dither);
+    }
+  }
+//}}}
+//{{{
+void cLcd::blit (const cSprite& sprite, const cPoint& p) {
+// blit sprite, clipped, transparency by sprite format
+
+  if (rejectNative ("blit"))
+    return;
 
-  for (int y = 0; y < srcRect.getHeight(); y++)
-    memcpy (mFrameBuf + ((dstPoint.y + y) * mWidth) + dstPoint.x,
-                  src + ((srcRect.top + y) * srcStride) + srcRect.left,
-            srcRect.getWidth() * 2);
+  drawn (cRect (p.x, p.y, p.x + sprite.getWidth(), p.y + sprite.getHeight()));
+  sprite.blit (mFrameBuf, mWidth, mClip, p);
   }
 //}}}
 //{{{  grad
 //{{{
 void cLcd::hGrad (const uint16_t colourL, const uint16_t colourR, const cRect& r) {
-// clip right, bottom, should do left top
+// clip, alpha from unclipped rect
+
+  if (rejectNative ("hGrad"))
+    return;
 
-  int16_t xmax = min (r.right, (int16_t)mWidth);
-  int16_t ymax = min (r.bottom, (int16_t)mHeight);
+  cRect clipped = r.intersect (mClip);
+  if (clipped.isEmpty())
+    return;
+  drawn (clipped);
 
   // draw a line
-  int16_t y = r.top;
-  uint16_t* dst = mFrameBuf + (y * mWidth) + r.left;
-  for (uint16_t x = r.left; x < xmax; x++) {
+  int16_t y = clipped.top;
+  uint16_t* dst = mFrameBuf + (y * mWidth) + clipped.left;
+  for (int16_t x = clipped.left; x < clipped.right; x++) {
     uint32_t fore = colourR;
     fore = (fore | (fore << 16)) & 0x07e0f81f;
 
     uint32_t back = colourL;
     back = (back | (back << 16)) & 0x07e0f81f;
 
-    uint8_t alpha = (x * 0xFF) / (r.right - r.left);
+    uint8_t alpha = ((x - r.left) * 0xFF) / (r.right - r.left);
     back += (((fore - back) * ((mGamma[alpha] + 4) >> 3)) >> 5) & 0x07e0f81f;
     back |= back >> 16;
 
@@ -278,22 +682,24 @@ void cLcd::hGrad (const uint16_t colourL, const uint16_t colourR, const cRect& r
   y++;
 
   // copy line to subsequnt lines
-  uint16_t* src = mFrameBuf + (r.top * mWidth) + r.left;
-  for (; y < ymax; y++) {
-    uint16_t* dst = mFrameBuf + (y * mWidth) + r.left;
-    memcpy (dst, src, (xmax - r.left) * 2);
-    dst += mWidth;
-    }
+  uint16_t* src = mFrameBuf + (clipped.top * mWidth) + clipped.left;
+  for (; y < clipped.bottom; y++)
+    memcpy (mFrameBuf + (y * mWidth) + clipped.left, src, clipped.getWidth() * 2);
   }
 //}}}
 //{{{
 void cLcd::vGrad (const uint16_t colourT, const uint16_t colourB, const cRect& r) {
 
-  int16_t xmax = min (r.right, (int16_t)mWidth);
-  int16_t ymax = min (r.bottom, (int16_t)mHeight);
+  if (rejectNative ("vGrad"))
+    return;
+
+  cRect clipped = r.intersect (mClip);
+  if (clipped.isEmpty())
+    return;
+  drawn (clipped);
 
-  for (uint16_t y = r.top; y < ymax; y++) {
-    uint16_t* dst = mFrameBuf + (y * mWidth) + r.left;
+  for (int16_t y = clipped.top; y < clipped.bottom; y++) {
+    uint16_t* dst = mFrameBuf + (y * mWidth) + clipped.left;
 
     uint32_t fore = colourB;
     fore = (fore | (fore << 16)) & 0x07e0f81f;
@@ -301,11 +707,11 @@ void cLcd::vGrad (const uint16_t colourT, const uint16_t colourB, const cRect& r
     uint32_t back = colourT;
     back = (back | (back << 16)) & 0x07e0f81f;
 
-    uint8_t alpha = (y * 0xFF) / (r.bottom - r.top);
+    uint8_t alpha = ((y - r.top) * 0xFF) / (r.bottom - r.top);
     back += (((fore - back) * ((mGamma[alpha] + 4) >> 3)) >> 5) & 0x07e0f81f;
     back |= back >> 16;
 
-    for (uint16_t x = r.left; x < xmax; x++)
+    for (int16_t x = clipped.left; x < clipped.right; x++)
       *dst++ = back;
     }
   }
@@ -315,18 +721,23 @@ void cLcd::grad (const uint16_t colourTL ,const uint16_t colourTR,
                  const uint16_t colourBL, const uint16_t colourBR, const cRect& r) {
 // !!! check for losing colour res, is the double gamma right ???
 
-  int16_t xmax = min (r.right, (int16_t)mWidth);
-  int16_t ymax = min (r.bottom, (int16_t)mHeight);
+  if (rejectNative ("grad"))
+    return;
+
+  cRect clipped = r.intersect (mClip);
+  if (clipped.isEmpty())
+    return;
+  drawn (clipped);
 
-  for (uint16_t y = r.top; y < ymax; y++) {
-    uint16_t* dst = mFrameBuf + (y * mWidth) + r.left;
+  for (int16_t y = clipped.top; y < clipped.bottom; y++) {
+    uint16_t* dst = mFrameBuf + (y * mWidth) + clipped.left;
 
-    for (uint16_t x = r.left; x < xmax; x++) {
+    for (int16_t x = clipped.left; x < clipped.right; x++) {
       uint32_t colour32TL = colourTL;
       colour32TL = (colour32TL | (colour32TL << 16)) & 0x07e0f81f;
       uint32_t colour32TR = colourTR;
       colour32TR = (colour32TR | (colour32TR << 16)) & 0x07e0f81f;
-      uint8_t alphaLR = (x * 0xFF) / (r.right - r.left);
+      uint8_t alphaLR = ((x - r.left) * 0xFF) / (r.right - r.left);
       colour32TL += (((colour32TR - colour32TL) * ((mGamma[alphaLR] + 4) >> 3)) >> 5) & 0x07e0f81f;
 
       uint32_t colour32BL = colourBL;
@@ -335,7 +746,7 @@ void cLcd::grad (const uint16_t colourTL ,const uint16_t colourTR,
       colour32BR = (colour32BR | (colour32BR << 16)) & 0x07e0f81f;
       colour32BL += (((colour32BR - colour32BL) * ((mGamma[alphaLR] + 4) >> 3)) >> 5) & 0x07e0f81f;
 
-      uint8_t alphaTB = (y * 0xFF) / (r.bottom - r.top);
+      uint8_t alphaTB = ((y - r.top) * 0xFF) / (r.bottom - r.top);
       colour32TL += (((colour32BL - colour32TL) * ((mGamma[alphaTB] + 4) >> 3)) >> 5) & 0x07e0f81f;
       colour32TL |= colour32TL >> 16;
 
@@ -344,31 +755,169 @@ void cLcd::grad (const uint16_t colourTL ,const uint16_t colourTR,
     }
   }
 //}}}
+//{{{
+void cLcd::radialGrad (const cPoint& centre, const int radius, const uint16_t colourIn, const uint16_t colourOut) {
+// fill square bounding circle, colourIn at centre to colourOut at radius and beyond, clipped
+// - Lomont chebyshev polynomial approximation of distance per row, fixed point forward differencing
+// - quadrant symmetry, one run of colours per row pair, written to 4 clipped row runs
+
+  if (rejectNative ("radialGrad"))
+    return;
+
+  if (radius <= 0)
+    return;
+
+  int xmin = max (centre.x - radius, (int)mClip.left);
+  int xmax = min (centre.x + radius, (int)mClip.right);
+  int ymin = max (centre.y - radius, (int)mClip.top);
+  int ymax = min (centre.y + radius, (int)mClip.bottom);
+  if ((xmin >= xmax) || (ymin >= ymax))
+    return;
+  drawn (cRect (xmin, ymin, xmax, ymax));
+
+  //{{{  colour ramp, 256 entries from colourIn to colourOut
+  uint16_t ramp[256];
+
+  int rIn = colourIn >> 11;
+  int gIn = (colourIn >> 5) & 0x3F;
+  int bIn = colourIn & 0x1F;
+  int rDelta = (colourOut >> 11) - rIn;
+  int gDelta = ((colourOut >> 5) & 0x3F) - gIn;
+  int bDelta = (colourOut & 0x1F) - bIn;
+
+  for (int i = 0; i < 256; i++)
+    ramp[i] = ((rIn + (rDelta * i) / 255) << 11) | ((gIn + (gDelta * i) / 255) << 5) | (bIn + (bDelta * i) / 255);
+  //}}}
+
+  // run covers furthest clipped column from centre, at most radius
+  int rightSkip = max (xmin - centre.x, 0);
+  int leftSkip = max (centre.x - xmax, 0);
+  int runLength = min (radius, max (xmax - centre.x, centre.x - xmin));
+  int rightLength = min (runLength, xmax - centre.x) - rightSkip;
+  int leftLength = min (runLength, centre.x - xmin) - leftSkip;
+
+  // only clipped columns of run kept, at most clip width, so run fits scratch row
+  int runStart = max (rightSkip, leftSkip);
+  int runEnd = max (rightSkip + rightLength, leftSkip + leftLength);
+  uint16_t* run = mScratchRow;
+
+  // fixed point, 255 * sqrt(2) * (1 << kBits) must fit int32
+  constexpr int kBits = 22;
+  const double K = 255.0 * (1 << kBits);
+
+  // normalised step and first pixel centre
+  const double delta = 1.0 / radius;
+  const double delta2 = delta * delta;
+  const double delta3 = delta2 * delta;
+  const double alpha = 0.5 / radius;
+
+  for (int j = 0; j < radius; j++) {
+    int yTop = centre.y - 1 - j;
+    int yBottom = centre.y + j;
+    bool top = (yTop >= ymin) && (yTop < ymax);
+    bool bottom = (yBottom >= ymin) && (yBottom < ymax);
+    if (!top && !bottom) {
+      if ((yTop < ymin) && (yBottom >= ymax))
+        break;
+      continue;
+      }
+
+    //{{{  chebyshev coeffs for this row
+    double beta = (j + 0.5) / radius;
+    double j2 = beta * beta;
+
+    double r1 = sqrt (0.0014485813926750633 + j2);
+    double r2 = sqrt (0.0952699361691366900 + j2);
+    double r3 = sqrt (0.4779533685342265000 + j2);
+    double r4 = sqrt (0.9253281139039617000 + j2);
+
+    double a0 =  1.2568348730314625 * r1 -  0.3741514406663722 * r2 +
+                0.16704465947982383 * r3 - 0.04972809184491411 * r4;
+    double a1 =  -7.196457548543286 * r1 +  10.760659484982682 * r2 -
+                5.10380523549030050 * r3 + 1.53960329905090450 * r4;
+    double a2 =  12.012829501508346 * r1 -  25.001535905017075 * r2 +
+                19.3446816555246950 * r3 - 6.35597525201596500 * r4;
+    double a3 =  -6.122934917841437 * r1 +  14.782072520180590 * r2 -
+                14.7820725201805900 * r3 + 6.12293491784143700 * r4;
+    //}}}
+    //{{{  forward differencing, fixed point
+    double d = ((a3 * alpha + a2) * alpha + a1) * alpha + a0;
+    double d1 = delta * (3 * a3 * alpha * alpha + alpha * (2 * a2 + 3 * a3 * delta) + a2 * delta + a3 * delta2 + a1);
+    double d2 = 2 * delta2 * (3 * a3 * (alpha + delta) + a2);
+    double d3 = 6 * a3 * delta3;
+
+    int index = (int)(d * K + 0.5);
+    int dIndex1 = (int)(d1 * K + 0.5);
+    int dIndex2 = (int)(d2 * K + 0.5);
+    int dIndex3 = (int)(d3 * K + 0.5);
+    //}}}
+
+    // distance increases along run, once past radius the rest is colourOut
+    int i = 0;
+    for (; i < runEnd; i++) {
+      int rampIndex = index >> kBits;
+      if (rampIndex >= 255)
+        break;
+      if (i >= runStart)
+        run[i - runStart] = ramp[rampIndex > 0 ? rampIndex : 0];
+      index += dIndex1;
+      dIndex1 += dIndex2;
+      dIndex2 += dIndex3;
+      }
+    for (i = max (i, runStart); i < runEnd; i++)
+      run[i - runStart] = colourOut;
+
+    //{{{  write runs, right copied, left mirrored
+    for (int y : { yTop, yBottom }) {
+      if ((y < ymin) || (y >= ymax))
+        continue;
+
+      uint16_t* row = mFrameBuf + (y * mWidth);
+      if (rightLength > 0)
+        memcpy (row + centre.x + rightSkip, run + rightSkip - runStart, rightLength * 2);
+
+      if (leftLength > 0) {
+        uint16_t* dst = row + centre.x - 1 - leftSkip;
+        const uint16_t* src = run + leftSkip - runStart;
+        for (int k = 0; k < leftLength; k++)
+          *dst-- = *src++;
+        }
+      }
+    //}}}
+    }
+  }
+//}}}
 //}}}
 //{{{  draw
 //{{{
 void cLcd::rect (const uint16_t colour, const cRect& r) {
-// rect with right,bottom clip
+// rect with clip
 
-  int16_t xmax = min (r.right, (int16_t)mWidth);
-  int16_t ymax = min (r.bottom, (int16_t)mHeight);
+  cRect clipped = r.intersect (mClip);
+  if (clipped.isEmpty())
+    return;
+  drawn (clipped);
 
-  for (int16_t y = r.top; y < ymax; y++) {
-    uint16_t* ptr = mFrameBuf + y*mWidth + r.left;
-    for (int16_t x = r.left; x < xmax; x++)
-      *ptr++ = colour;
-    }
+  if (drawNative())
+    mNativeFrameBuf->rect (colour, 0xFF, clipped);
+  else
+    for (int16_t y = clipped.top; y < clipped.bottom; y++)
+      cBlend::fillRow (mFrameBuf + (y * mWidth) + clipped.left, colour, clipped.getWidth());
   }
 //}}}
 //{{{
 void cLcd::rect (const uint16_t colour, const uint8_t alpha, const cRect& r) {
 
-  uint16_t xmax = min (r.right, (int16_t)mWidth);
-  uint16_t ymax = min (r.bottom, (int16_t)mHeight);
+  cRect clipped = r.intersect (mClip);
+  if (clipped.isEmpty())
+    return;
+  drawn (clipped);
 
-  for (int16_t y = r.top; y < ymax; y++)
-    for (int16_t x = r.left; x < xmax; x++)
-      pix (colour, alpha, cPoint(x, y));
+  if (drawNative())
+    mNativeFrameBuf->rect (colour, alpha, clipped);
+  else
+    for (int16_t y = clipped.top; y < clipped.bottom; y++)
+      cBlend::constRow (mFrameBuf + (y * mWidth) + clipped.left, colour, alpha, clipped.getWidth());
   }
 //}}}
 //{{{
@@ -382,89 +931,165 @@ void cLcd::rectOutline (const uint16_t colour, const cRect& r) {
 //}}}
 
 //{{{
-void cLcd::ellipse (const uint16_t colour, const uint8_t alpha, cPoint centre, cPoint radius) {
+void cLcd::roundedRect (const uint16_t colour, const uint8_t alpha, const cRect& r, int radius) {
+// corner rows as spans from integer midpoint quarter circle, middle rows as rect
 
-  if (!radius.x)
+  if (!mClip.intersects (r))
     return;
-  if (!radius.y)
+
+  int width = r.right - r.left;
+  int height = r.bottom - r.top;
+  radius = min (radius, (min (width, height) - 1) / 2);
+  if (radius <= 0) {
+    rect (colour, alpha, r);
     return;
+    }
 
-  int x1 = 0;
-  int y1 = -radius.x;
-  int err = 2 - 2*radius.x;
-  float k = (float)radius.y / radius.x;
-
-  do {
-    rect (colour, alpha, cRect (centre.x-(uint16_t)(x1 / k), centre.y + y1,
-                                centre.x-(uint16_t)(x1 / k) + 2*(uint16_t)(x1 / k) + 1, centre.y  + y1 + 1));
-    rect (colour, alpha, cRect (centre.x-(uint16_t)(x1 / k), centre.y  - y1,
-                                centre.x-(uint16_t)(x1 / k) + 2*(uint16_t)(x1 / k) + 1, centre.y  - y1 + 1));
-
-    int e2 = err;
-    if (e2 <= x1) {
-      err += ++x1 * 2 + 1;
-      if (-y1 == centre.x && e2 <= y1)
-        e2 = 0;
-      }
-    if (e2 > y1)
-      err += ++y1*2 + 1;
-    } while (y1 <= 0);
+  drawn (r);
+  sHalfWidths halfWidths (radius, radius);
+
+  // corner centres
+  int left = r.left + radius;
+  int right = r.right - 1 - radius;
+  for (int dy = 1; dy <= radius; dy++) {
+    span (colour, alpha, left - halfWidths[dy], right + halfWidths[dy] + 1, r.top + radius - dy);
+    span (colour, alpha, left - halfWidths[dy], right + halfWidths[dy] + 1, r.bottom - 1 - radius + dy);
+    }
+  rect (colour, alpha, cRect (r.left, r.top + radius, r.right, r.bottom - radius));
   }
 //}}}
 //{{{
-void cLcd::ellipseOutline (const uint16_t colour, cPoint centre, cPoint radius) {
-
-  int x = 0;
-  int y = -radius.y;
+void cLcd::roundedRectOutline (const uint16_t colour, const cRect& r, int radius) {
+// corner rows span from this row's half width to next row's, so corners have no gaps
 
-  int err = 2 - 2 * radius.x;
-  float k = (float)radius.y / (float)radius.x;
+  if (!mClip.intersects (r))
+    return;
 
-  do {
-    pix (colour, 0xFF, centre + cPoint (-(int16_t)(x / k), y));
-    pix (colour, 0xFF, centre + cPoint ((int16_t)(x / k), y));
-    pix (colour, 0xFF, centre + cPoint ((int16_t)(x / k), -y));
-    pix (colour, 0xFF, centre + cPoint (- (int16_t)(x / k), - y));
+  int width = r.right - r.left;
+  int height = r.bottom - r.top;
+  radius = min (radius, (min (width, height) - 1) / 2);
+  if (radius <= 0) {
+    rectOutline (colour, r);
+    return;
+    }
 
-    int e2 = err;
-    if (e2 <= x) {
-      err += ++x * 2 + 1;
-      if (-y == x && e2 <= y)
-        e2 = 0;
+  drawn (r);
+  sHalfWidths halfWidths (radius, radius);
+
+  // corner centres
+  int left = r.left + radius;
+  int right = r.right - 1 - radius;
+  for (int dy = 0; dy <= radius; dy++) {
+    int top = r.top + radius - dy;
+    int bottom = r.bottom - 1 - radius + dy;
+    int outer = halfWidths[dy];
+    if (dy == radius) {
+      // top and bottom edges
+      span (colour, 0xFF, left - outer, right + outer + 1, top);
+      span (colour, 0xFF, left - outer, right + outer + 1, bottom);
       }
+    else {
+      int inner = min (halfWidths[dy + 1] + 1, outer);
+      for (int y : { top, bottom }) {
+        span (colour, 0xFF, left - outer, left - inner + 1, y);
+        span (colour, 0xFF, right + inner, right + outer + 1, y);
+        }
+      }
+    }
 
-    if (e2 > y)
-      err += ++y *2 + 1;
-    } while (y <= 0);
-
+  // sides
+  rect (colour, cRect (r.left, r.top + radius + 1, r.left + 1, r.bottom - 1 - radius));
+  rect (colour, cRect (r.right - 1, r.top + radius + 1, r.right, r.bottom - 1 - radius));
   }
 //}}}
 
 //{{{
-void cLcd::line (const uint16_t colour, cPoint p1, cPoint p2) {
+void cLcd::ellipse (const uint16_t colour, const uint8_t alpha, cPoint centre, cPoint radius) {
+// integer midpoint half widths, one span per row
 
-  int16_t deltax = abs(p2.x - p1.x); // The difference between the x's
-  int16_t deltay = abs(p2.y - p1.y); // The difference between the y's
+  if ((radius.x < 0) || (radius.y < 0))
+    return;
+  if (!mClip.intersects (cRect (centre.x - radius.x, centre.y - radius.y,
+                                centre.x + radius.x + 1, centre.y + radius.y + 1)))
+    return;
 
-  cPoint p = p1;
-  cPoint inc1 ((p2.x >= p1.x) ? 1 : -1, (p2.y >= p1.y) ? 1 : -1);
-  cPoint inc2 = inc1;
+  drawn (cRect (centre.x - radius.x, centre.y - radius.y, centre.x + radius.x + 1, centre.y + radius.y + 1));
+  sHalfWidths halfWidths (radius.x, radius.y);
 
-  int16_t numAdd = (deltax >= deltay) ? deltay : deltax;
-  int16_t den = (deltax >= deltay) ? deltax : deltay;
-  if (deltax >= deltay) { // There is at least one x-value for every y-value
-    inc1.x = 0;            // Don't change the x when numerator >= denominator
-    inc2.y = 0;            // Don't change the y for every iteration
-    }
-  else {                  // There is at least one y-value for every x-value
-    inc2.x = 0;            // Don't change the x for every iteration
-    inc1.y = 0;            // Don't change the y when numerator >= denominator
+  for (int dy = 0; dy <= radius.y; dy++) {
+    int halfWidth = halfWidths[dy];
+    span (colour, alpha, centre.x - halfWidth, centre.x + halfWidth + 1, centre.y + dy);
+    if (dy)
+      span (colour, alpha, centre.x - halfWidth, centre.x + halfWidth + 1, centre.y - dy);
+    }
+  }
+//}}}
+//{{{
+void cLcd::ellipseOutline (const uint16_t colour, cPoint centre, cPoint radius) {
+// integer midpoint half widths, row spans from this row's half width to next row's, so no gaps
+
+  if ((radius.x < 0) || (radius.y < 0))
+    return;
+  if (!mClip.intersects (cRect (centre.x - radius.x, centre.y - radius.y,
+                                centre.x + radius.x + 1, centre.y + radius.y + 1)))
+    return;
+
+  drawn (cRect (centre.x - radius.x, centre.y - radius.y, centre.x + radius.x + 1, centre.y + radius.y + 1));
+  sHalfWidths halfWidths (radius.x, radius.y);
+
+  for (int dy = 0; dy <= radius.y; dy++) {
+    int outer = halfWidths[dy];
+    for (int y : { centre.y + dy, centre.y - dy }) {
+      if (dy == radius.y)
+        // top and bottom rows
+        span (colour, 0xFF, centre.x - outer, centre.x + outer + 1, y);
+      else {
+        int inner = min (halfWidths[dy + 1] + 1, outer);
+        span (colour, 0xFF, centre.x - outer, centre.x - inner + 1, y);
+        span (colour, 0xFF, centre.x + inner, centre.x + outer + 1, y);
+        }
+      if (!dy)
+        break;
+      }
+    }
+  }
+//}}}
+
+//{{{
+void cLcd::line (const uint16_t colour, cPoint p1, cPoint p2) {
+// bresenham, rejected if outside clip, per pixel clip only if partly outside
+
+  cRect bounds (min (p1.x, p2.x), min (p1.y, p2.y), max (p1.x, p2.x) + 1, max (p1.y, p2.y) + 1);
+  if (!mClip.intersects (bounds))
+    return;
+  bool inside = bounds.intersect (mClip) == bounds;
+  drawn (bounds);
+
+  int16_t deltax = abs(p2.x - p1.x); // The difference between the x's
+  int16_t deltay = abs(p2.y - p1.y); // The difference between the y's
+
+  cPoint p = p1;
+  cPoint inc1 ((p2.x >= p1.x) ? 1 : -1, (p2.y >= p1.y) ? 1 : -1);
+  cPoint inc2 = inc1;
+
+  int16_t numAdd = (deltax >= deltay) ? deltay : deltax;
+  int16_t den = (deltax >= deltay) ? deltax : deltay;
+  if (deltax >= deltay) { // There is at least one x-value for every y-value
+    inc1.x = 0;            // Don't change the x when numerator >= denominator
+    inc2.y = 0;            // Don't change the y for every iteration
+    }
+  else {                  // There is at least one y-value for every x-value
+    inc2.x = 0;            // Don't change the x for every iteration
+    inc1.y = 0;            // Don't change the y when numerator >= denominator
     }
 
   int16_t num = den / 2;
   int16_t numPixels = den;
   for (int16_t pixel = 0; pixel <= numPixels; pixel++) {
-    pix (colour, 0xFF, p);
+    if (inside && !drawNative())
+      mFrameBuf[(p.y * mWidth) + p.x] = colour;
+    else
+      pix (colour, 0xFF, p);
     num += numAdd;     // Increase the numerator by the top of the fraction
     if (num >= den) {   // Check if numerator >= denominator
       num -= den;       // Calculate the new numerator value
@@ -474,21 +1099,196 @@ void cLcd::line (const uint16_t colour, cPoint p1, cPoint p2) {
     }
   }
 //}}}
+//{{{
+void cLcd::thickLine (const uint16_t colour, const uint8_t alpha, const cPoint& p1, const cPoint& p2, const int width) {
+// line width wide with square ends, as quad scan converted to spans
+// - ends extended half width past p1 and p2, so the line covers a width square centred on each endpoint
+// - edges stepped in 32.16 fixed point from row to row, pixels inside if centre inside
+//   64 bit, endpoints far off screen and steep edges would overflow 16.16 in an int
+
+  if (width <= 0)
+    return;
+
+  float dx = p2.x - p1.x;
+  float dy = p2.y - p1.y;
+  float length = sqrtf ((dx * dx) + (dy * dy));
+  if (length == 0.f) {
+    // square
+    rect (colour, alpha, cRect (p1.x - (width / 2), p1.y - (width / 2), p1.x - (width / 2) + width, p1.y - (width / 2) + width));
+    return;
+    }
+
+  // quad around pixel centres, offset half width perpendicular, extended half width along
+  float offX = -dy / length * width * 0.5f;
+  float offY = dx / length * width * 0.5f;
+  float extX = dx / length * width * 0.5f;
+  float extY = dy / length * width * 0.5f;
+  float x1 = p1.x + 0.5f - extX;
+  float y1 = p1.y + 0.5f - extY;
+  float x2 = p2.x + 0.5f + extX;
+  float y2 = p2.y + 0.5f + extY;
+  float cornersX[4] = { x1 + offX, x2 + offX, x2 - offX, x1 - offX };
+  float cornersY[4] = { y1 + offY, y2 + offY, y2 - offY, y1 - offY };
+
+  // rows whose centres are inside quad, clipped
+  float minY = fminf (fminf (cornersY[0], cornersY[1]), fminf (cornersY[2], cornersY[3]));
+  float maxY = fmaxf (fmaxf (cornersY[0], cornersY[1]), fmaxf (cornersY[2], cornersY[3]));
+  float minX = fminf (fminf (cornersX[0], cornersX[1]), fminf (cornersX[2], cornersX[3]));
+  float maxX = fmaxf (fmaxf (cornersX[0], cornersX[1]), fmaxf (cornersX[2], cornersX[3]));
+  int yFirst = (int)fmaxf (ceilf (minY - 0.5f), mClip.top);
+  int yLast = (int)fminf (ceilf (maxY - 0.5f), mClip.bottom);
+  if ((yFirst >= yLast) || (floorf (minX) >= mClip.right) || (ceilf (maxX) <= mClip.left))
+    return;
+  drawn (cRect ((int)fmaxf (floorf (minX), mClip.left), yFirst, (int)fminf (ceilf (maxX), mClip.right), yLast));
+
+  //{{{  edges, rows clipped to yFirst..yLast, fixed point x at centre of first row and x step per row
+  struct sEdge {
+    int yTop;
+    int yBottom;
+    int64_t x;
+    int64_t xStep;
+    };
+  sEdge edges[4];
+
+  for (int i = 0; i < 4; i++) {
+    int j = (i + 1) & 3;
+    int top = cornersY[i] < cornersY[j] ? i : j;
+    int bottom = cornersY[i] < cornersY[j] ? j : i;
+
+    sEdge& edge = edges[i];
+    edge.yTop = (int)fmaxf (ceilf (cornersY[top] - 0.5f), yFirst);
+    edge.yBottom = (int)fminf (ceilf (cornersY[bottom] - 0.5f), yLast);
+    if (edge.yTop >= edge.yBottom)
+      continue;
+
+    double slope = double(cornersX[bottom] - cornersX[top]) / double(cornersY[bottom] - cornersY[top]);
+    edge.xStep = (int64_t)(slope * 65536.0);
+    edge.x = (int64_t)((cornersX[top] + ((edge.yTop + 0.5 - cornersY[top]) * slope)) * 65536.0);
+    }
+  //}}}
+
+  const int64_t clipLeft = int64_t(mClip.left) << 16;
+  const int64_t clipRight = int64_t(mClip.right) << 16;
+  for (int y = yFirst; y < yLast; y++) {
+    int64_t left = INT64_MAX;
+    int64_t right = INT64_MIN;
+    for (auto& edge : edges)
+      if ((y >= edge.yTop) && (y < edge.yBottom)) {
+        left = min (left, edge.x);
+        right = max (right, edge.x);
+        edge.x += edge.xStep;
+        }
+
+    // pixel centres x + 0.5 in [left, right), clipped before back to int
+    left = max (left, clipLeft);
+    right = min (right, clipRight + 0x8000);
+    if (left < right)
+      span (colour, alpha, int((left - 0x8000 + 0xFFFF) >> 16), int((right - 0x8000 + 0xFFFF) >> 16), y);
+    }
+  }
+//}}}
 //}}}
 //{{{  drawAA
 //{{{
 void cLcd::moveToAA (const cPointF& p) {
   mDrawAA->moveTo (int(p.x * 256.f), int(p.y * 256.f));
+  mCurAA = p;
   }
 //}}}
 //{{{
 void cLcd::lineToAA (const cPointF& p) {
   mDrawAA->lineTo (int(p.x * 256.f), int(p.y * 256.f));
+  mCurAA = p;
+  }
+//}}}
+//{{{
+void cLcd::quadToAA (const cPointF& c, const cPointF& p) {
+// flattened from current point, quarter pixel tolerance
+  cPath::flattenQuad (mCurAA, c, p, 0.25f, [&](const cPointF& point) { lineToAA (point); });
+  }
+//}}}
+//{{{
+void cLcd::cubicToAA (const cPointF& c1, const cPointF& c2, const cPointF& p) {
+  cPath::flattenCubic (mCurAA, c1, c2, p, 0.25f, [&](const cPointF& point) { lineToAA (point); });
   }
 //}}}
 //{{{
 void cLcd::renderAA (const uint16_t colour, bool fillNonZero) {
-  mDrawAA->render (colour, fillNonZero, mFrameBuf, mWidth, mHeight);
+
+  // closing edge added first, clipped paths only bound what was added
+  mDrawAA->close();
+  drawn (mDrawAA->getBounds());
+  if (drawNative())
+    mDrawAA->renderNative (colour, fillNonZero, *mNativeFrameBuf, mClip);
+  else
+    mDrawAA->render (colour, fillNonZero, mFrameBuf, mWidth, mClip);
+  }
+//}}}
+//{{{
+void cLcd::setThreadsAA (int numThreads) {
+// renderAA bands rows across numThreads, frameBuf rows disjoint so no locking
+  mDrawAA->setThreads (numThreads);
+  }
+//}}}
+
+//{{{
+void cLcd::styleAA (const uint16_t colour, bool fillNonZero) {
+// styles full, composite batch so far and start another, unstyled paths before it dropped
+
+  if (!mDrawAA->addStyle (colour, fillNonZero)) {
+    renderCompoundAA();
+    mDrawAA->addStyle (colour, fillNonZero);
+    }
+  }
+//}}}
+//{{{
+void cLcd::renderCompoundAA() {
+
+  mDrawAA->close();
+  cRect bounds = mDrawAA->getBounds();
+  if (drawNative() ? mDrawAA->renderCompoundNative (*mNativeFrameBuf, mClip)
+                   : mDrawAA->renderCompound (mFrameBuf, mWidth, mClip))
+    drawn (bounds);
+  else
+    cLog::log (LOGERROR, "renderCompoundAA paths added before first styleAA dropped");
+  }
+//}}}
+
+//{{{
+void cLcd::fillAA (const cPath& path) {
+  path.fill (*mDrawAA);
+  }
+//}}}
+//{{{
+void cLcd::strokeAA (const cPath& path, float width, cPath::eJoin join, cPath::eCap cap) {
+  path.stroke (*mDrawAA, width, join, cap);
+  }
+//}}}
+
+//{{{
+void cLcd::setMaskCache (const uint32_t maxBytes) {
+
+  if (mMaskCache)
+    mMaskCache->setMaxBytes (maxBytes);
+  else
+    mMaskCache = new cMaskCache (maxBytes);
+  }
+//}}}
+//{{{
+void cLcd::fillCachedAA (const uint16_t colour, const cPath& path, const cPointF& pos, bool fillNonZero) {
+
+  uint64_t key = cMaskCache::mix (path.getHash(), fillNonZero);
+  cachedAA (colour, path, pos, key, fillNonZero, 0.f, cPath::eMiterJoin, cPath::eButtCap);
+  }
+//}}}
+//{{{
+void cLcd::strokeCachedAA (const uint16_t colour, const cPath& path, const cPointF& pos, float width,
+                           cPath::eJoin join, cPath::eCap cap) {
+
+  uint32_t widthBits;
+  memcpy (&widthBits, &width, 4);
+  uint64_t key = cMaskCache::mix (cMaskCache::mix (path.getHash(), widthBits), 0x100 | (join << 4) | cap);
+  cachedAA (colour, path, pos, key, true, width, join, cap);
   }
 //}}}
 
@@ -515,83 +1315,274 @@ void cLcd::pointedLineAA (const cPointF& p1, const cPointF& p2, float width) {
 
 //{{{
 void cLcd::ellipseAA (const cPointF& centre, const cPointF& radius, int steps) {
+// steps 0 chosen from radius for quarter pixel error, points rotated by recurrence
 
-  // anticlockwise ellipse
-  float angle = 0.f;
-  float fstep = 360.f / steps;
-  moveToAA (centre + cPointF(radius.x, 0.f));
+  if (!steps)
+    steps = cPath::getArcSegments (max (radius.x, radius.y), 2.f * 3.1415926f, 0.25f);
+  float c = cosf (2.f * 3.1415926f / steps);
+  float s = sinf (2.f * 3.1415926f / steps);
 
-  angle += fstep;
-  while (angle < 360.f) {
-    auto radians = angle * 3.1415926f / 180.0f;
-    lineToAA (centre + cPointF (cos(radians) * radius.x, sin(radians) * radius.y));
-    angle += fstep;
+  // anticlockwise ellipse
+  float x = 1.f;
+  float y = 0.f;
+  moveToAA (centre + cPointF (radius.x, 0.f));
+  for (int i = 1; i < steps; i++) {
+    float xr = (x * c) - (y * s);
+    y = (x * s) + (y * c);
+    x = xr;
+    lineToAA (centre + cPointF (x * radius.x, y * radius.y));
     }
   }
 //}}}
 //{{{
 void cLcd::ellipseOutlineAA (const cPointF& centre, const cPointF& radius, float width, int steps) {
 
-  float angle = 0.f;
-  float fstep = 360.f / steps;
-  moveToAA (centre + cPointF(radius.x, 0.f));
+  if (!steps)
+    steps = cPath::getArcSegments (max (radius.x, radius.y), 2.f * 3.1415926f, 0.25f);
+  float c = cosf (2.f * 3.1415926f / steps);
+  float s = sinf (2.f * 3.1415926f / steps);
 
   // clockwise ellipse
-  angle += fstep;
-  while (angle < 360.f) {
-    auto radians = angle * 3.1415926f / 180.0f;
-    lineToAA (centre + cPointF (cos(radians) * radius.x, sin(radians) * radius.y));
-    angle += fstep;
+  float x = 1.f;
+  float y = 0.f;
+  moveToAA (centre + cPointF (radius.x, 0.f));
+  for (int i = 1; i < steps; i++) {
+    float xr = (x * c) - (y * s);
+    y = (x * s) + (y * c);
+    x = xr;
+    lineToAA (centre + cPointF (x * radius.x, y * radius.y));
     }
 
   // anti clockwise ellipse
-  moveToAA (centre + cPointF(radius.x - width, 0.f));
-
-  angle -= fstep;
-  while (angle > 0.f) {
-    auto radians = angle * 3.1415926f / 180.0f;
-    lineToAA (centre + cPointF (cos(radians) * (radius.x - width), sin(radians) * (radius.y - width)));
-    angle -= fstep;
+  x = 1.f;
+  y = 0.f;
+  moveToAA (centre + cPointF (radius.x - width, 0.f));
+  for (int i = 1; i < steps; i++) {
+    float xr = (x * c) + (y * s);
+    y = (y * c) - (x * s);
+    x = xr;
+    lineToAA (centre + cPointF (x * (radius.x - width), y * (radius.y - width)));
     }
   }
 //}}}
 //}}}
 //{{{
 int cLcd::text (const uint16_t colour, const cPoint& p, const int height, const string& str) {
+// baseline height below p, returns pen x rounded to pixel
+
+  cPointF pen = textAA (colour, cPointF (p), (float)height, str);
+  return (int)lroundf (pen.x);
+  }
+//}}}
+//{{{
+cPointF cLcd::textAA (const uint16_t colour, const cPointF& p, const float height, const string& str,
+                      const float angle) {
+// glyph outlines from font cache added along baseline rotated by angle, whole string composited by one render,
+// returns pen position after last glyph
+
+  if (!mTypeEnabled || !mFont) {
+    cLog::log (LOGERROR, "type not enabled");
+    return p;
+    }
+
+  float cosA = cosf (angle);
+  float sinA = sinf (angle);
+
+  // baseline origin is height below p, down rotated with text
+  cPointF pen (p.x - (height * sinA), p.y + (height * cosA));
+  for (unsigned i = 0; i < str.size(); i++) {
+    if ((angle == 0.f) && (pen.x >= mClip.right))
+      break;
+
+    const cFont::sGlyph* glyph = mFont->getGlyph ((uint8_t)str[i]);
+    mFont->addGlyph (*mDrawAA, glyph, pen, height, cosA, sinA);
+    pen = pen + cPointF (glyph->advance * height * cosA, glyph->advance * height * sinA);
+    }
+
+  renderAA (colour, true);
+
+  return pen - cPointF (-(height * sinA), height * cosA);
+  }
+//}}}
+//{{{
+cPointF cLcd::textSdf (const uint16_t colour, const cPointF& p, const float height, const string& str) {
+// glyphs sampled from signed distance field atlas, built from font on first use, baseline height below p,
+// returns pen position after last glyph
+
+  if (rejectNative ("textSdf"))
+    return p;
+
+  if (!mTypeEnabled || !mFont) {
+    cLog::log (LOGERROR, "type not enabled");
+    return p;
+    }
+
+  if (!mSdfAtlas)
+    mSdfAtlas = new cSdfAtlas (*mFont);
+
+  cPointF pen (p.x, p.y + height);
+  for (unsigned i = 0; (i < str.size()) && (pen.x < mClip.right); i++) {
+    const cSdfAtlas::sGlyph* glyph = mSdfAtlas->getGlyph ((uint8_t)str[i]);
+    if (glyph) {
+      drawn (mSdfAtlas->render (mFrameBuf, mWidth, mClip, colour, glyph, pen, height));
+      pen.x += glyph->advance * height;
+      }
+    }
+
+  return cPointF (pen.x, p.y);
+  }
+//}}}
+//{{{
+cPointF cLcd::textSubpixel (const uint16_t colour, const cPointF& p, const float height, const string& str) {
+// glyph at 3x horizontal into raw coverage, filtered across 5 subpixels into r,g,b triples in stripe order,
+// cached by codepoint, height and third pixel phase, baseline snapped to pixel, returns pen after last glyph
 
-  if (mTypeEnabled) {
-    FT_Set_Pixel_Sizes (mFace, 0, height);
+  if (!mTypeEnabled || !mFont) {
+    cLog::log (LOGERROR, "type not enabled");
+    return p;
+    }
 
-    int curX = p.x;
-    for (unsigned i = 0; (i < str.size()) && (curX < mWidth); i++) {
-      FT_Load_Char (mFace, str[i], FT_LOAD_RENDER);
-      FT_GlyphSlot slot = mFace->glyph;
+  if ((mSubpixel == eSubpixelNone) || (mRotate == e90) || (mRotate == e270) || drawNative())
+    return textAA (colour, p, height, str);
+
+  if (!mMaskCache)
+    mMaskCache = new cMaskCache (0x10000);
+
+  // stripe order along frameBuf x
+  bool bgr = (mSubpixel == eSubpixelBGR) != (mRotate == e180);
+
+  uint32_t heightBits;
+  memcpy (&heightBits, &height, 4);
+
+  float penX = p.x;
+  int y = (int)lroundf (p.y + height);
+  for (unsigned i = 0; (i < str.size()) && (penX < mClip.right); i++) {
+    uint8_t codepoint = str[i];
+    const cFont::sGlyph* glyph = mFont->getGlyph (codepoint);
+    if (glyph->numVertices) {
+      int subX = (int)floorf (penX * 3.f);
+      int x = (subX >= 0) ? subX / 3 : -((2 - subX) / 3);
+      int phase = subX - (x * 3);
+
+      uint64_t key = cMaskCache::mix (cMaskCache::mix (0x5355425049584c00ull, codepoint), heightBits);
+      key = cMaskCache::mix (key, (bgr << 2) | phase);
+
+      // bounds in subpixels, left and right whole pixels
+      const cMaskCache::sMask* mask = mMaskCache->find (key);
+      cRect bounds = mask ? mask->bounds : cRect();
+      uint8_t* tempMask = nullptr;
+      if (!mask) {
+        //{{{  miss, rasterise at 3x, filter into new mask
+        cDrawAA& maskDrawAA = mMaskCache->getDrawAA();
+        mFont->addGlyph (maskDrawAA, glyph, cPointF ((float)phase, 0.f), height, 1.f, 0.f, 0.25f, 3.f);
+        maskDrawAA.close();
+        bounds = maskDrawAA.getBounds();
+        if (bounds.isEmpty()) {
+          maskDrawAA.discard();
+          penX += glyph->advance * height;
+          continue;
+          }
 
-      int x = curX + slot->bitmap_left;
-      int y = p.y + height - slot->bitmap_top;
+        // widened by filter taps, aligned to whole pixels
+        int left = bounds.left - 2;
+        int right = bounds.right + 2;
+        bounds.left = (left >= 0) ? (left / 3) * 3 : -(((2 - left) / 3) * 3);
+        bounds.right = (right >= 0) ? ((right + 2) / 3) * 3 : -((-right / 3) * 3);
+
+        uint8_t* raw = (uint8_t*)calloc (bounds.getNumPixels(), 1);
+        maskDrawAA.renderMask (true, raw, bounds);
+
+        cMaskCache::sMask* newMask = mMaskCache->add (key, bounds);
+        if (!newMask)
+          // bigger than whole cache, temporary mask
+          tempMask = (uint8_t*)malloc (bounds.getNumPixels());
+        uint8_t* filtered = newMask ? newMask->mask : tempMask;
+
+        // light lcd filter, weights sum 256, subpixels beyond row 0
+        int width = bounds.getWidth();
+        for (int row = 0; row < bounds.getHeight(); row++) {
+          const uint8_t* src = raw + (row * width);
+          uint8_t* dst = filtered + (row * width);
+          for (int sub = 0; sub < width; sub++) {
+            int sum = (86 * src[sub]) + 128;
+            if (sub > 0)
+              sum += 77 * src[sub-1];
+            if (sub > 1)
+              sum += 8 * src[sub-2];
+            if (sub < width - 1)
+              sum += 77 * src[sub+1];
+            if (sub < width - 2)
+              sum += 8 * src[sub+2];
+            dst[sub] = sum >> 8;
+            }
 
-      if (slot->bitmap.buffer) {
-        for (unsigned bitmapY = 0; bitmapY < slot->bitmap.rows; bitmapY++) {
-          auto bitmapPtr = slot->bitmap.buffer + (bitmapY * slot->bitmap.pitch);
-          for (unsigned bitmapX = 0; bitmapX < slot->bitmap.width; bitmapX++)
-            pix (colour, *bitmapPtr++, cPoint (x + bitmapX, y + bitmapY));
+          if (bgr)
+            for (int sub = 0; sub < width; sub += 3) {
+              uint8_t swap = dst[sub];
+              dst[sub] = dst[sub+2];
+              dst[sub+2] = swap;
+              }
           }
+
+        free (raw);
+        mask = newMask;
         }
-      curX += slot->advance.x / 64;
+        //}}}
+
+      // blit triples at integer pixel
+      const uint8_t* coverage = mask ? mask->mask : tempMask;
+      cRect r (x + (bounds.left / 3), y + bounds.top, x + (bounds.right / 3), y + bounds.bottom);
+      cRect clipped = r.intersect (mClip);
+      if (!clipped.isEmpty()) {
+        drawn (clipped);
+        for (int dstY = clipped.top; dstY < clipped.bottom; dstY++)
+          cBlend::subpixelRow (mFrameBuf + (dstY * mWidth) + clipped.left, colour,
+                               coverage + ((dstY - r.top) * bounds.getWidth()) + ((clipped.left - r.left) * 3),
+                               clipped.getWidth());
+        }
+
+      free (tempMask);
       }
 
-    return curX;
+    penX += glyph->advance * height;
     }
 
-  cLog::log (LOGERROR, "type not enabled");
+  return cPointF (penX, p.y);
+  }
+//}}}
+//{{{
+cRect cLcd::measureText (const cPoint& p, const int height, const string& str) {
+// return bounding rect of glyph outlines text would draw
+
+  cRect bounds;
+  if (mTypeEnabled && mFont) {
+    float penX = (float)p.x;
+    float baseY = (float)(p.y + height);
+    for (unsigned i = 0; (i < str.size()) && (penX < mWidth); i++) {
+      const cFont::sGlyph* glyph = mFont->getGlyph ((uint8_t)str[i]);
+      if (glyph->numVertices)
+        bounds = bounds.combine (cRect ((int)floorf (penX + (glyph->topLeft.x * height)),
+                                        (int)floorf (baseY + (glyph->topLeft.y * height)),
+                                        (int)ceilf (penX + (glyph->bottomRight.x * height)),
+                                        (int)ceilf (baseY + (glyph->bottomRight.y * height))));
+      penX += glyph->advance * height;
+      }
+    }
 
-  return 0;
+  return bounds;
   }
 //}}}
 
 //{{{
 void cLcd::delayUs (const int us) {
-// delay in microSeconds
+// delay in microSeconds, from when everything queued on bus has been sent
+// - init delays after reset and sleep out must start once those commands reach the panel,
+//   a queueing bus would otherwise send them later back to back with the rest of init
+
+  mBus->submit();
+  mBus->wait();
+  if (mBus->getPending())
+    cLog::log (LOGERROR, format ("delayUs {} with {} bus commands still pending", us, mBus->getName()));
 
   gpioDelay (us);
   }
@@ -619,6 +1610,67 @@ void cLcd::reset() {
   }
 //}}}
 
+//{{{
+void cLcd::writeCommand (const uint8_t command) {
+  mBus->command (command);
+  }
+//}}}
+//{{{
+void cLcd::writeDataWord (const uint16_t data) {
+// 16bit register value, msb first on byte wide buses
+  mBus->pixels (&data, 1);
+  }
+//}}}
+//{{{
+void cLcd::writeMultiData (const uint8_t* data, int count) {
+  mBus->data (data, count);
+  }
+//}}}
+//{{{
+void cLcd::writeRows (const cRect& r) {
+// frameBuf rows in one pixelRows call, indexFrameBuf rows expanded through palette one at a time
+
+  if (mIndexFrameBuf)
+    for (int y = r.top; y < r.bottom; y++)
+      mBus->pixels (getUpdateRow (y, r.left, r.getWidth()), r.getWidth());
+  else
+    mBus->pixelRows (mFrameBuf, mWidth, r);
+  }
+//}}}
+
+//{{{
+const uint16_t* cLcd::getUpdateRow (const int y, const int left, const int width) {
+// frameBuf row, or indexFrameBuf row expanded through palette into updateRow, valid until next call
+
+  if (!mIndexFrameBuf)
+    return mFrameBuf + (y * mWidth) + left;
+
+  const uint8_t* src = mIndexFrameBuf->getRow (y) + left;
+  uint16_t* dst = mUpdateRow;
+  int i = 0;
+  for (; i + 4 <= width; i += 4, src += 4, dst += 4) {
+    dst[0] = mPalette[src[0]];
+    dst[1] = mPalette[src[1]];
+    dst[2] = mPalette[src[2]];
+    dst[3] = mPalette[src[3]];
+    }
+  for (; i < width; i++)
+    *dst++ = mPalette[*src++];
+
+  return mUpdateRow;
+  }
+//}}}
+//{{{
+uint16_t cLcd::getUpdatePixel (const int x, const int y) {
+// for column order updateLcd
+
+  if (!mIndexFrameBuf)
+    return mFrameBuf[(y * mWidth) + x];
+
+  return mPalette[mIndexFrameBuf->getRow (y)[x]];
+  }
+//}}}
+
 // cLcd private
 //{{{
 string cLcd::getInfoString() {
@@ -636,53 +1688,278 @@ string cLcd::getPaddedInfoString() {
 //}}}
 
 //{{{
-void cLcd::setFont (const uint8_t* font, const int fontSize)  {
+bool cLcd::presentNative() {
+// present nativeFrameBuf, diff on its bytes, previous frame takes only changed spans
+// - indexed palette change resends everything, nativeFrameBuf kept, so palette only swaps present without redrawing
+// - no info overlay, it would stay drawn in the retained nativeFrameBuf
+
+  double diffStartTime = timeUs();
+  sSpan* spans = mPaletteChanged ? mSpanAll : mNativeFrameBuf->diff();
+  mDiffUs = int((timeUs() - diffStartTime) * 1000000.0);
+
+  if (!spans) {
+    // nothing changed
+    mUpdateUs = 0;
+    return false;
+    }
+
+  double updateStartTime = timeUs();
+  mUpdatePixels = updateLcd (spans);
+  mUpdateUs = int((timeUs() - updateStartTime) * 1000000.0);
+  mPaletteChanged = false;
+
+  cLog::log (LOGINFO1, getInfoString());
 
-  FT_Init_FreeType (&mLibrary);
-  FT_New_Memory_Face (mLibrary, (FT_Byte*)font, fontSize, 0, &mFace);
+  mNativeFrameBuf->copy (spans);
+  return true;
   }
 //}}}
-
-// spi header classes
-//{{{
 //{{{
-cLcdSpiHeader::cLcdSpiHeader (const int16_t width, const int16_t height,
-                              const eRotate rotate, const eInfo info, const eMode mode)
-  : cLcd (width, height, rotate, info, mode) {}
+bool cLcd::rejectNative (const char* primitive) {
+// primitives with only an rgb565 path, not drawn while indexed or native, layer drawing still allowed
+
+  if (!drawNative())
+    return false;
+
+  cLog::log (LOGERROR, format ("{} not drawn, no {} path", primitive, mIndexFrameBuf ? "indexed" : "native"));
+  return true;
+  }
 //}}}
+
 //{{{
-cLcdSpiHeader::~cLcdSpiHeader() {
-  spiClose (mSpiHandle);
+void cLcd::setFont (const uint8_t* font, const int fontSize)  {
+
+  delete mFont;
+  mFont = new cFont (font, fontSize);
+  if (!mFont->isOk())
+    cLog::log (LOGERROR, "setFont - not a truetype font");
+  }
+//}}}
+//{{{
+void cLcd::cachedAA (const uint16_t colour, const cPath& path, const cPointF& pos, uint64_t key,
+                     bool fillNonZero, float width, cPath::eJoin join, cPath::eCap cap) {
+// pos split into integer pixel and quarter pixel offset, mask of path at offset found or rendered,
+// width 0 fills, mask blitted at integer pixel through its coverage
+
+  if (!mMaskCache)
+    mMaskCache = new cMaskCache (0x10000);
+
+  int x = (int)floorf (pos.x);
+  int y = (int)floorf (pos.y);
+  int subX = (int)((pos.x - x) * 4.f) & 3;
+  int subY = (int)((pos.y - y) * 4.f) & 3;
+  key = cMaskCache::mix (key, (subY << 2) | subX);
+
+  const cMaskCache::sMask* mask = mMaskCache->find (key);
+  cRect bounds = mask ? mask->bounds : cRect();
+  uint8_t* tempMask = nullptr;
+  if (!mask) {
+    // miss, render path at quarter pixel offset into new mask, path about origin so unclipped
+    cPath offsetPath (path);
+    offsetPath.translate (cPointF (subX / 4.f, subY / 4.f));
+    cDrawAA& maskDrawAA = mMaskCache->getDrawAA();
+    if (width > 0.f)
+      offsetPath.stroke (maskDrawAA, width, join, cap);
+    else
+      offsetPath.fill (maskDrawAA);
+
+    maskDrawAA.close();
+    bounds = maskDrawAA.getBounds();
+    if (bounds.isEmpty()) {
+      maskDrawAA.discard();
+      return;
+      }
+
+    cMaskCache::sMask* newMask = mMaskCache->add (key, bounds);
+    if (!newMask)
+      // bigger than whole cache, temporary mask
+      tempMask = (uint8_t*)calloc (bounds.getNumPixels(), 1);
+
+    maskDrawAA.renderMask (fillNonZero, newMask ? newMask->mask : tempMask, bounds);
+    mask = newMask;
+    }
+
+  // blit through mask coverage at integer position
+  const uint8_t* coverage = mask ? mask->mask : tempMask;
+  cRect r (bounds.left + x, bounds.top + y, bounds.right + x, bounds.bottom + y);
+  cRect clipped = r.intersect (mClip);
+  if (!clipped.isEmpty()) {
+    drawn (clipped);
+    for (int dstY = clipped.top; dstY < clipped.bottom; dstY++)
+      if (drawNative())
+        mNativeFrameBuf->maskRow (colour, clipped.left, dstY,
+                                  coverage + ((dstY - r.top) * r.getWidth()) + (clipped.left - r.left), clipped.getWidth());
+      else
+        cBlend::maskRow (mFrameBuf + (dstY * mWidth) + clipped.left, colour,
+                         coverage + ((dstY - r.top) * r.getWidth()) + (clipped.left - r.left), clipped.getWidth());
+    }
+
+  free (tempMask);
   }
 //}}}
+//{{{
+void cLcd::span (const uint16_t colour, const uint8_t alpha, int x1, int x2, const int y) {
+// row of pixels x1 to x2 exclusive, clipped
 
-constexpr uint8_t kSpiLcdCeGpio = 8;
+  if ((y < mClip.top) || (y >= mClip.bottom))
+    return;
 
+  x1 = max (x1, (int)mClip.left);
+  x2 = min (x2, (int)mClip.right);
+  if (x1 < x2) {
+    if (drawNative())
+      mNativeFrameBuf->rect (colour, alpha, cRect (x1, y, x2, y + 1));
+    else
+      cBlend::constRow (mFrameBuf + (y * mWidth) + x1, colour, alpha, x2 - x1);
+    }
+  }
+//}}}
 //{{{
-void cLcdSpiHeader::writeCommand (const uint8_t command) {
+void cLcd::copyNearest (const uint16_t* src, const uint16_t srcStride, const cRect& clipped,
+                        const int xStart, const int yStart, const int xStep, const int yStep) {
+// nearest src pixel, column offsets tabled once
 
-  // send command
-  gpioWrite (kSpiLcdCeGpio, 0);
+  int width = clipped.right - clipped.left;
+  int* xOffsets = (int*)malloc (width * sizeof(int));
+  for (int i = 0, x = xStart; i < width; i++, x += xStep)
+    xOffsets[i] = x >> 16;
 
-  const uint8_t kCommand[3] = { 0x70, 0, command };
-  spiWrite (mSpiHandle, (char*)kCommand, 3);
+  int y = yStart;
+  for (int dstY = clipped.top; dstY < clipped.bottom; dstY++, y += yStep) {
+    const uint16_t* srcRow = src + ((y >> 16) * srcStride);
+    uint16_t* dst = mFrameBuf + (dstY * mWidth) + clipped.left;
+    for (int i = 0; i < width; i++)
+      dst[i] = srcRow[xOffsets[i]];
+    }
 
-  gpioWrite (kSpiLcdCeGpio, 1);
+  free (xOffsets);
   }
 //}}}
 //{{{
-void cLcdSpiHeader::writeDataWord (const uint16_t data) {
-// send data
+void cLcd::copyBox2 (const uint16_t* src, const uint16_t srcStride, const cRect& clipped) {
+// average each 2x2 src block to one dst pixel, rounded
+// - expanded to 00000gggggg00000rrrrr000000bbbbb, 4 summed fit without carry between fields
+// - 4 dst pixels at a time in gcc vector, 2 src pixels per uint32 lane, little endian
+
+  constexpr uint32_t kMask = 0x07e0f81f;
+  constexpr uint32_t kRound = 0x00401002;
 
-  gpioWrite (kSpiLcdCeGpio, 0);
+  typedef uint32_t v4u32 __attribute__ ((vector_size (16)));
 
-  const uint8_t kData[3] = { 0x72, uint8_t(data >> 8), uint8_t(data & 0xFF) };
-  spiWrite (mSpiHandle, (char*)kData, 3);
+  int width = clipped.right - clipped.left;
+  for (int dstY = clipped.top; dstY < clipped.bottom; dstY++) {
+    const uint16_t* src0 = src + ((dstY - clipped.top) * 2 * srcStride);
+    const uint16_t* src1 = src0 + srcStride;
+    uint16_t* dst = mFrameBuf + (dstY * mWidth) + clipped.left;
 
-  gpioWrite (kSpiLcdCeGpio, 1);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+      v4u32 pair0;
+      v4u32 pair1;
+      memcpy (&pair0, src0 + (i * 2), 16);
+      memcpy (&pair1, src1 + (i * 2), 16);
+
+      v4u32 sum = ((pair0 & 0xFFFF) | (pair0 << 16)) & kMask;
+      sum += ((pair0 >> 16) | (pair0 & 0xFFFF0000)) & kMask;
+      sum += ((pair1 & 0xFFFF) | (pair1 << 16)) & kMask;
+      sum += ((pair1 >> 16) | (pair1 & 0xFFFF0000)) & kMask;
+      sum = ((sum + kRound) >> 2) & kMask;
+      sum |= sum >> 16;
+
+      dst[i] = sum[0];
+      dst[i+1] = sum[1];
+      dst[i+2] = sum[2];
+      dst[i+3] = sum[3];
+      }
+
+    for (; i < width; i++) {
+      uint32_t sum = cBlend::expand (src0[i*2]) + cBlend::expand (src0[(i*2)+1]) +
+                     cBlend::expand (src1[i*2]) + cBlend::expand (src1[(i*2)+1]);
+      sum = ((sum + kRound) >> 2) & kMask;
+      dst[i] = sum | (sum >> 16);
+      }
+    }
   }
 //}}}
+//{{{
+void cLcd::copyBilinear (const uint16_t* src, const cRect& srcRect, const uint16_t srcStride, const cRect& clipped,
+                         const int xStart, const int yStart, const int xStep, const int yStep) {
+// lerp 2x2 src pixels, weights 0..32 as blend alpha, samples clamped to srcRect edges
+// - column offsets and weights tabled once, rows lerped expanded
+
+  constexpr uint32_t kMask = 0x07e0f81f;
+
+  int width = clipped.right - clipped.left;
+  int srcWidth = srcRect.right - srcRect.left;
+  int srcHeight = srcRect.bottom - srcRect.top;
+
+  //{{{  column table
+  int* x0s = (int*)malloc (width * 2 * sizeof(int));
+  int* x1s = x0s + width;
+  uint8_t* xWeights = (uint8_t*)malloc (width);
+
+  for (int i = 0, x = xStart; i < width; i++, x += xStep) {
+    int x0 = x >> 16;
+    int weight = ((x & 0xFFFF) + 0x400) >> 11;
+    if (x < 0) {
+      x0 = 0;
+      weight = 0;
+      }
+    if (weight == 32) {
+      x0++;
+      weight = 0;
+      }
+    int x1 = min (x0 + 1, srcWidth - 1);
+    x0 = min (x0, srcWidth - 1);
+
+    x0s[i] = srcRect.left + x0;
+    x1s[i] = srcRect.left + x1;
+    xWeights[i] = weight;
+    }
+  //}}}
+
+  int y = yStart;
+  for (int dstY = clipped.top; dstY < clipped.bottom; dstY++, y += yStep) {
+    int y0 = y >> 16;
+    uint32_t yWeight = ((y & 0xFFFF) + 0x400) >> 11;
+    if (y < 0) {
+      y0 = 0;
+      yWeight = 0;
+      }
+    if (yWeight == 32) {
+      y0++;
+      yWeight = 0;
+      }
+    int y1 = min (y0 + 1, srcHeight - 1);
+    y0 = min (y0, srcHeight - 1);
+
+    const uint16_t* srcRow0 = src + ((srcRect.top + y0) * srcStride);
+    const uint16_t* srcRow1 = src + ((srcRect.top + y1) * srcStride);
+    uint16_t* dst = mFrameBuf + (dstY * mWidth) + clipped.left;
+
+    for (int i = 0; i < width; i++) {
+      uint32_t xWeight = xWeights[i];
+
+      uint32_t top = cBlend::expand (srcRow0[x0s[i]]);
+      top += (((cBlend::expand (srcRow0[x1s[i]]) - top) * xWeight) >> 5) & kMask;
+      top &= kMask;
+
+      uint32_t bottom = cBlend::expand (srcRow1[x0s[i]]);
+      bottom += (((cBlend::expand (srcRow1[x1s[i]]) - bottom) * xWeight) >> 5) & kMask;
+      bottom &= kMask;
+
+      top += (((bottom - top) * yWeight) >> 5) & kMask;
+      top &= kMask;
+      dst[i] = top | (top >> 16);
+      }
+    }
+
+  free (xWeights);
+  free (x0s);
+  }
 //}}}
+
+// spi classes
 //{{{  cLcd9320
 // 2.8 inch 240x320 - HY28A - touchcreen XT2046P
 // spi - gpio ce0, no rs - use headers, backlight
@@ -691,8 +1968,14 @@ constexpr int16_t kHeight9320 = 320;
 constexpr int kSpiClock9320 = 24000000;
 
 // public
+//{{{
 cLcd9320::cLcd9320 (eRotate rotate, eInfo info, eMode mode)
-  : cLcdSpiHeader(kWidth9320, kHeight9320, rotate, info, mode) {}
+  : cLcd9320 (rotate, info, mode, new cLcdBusSpiHeader (kSpiClock9320, kSpiCe0Gpio)) {}
+//}}}
+//{{{
+cLcd9320::cLcd9320 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus)
+  : cLcd(kWidth9320, kHeight9320, rotate, info, mode, bus) {}
+//}}}
 
 //{{{
 bool cLcd9320::initialise() {
@@ -705,12 +1988,6 @@ bool cLcd9320::initialise() {
   gpioSetMode (kSpiBacklightGpio, PI_OUTPUT);
   gpioWrite (kSpiBacklightGpio, 0);
 
-  gpioSetMode (kSpiLcdCeGpio, PI_OUTPUT);
-  gpioWrite (kSpiLcdCeGpio, 1);
-
-  // spi - we manage (ce2),(ce1),ce0 active lo, mode 3
-  mSpiHandle = spiOpen (0, kSpiClock9320, 0xE3);
-
   writeCommandData (0xE5, 0x8000); // Set the Vcore voltage
   writeCommandData (0x00, 0x0000); // start oscillation - stopped?
   writeCommandData (0x01, 0x0100); // Driver Output Control 1 - SS=1 and SM=0
@@ -788,9 +2065,6 @@ void cLcd9320::setBacklight (bool on) {
 //{{{
 uint32_t cLcd9320::updateLcd (sSpan* spans) {
 
-  uint16_t dataHeaderBuf [320+1];
-  dataHeaderBuf[0] = 0x7272;
-
   int numPixels = 0;
 
   sSpan* it = spans;
@@ -852,81 +2126,32 @@ uint32_t cLcd9320::updateLcd (sSpan* spans) {
 
     writeCommand (0x22);  // GRAM write
 
-    uint16_t* src = mFrameBuf + (it->r.top * getWidth()) + it->r.left;
-    for (int y = it->r.top; y < it->r.bottom; y++) {
-      // 2 header bytes, alignment for data bswap_16, send spi data from second header byte
-      uint16_t* dst = dataHeaderBuf + 1;
-      for (int x = it->r.left; x < it->r.right; x++)
-        *dst++ = bswap_16 (*src++);
-
-      gpioWrite (kSpiLcdCeGpio, 0);
-      spiWrite (mSpiHandle, ((char*)(dataHeaderBuf))+1, (it->r.getWidth() * 2) + 1);
-      gpioWrite (kSpiLcdCeGpio, 1);
-
-      src += getWidth() - it->r.getWidth();
-      }
-
+    writeRows (it->r);
 
     numPixels += it->r.getNumPixels();
     it = it->next;
     }
 
+  mBus->submit();
   return numPixels;
   }
 //}}}
 //}}}
 
-// spi rs pin classes
-//{{{
+//{{{  cLcd7735
+constexpr int16_t kWidth7735 = 128;
+constexpr int16_t kHeight7735 = 160;
+
+// public
 //{{{
-cLcdSpi::cLcdSpi (int16_t width, int16_t height, eRotate rotate, eInfo info, eMode mode,
-                  int spiSpeed, int registerGpio)
-  : cLcd (width, height, rotate, info, mode), mSpiSpeed(spiSpeed), mRegisterGpio(registerGpio) {}
+cLcd7735::cLcd7735 (eRotate rotate, eInfo info, eMode mode, int spiSpeed)
+  : cLcd7735 (rotate, info, mode, new cLcdBusSpi (spiSpeed, kRegisterGpio24)) {}
 //}}}
 //{{{
-cLcdSpi::~cLcdSpi() {
-  spiClose (mSpiHandle);
-  }
+cLcd7735::cLcd7735 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus)
+  : cLcd (kWidth7735, kHeight7735, rotate, info, mode, bus) {}
 //}}}
 
-// protected
-//{{{
-void cLcdSpi::writeCommand (const uint8_t command) {
-
-  gpioWrite (mRegisterGpio, 0);
-  spiWrite (mSpiHandle, (char*)(&command), 1);
-  gpioWrite (mRegisterGpio, 1);
-  }
-//}}}
-//{{{
-void cLcdSpi::writeDataWord (const uint16_t data) {
-// send data
-
-  uint16_t swappedData = bswap_16 (data);
-  spiWrite (mSpiHandle, (char*)(&swappedData), 2);
-  }
-//}}}
-//{{{
-void cLcdSpi::writeMultiData (uint8_t* data, int length) {
-// send data
-
-  while (length > 0) {
-    int sendBytes = (length > 0xFFFF) ? 0xFFFF : length;
-    spiWrite (mSpiHandle, (char*)data, sendBytes);
-    data += sendBytes;
-    length -= sendBytes;
-    }
-  }
-//}}}
-//}}}
-//{{{  cLcd7735
-constexpr int16_t kWidth7735 = 128;
-constexpr int16_t kHeight7735 = 160;
-
-cLcd7735::cLcd7735 (eRotate rotate, eInfo info, eMode mode, int spiSpeed)
-  : cLcdSpi (kWidth7735, kHeight7735, rotate, info, mode, spiSpeed, kRegisterGpio24) {}
-
-// public
 //{{{
 bool cLcd7735::initialise() {
 
@@ -934,13 +2159,6 @@ bool cLcd7735::initialise() {
     return false;
   reset();
 
-  // rs
-  gpioSetMode (mRegisterGpio, PI_OUTPUT);
-  gpioWrite (mRegisterGpio, 1);
-
-  // mode 0, spi manages ce0 active lo
-  mSpiHandle = spiOpen (0, mSpiSpeed, 0);
-
   writeCommand (0x11); // SLPOUT
   delayUs (120000);
 
@@ -1010,7 +2228,6 @@ bool cLcd7735::initialise() {
 uint32_t cLcd7735::updateLcd (sSpan* spans) {
 // ignore spans, send everything
 
-  uint16_t swappedFrameBuf [kWidth7735];
   uint8_t data[4] = { 0,0, 0,0 };
 
   int numPixels = 0;
@@ -1075,19 +2292,13 @@ uint32_t cLcd7735::updateLcd (sSpan* spans) {
 
     writeCommand (0x2C);  // GRAM write
 
-    uint16_t* src = mFrameBuf + (it->r.top * getWidth()) + it->r.left;
-    for (int y = it->r.top; y < it->r.bottom; y++) {
-      uint16_t* dst = swappedFrameBuf;
-      for (int x = it->r.left; x < it->r.right; x++)
-        *dst++ = bswap_16 (*src++);
-      spiWrite (mSpiHandle, (char*)swappedFrameBuf, it->r.getWidth() * 2);
-      src += getWidth() - it->r.getWidth();
-      }
+    writeRows (it->r);
 
     numPixels += it->r.getNumPixels();
     it = it->next;
     }
 
+  mBus->submit();
   return numPixels;
   }
 //}}}
@@ -1097,8 +2308,14 @@ constexpr int16_t kWidth9225 = 176;
 constexpr int16_t kHeight9225 = 220;
 
 // public
+//{{{
 cLcd9225::cLcd9225 (eRotate rotate, eInfo info, eMode mode, int spiSpeed)
-  : cLcdSpi(kWidth9225, kHeight9225, rotate, info, mode, spiSpeed, kRegisterGpio24) {}
+  : cLcd9225 (rotate, info, mode, new cLcdBusSpi (spiSpeed, kRegisterGpio24)) {}
+//}}}
+//{{{
+cLcd9225::cLcd9225 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus)
+  : cLcd (kWidth9225, kHeight9225, rotate, info, mode, bus) {}
+//}}}
 
 //{{{
 bool cLcd9225::initialise() {
@@ -1107,13 +2324,6 @@ bool cLcd9225::initialise() {
     return false;
   reset();
 
-  // rs
-  gpioSetMode (mRegisterGpio, PI_OUTPUT);
-  gpioWrite (mRegisterGpio, 1);
-
-  // mode 0, spi manages ce0 active lo
-  mSpiHandle = spiOpen (0, mSpiSpeed, 0x00);
-
   writeCommandData (0x01, 0x011C); // set SS and NL bit
 
   writeCommandData (0x02, 0x0100); // set 1 line inversion
@@ -1183,14 +2393,10 @@ uint32_t cLcd9225::updateLcd (sSpan* spans) {
   writeCommandData (0x20, 0);         // H GRAM start
   writeCommandData (0x21, 0);         // V GRAM start
 
-  uint16_t swappedFrameBuf [kWidth9225 * kHeight9225];
+  writeCommand (0x22); // GRAM write
+  writeRows (getRect());
 
-  uint16_t* src = mFrameBuf;
-  uint16_t* dst = swappedFrameBuf;
-  for (uint32_t i = 0; i < getNumPixels(); i++)
-    *dst++ = bswap_16 (*src++);
-
-  writeCommandMultiData (0x22, (uint8_t*)swappedFrameBuf, getNumPixels() * 2); // GRAM write command
+  mBus->submit();
   return getNumPixels();
   }
 //}}}
@@ -1200,8 +2406,14 @@ constexpr int16_t k9341Width = 240;
 constexpr int16_t k9341Height = 320;
 
 // public
+//{{{
 cLcd9341::cLcd9341 (eRotate rotate, eInfo info, eMode mode, int spiSpeed)
-  : cLcdSpi(k9341Width, k9341Height, rotate, info, mode, spiSpeed, kRegisterGpio26) {}
+  : cLcd9341 (rotate, info, mode, new cLcdBusAuxSpi (spiSpeed, kRegisterGpio26)) {}
+//}}}
+//{{{
+cLcd9341::cLcd9341 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus)
+  : cLcd (k9341Width, k9341Height, rotate, info, mode, bus) {}
+//}}}
 
 //{{{
 bool cLcd9341::initialise() {
@@ -1209,45 +2421,6 @@ bool cLcd9341::initialise() {
   if (!cLcd::initialise())
     return false;
 
-  // registerSelect - data
-  gpioSetMode (mRegisterGpio, PI_OUTPUT);
-  gpioWrite (mRegisterGpio, 1);
-
-  //{{{  spiFlags
-  // 21 20 19 18 17 16 15 14 13 12 11 10  9  8  7  6  5  4  3  2  1  0
-  //  b  b  b  b  b  b  R  T  n  n  n  n  W  A u2 u1 u0 p2 p1 p0  m  m
-
-    //mm defines the SPI mode, modes 1,3 do not appear to work on the auxiliary SPI.
-      //Mode POL PHA
-       //0    0   0
-       //1    0   1
-       //2    1   0
-       //3    1   1
-
-    //px = 0 if CEx is active low (default), 1 = active high.
-
-    //ux = 0 CEx GPIO is reserved for SPI (default), 1 otherwise.
-
-    //A = 0 main SPI, 1 for the auxiliary SPI.
-
-    //W = 0 if the device is not 3-wire, 1 if the device is 3-wire. Main SPI only.
-      //nnnn = number of bytes (0-15) to write before switching MOSI line to MISO to read data.
-             //This field is ignored if W is not set.  Main SPI only.
-
-    //T = 1 if the least significant bit is transmitted on MOSI first
-          //default (0) shifts the most significant bit out first.  Auxiliary SPI only.
-
-    //R = 1 if the least significant bit is received on MISO first
-          //default (0) receives the most significant bit first.  Auxiliary SPI only.
-
-    //bbbbbb = word size in bits (0-32).  The default (0) sets 8 bits per word.  Auxiliary SPI only.
-  //}}}
-  // mode 0, main spi manages ce0 active lo
-  //mSpiHandle = spiOpen (0, mSpiSpeed, 0x00);
-
-  // mode 0, aux spi manages ce2 active lo
-  mSpiHandle = spiOpen (2, mSpiSpeed, 0x0160);
-
   writeCommand (0x01); // rely on software reset, no hw reset
   delayUs (5000);
 
@@ -1292,7 +2465,7 @@ bool cLcd9341::initialise() {
   //constexpr uint8_t kML  = 0x10; // lcd vertical refresh
   //constexpr uint8_t kMH  = 0x04; // lcd horizontal refresh
 
-  uint8_t madParam;
+  uint8_t madParam = 0;
   switch (mRotate) {
     case e0:   madParam = kBgr; break;
     case e180: madParam = kMY | kMX | kBgr; break;
@@ -1357,47 +2530,167 @@ bool cLcd9341::initialise() {
 //{{{
 uint32_t cLcd9341::updateLcd (sSpan* spans) {
 // usually many small spans, with the occasional large span
+// - columns widened only when bus getPixelAlign asks, dma bus 2 so each row is whole 32bit words, others untouched
 
   constexpr uint8_t kColumnAddressSetCommand = 0x2A;
   constexpr uint8_t kPageAddressSetCommand = 0x2B;
   constexpr uint8_t kMemoryWriteCommand = 0x2C;
 
+  const int alignMask = mBus->getPixelAlign() - 1;
+
   int numPixels = 0;
   for (sSpan* span = spans; span; span = span->next) {
-    int16_t columnAddressSetParams[2] = { span->r.left, int16_t(span->r.right-1) };
-    int16_t pageAddressSetParams[2] = { span->r.top, int16_t(span->r.bottom-1) };
-
-    //writeCommandMultiData (kColumnAddressSetCommand, (uint8_t*)columnAddressSetParams, 4);
-    gpioWrite (mRegisterGpio, 0);
-    spiWriteAuxFast (&kColumnAddressSetCommand, 1);
-    gpioWrite (mRegisterGpio, 1);
-    spiWriteAuxFast ((uint8_t*)columnAddressSetParams, 4);
-
-    //writeCommandMultiData (kPageAddressSetCommand, (uint8_t*)pageAddressSetParams, 4);
-    gpioWrite (mRegisterGpio, 0);
-    spiWriteAuxFast (&kPageAddressSetCommand, 1);
-    gpioWrite (mRegisterGpio, 1);
-    spiWriteAuxFast ((uint8_t*)pageAddressSetParams, 4);
-
-    //writeCommand (kMemoryWriteCommand);
-    //uint16_t* src = mFrameBuf + (span->r.top * getWidth()) + span->r.left;
-    //for (int y = 0; y < span->r.getHeight(); y++) {
-    //  writeMultiData ((uint8_t*)src, span->r.getWidth() * 2);
-    //  src += getWidth();
-    //  }
-    gpioWrite (mRegisterGpio, 0);
-    spiWriteAuxFast (&kMemoryWriteCommand, 1);
-    gpioWrite (mRegisterGpio, 1);
-
-    uint16_t* src = mFrameBuf + (span->r.top * getWidth()) + span->r.left;
-    for (int y = 0; y < span->r.getHeight(); y++) {
-      spiWriteAuxFast ((uint8_t*)src, span->r.getWidth() * 2);
-      src += getWidth();
-      }
+    cRect r = span->r;
+    r.left &= ~alignMask;
+    r.right = min ((r.right + alignMask) & ~alignMask, (int)mWidth);
+
+    const uint8_t columnAddressSetParams[4] = { uint8_t(r.left >> 8), uint8_t(r.left),
+                                                uint8_t((r.right-1) >> 8), uint8_t(r.right-1) };
+    const uint8_t pageAddressSetParams[4] = { uint8_t(r.top >> 8), uint8_t(r.top),
+                                              uint8_t((r.bottom-1) >> 8), uint8_t(r.bottom-1) };
+
+    writeCommandMultiData (kColumnAddressSetCommand, columnAddressSetParams, 4);
+    writeCommandMultiData (kPageAddressSetCommand, pageAddressSetParams, 4);
+
+    writeCommand (kMemoryWriteCommand);
+    writeRows (r);
 
-    numPixels += span->r.getNumPixels();
+    numPixels += r.getNumPixels();
     }
 
+  mBus->submit();
+  return numPixels;
+  }
+//}}}
+//}}}
+//{{{  cLcd9341dma
+//{{{
+cLcd9341dma::cLcd9341dma (const eRotate rotate, const eInfo info, const eMode mode, const int spiSpeed)
+  : cLcd9341 (rotate, info, mode, new cLcdBusDmaSpi (spiSpeed, kRegisterGpio24)) {}
+//}}}
+//}}}
+//{{{  cLcd9486
+constexpr int16_t k9486Width = 320;
+constexpr int16_t k9486Height = 480;
+
+// public
+//{{{
+cLcd9486::cLcd9486 (const eRotate rotate, const eInfo info, const eMode mode, const int spiSpeed)
+  : cLcd9486 (rotate, info, mode, new cLcdBusSpi (spiSpeed, kRegisterGpio24)) {}
+//}}}
+//{{{
+cLcd9486::cLcd9486 (const eRotate rotate, const eInfo info, const eMode mode, cLcdBus* bus)
+  : cLcd (k9486Width, k9486Height, rotate, info, mode, bus) {}
+//}}}
+//{{{
+cLcd9486::~cLcd9486() {
+  free (mIndexedRow);
+  }
+//}}}
+
+//{{{
+bool cLcd9486::initialise() {
+
+  // drawn natively, before cLcd::initialise so it allocates no rgb565 frameBuf
+  mNativeFrameBuf = new cFrameBuf<cRgb666> (mWidth, mHeight);
+  mIndexedRow = (uint8_t*)malloc (cRgb666::getRowBytes (mWidth));
+  if (!cLcd::initialise())
+    return false;
+
+  writeCommand (0x01); // rely on software reset, no hw reset
+  delayUs (120000);
+
+  writeCommand (0x11); // sleep out
+  delayUs (120000);
+
+  uint8_t k9486xB0 = 0x00;
+  writeCommandMultiData (0xB0, &k9486xB0, 1); // Interface Mode Control
+
+  uint8_t k9486x3A = 0x66;
+  writeCommandMultiData (0x3A, &k9486x3A, 1); // Pixel format 18bits/pixel, only one spi takes
+
+  //{{{  power, vcom
+  uint8_t k9486xC2 = 0x44;
+  writeCommandMultiData (0xC2, &k9486xC2, 1); // Power Control 3
+
+  uint8_t k9486xC5[] = { 0x00, 0x00, 0x00, 0x00 };
+  writeCommandMultiData (0xC5, k9486xC5, sizeof(k9486xC5)); // VCOM Control
+  //}}}
+  //{{{  gamma
+  uint8_t k9486xE0[] = { 0x0F, 0x1F, 0x1C, 0x0C, 0x0F, 0x08, 0x48, 0x98, 0x37, 0x0A, 0x13, 0x04, 0x11, 0x0D, 0x00 };
+  writeCommandMultiData (0xE0, k9486xE0, sizeof(k9486xE0)); // positive gamma correction
+
+  uint8_t k9486xE1[] = { 0x0F, 0x32, 0x2E, 0x0B, 0x0D, 0x05, 0x47, 0x75, 0x37, 0x06, 0x10, 0x03, 0x24, 0x20, 0x00 };
+  writeCommandMultiData (0xE1, k9486xE1, sizeof(k9486xE1)); // negative gamma correction
+  //}}}
+
+  writeCommand (0x20); // Display inversion off
+
+  //{{{  madctl param
+  constexpr uint8_t kMY  = 0x80; // memory row address order swap
+  constexpr uint8_t kMX  = 0x40; // memory column address order swap
+  constexpr uint8_t kMV  = 0x20; // memory row column exchange
+  constexpr uint8_t kBgr = 0x08;
+
+  uint8_t madParam = 0;
+  switch (mRotate) {
+    case e0:   madParam = kMX | kBgr; break;
+    case e180: madParam = kMY | kBgr; break;
+    case e90:  madParam = kMV | kBgr; break;
+    case e270: madParam = kMY | kMX | kMV | kBgr; break;
+    }
+  //}}}
+  writeCommandMultiData (0x36, &madParam, 1); // MADCTL Memory Access Control
+
+  writeCommand (0x29); // Display on
+  delayUs (50000);
+
+  updateLcd (mSpanAll);
+
+  return true;
+  }
+//}}}
+
+// protected
+//{{{
+uint32_t cLcd9486::updateLcd (sSpan* spans) {
+// span rows of nativeFrameBuf sent as they are, whole width spans in one data write
+// - indexed, rows expanded through palette and converted to rgb666 a row at a time into scratch row
+
+  constexpr uint8_t kColumnAddressSetCommand = 0x2A;
+  constexpr uint8_t kPageAddressSetCommand = 0x2B;
+  constexpr uint8_t kMemoryWriteCommand = 0x2C;
+
+  int numPixels = 0;
+  for (sSpan* span = spans; span; span = span->next) {
+    const cRect& r = span->r;
+    const uint8_t columnAddressSetParams[4] = { uint8_t(r.left >> 8), uint8_t(r.left),
+                                                uint8_t((r.right-1) >> 8), uint8_t(r.right-1) };
+    const uint8_t pageAddressSetParams[4] = { uint8_t(r.top >> 8), uint8_t(r.top),
+                                              uint8_t((r.bottom-1) >> 8), uint8_t(r.bottom-1) };
+
+    writeCommandMultiData (kColumnAddressSetCommand, columnAddressSetParams, 4);
+    writeCommandMultiData (kPageAddressSetCommand, pageAddressSetParams, 4);
+
+    writeCommand (kMemoryWriteCommand);
+    const int rowBytes = cRgb666::getRowBytes (r.getWidth());
+    if (getIndexed())
+      for (int y = r.top; y < r.bottom; y++) {
+        const uint16_t* src = getUpdateRow (y, r.left, r.getWidth());
+        for (int x = 0; x < r.getWidth(); x++)
+          cRgb666::setPixel (mIndexedRow, x, cRgb666::fromRgb565 (src[x]));
+        writeMultiData (mIndexedRow, rowBytes);
+        }
+    else if (rowBytes == mNativeFrameBuf->getStride())
+      writeMultiData (mNativeFrameBuf->getRow (r.top), rowBytes * r.getHeight());
+    else
+      for (int y = r.top; y < r.bottom; y++)
+        writeMultiData (mNativeFrameBuf->getRow (y) + cRgb666::getRowBytes (r.left), rowBytes);
+
+    numPixels += r.getNumPixels();
+    }
+
+  mBus->submit();
   return numPixels;
   }
 //}}}
@@ -1409,8 +2702,14 @@ constexpr int16_t kWidth1289 = 240;
 constexpr int16_t kHeight1289 = 320;
 
 // public
+//{{{
 cLcd1289::cLcd1289 (eRotate rotate, eInfo info, eMode mode)
-  : cLcd(kWidth1289, kHeight1289, rotate, info, mode) {}
+  : cLcd1289 (rotate, info, mode, new cLcdBusParallel16 (k16WriteGpio, kRegisterGpio24, k16ReadGpio)) {}
+//}}}
+//{{{
+cLcd1289::cLcd1289 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus)
+  : cLcd (kWidth1289, kHeight1289, rotate, info, mode, bus) {}
+//}}}
 
 //{{{
 bool cLcd1289::initialise() {
@@ -1419,23 +2718,6 @@ bool cLcd1289::initialise() {
     return false;
   reset();
 
-  // wr
-  gpioSetMode (k16WriteGpio, PI_OUTPUT);
-  gpioWrite (k16WriteGpio, 1);
-
-  // rd - unused
-  gpioSetMode (k16ReadGpio, PI_OUTPUT);
-  gpioWrite (k16ReadGpio, 1);
-
-  // rs
-  gpioSetMode (kRegisterGpio24, PI_OUTPUT);
-  gpioWrite (kRegisterGpio24, 1);
-
-  // 16 d0-d15
-  for (int i = 0; i < 16; i++)
-    gpioSetMode (i, PI_OUTPUT);
-  gpioWrite_Bits_0_31_Clear (k16DataMask);
-
   // startup commands
   writeCommandData (0x00, 0x0001); // OSCILLATION
   //{{{  power control
@@ -1508,43 +2790,6 @@ bool cLcd1289::initialise() {
 //}}}
 
 // protected
-//{{{
-void cLcd1289::writeCommand (const uint8_t command) {
-// slow down write
-
-  gpioWrite (kRegisterGpio24, 0);
-
-  gpioWrite_Bits_0_31_Clear (~command & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-  //gpioWrite_Bits_0_31_Clear (~command & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-  //gpioWrite_Bits_0_31_Clear (~command & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-
-  gpioWrite_Bits_0_31_Set (command);                      // set hi data bits
-  gpioWrite_Bits_0_31_Set (command);                      // set hi data bits
-  gpioWrite_Bits_0_31_Set (command);                      // set hi data bits
-
-  gpioWrite_Bits_0_31_Set (k16WriteMask);                 // write on k16WrGpio rising edge
-  gpioWrite_Bits_0_31_Set (k16WriteMask);                 // write on k16WrGpio rising edge
-
-  gpioWrite (kRegisterGpio24, 1);
-  }
-//}}}
-//{{{
-void cLcd1289::writeDataWord (const uint16_t data) {
-// slow down write
-
-  gpioWrite_Bits_0_31_Clear (~data & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-  //gpioWrite_Bits_0_31_Clear (~command & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-  //gpioWrite_Bits_0_31_Clear (~command & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-
-  gpioWrite_Bits_0_31_Set (data);                      // set hi data bits
-  gpioWrite_Bits_0_31_Set (data);                      // set hi data bits
-  gpioWrite_Bits_0_31_Set (data);                      // set hi data bits
-
-  gpioWrite_Bits_0_31_Set (k16WriteMask);              // write on k16WrGpio rising edge
-  gpioWrite_Bits_0_31_Set (k16WriteMask);              // write on k16WrGpio rising edge
-  }
-//}}}
-
 //{{{
 uint32_t cLcd1289::updateLcd (sSpan* spans) {
 
@@ -1595,16 +2840,12 @@ uint32_t cLcd1289::updateLcd (sSpan* spans) {
 
     writeCommand (0x22);
 
-    uint16_t* src = mFrameBuf + (it->r.top * getWidth()) + it->r.left;
-    for (int16_t y = it->r.top; y < it->r.bottom; y++) {
-      for (int16_t x = it->r.left; x < it->r.right; x++)
-        writeDataWord (*src++);
-      src += getWidth() - it->r.getWidth();
-      }
+    writeRows (it->r);
 
     numPixels += it->r.getNumPixels();
     }
 
+  mBus->submit();
   return numPixels;
   }
 //}}}
@@ -1619,7 +2860,12 @@ constexpr int16_t kHeight7601 = 480;
 // public
 //{{{
 cLcd7601::cLcd7601 (const eRotate rotate, const eInfo info, const eMode mode)
-  : cLcd(kWidth7601, kHeight7601, rotate, info, mode) {}
+  : cLcd7601 (rotate, info, mode,
+              new cLcdBusParallel16 (k16WriteGpio, kRegisterGpio24, k16ReadGpio, k16ChipSelectGpio)) {}
+//}}}
+//{{{
+cLcd7601::cLcd7601 (const eRotate rotate, const eInfo info, const eMode mode, cLcdBus* bus)
+  : cLcd (kWidth7601, kHeight7601, rotate, info, mode, bus) {}
 //}}}
 
 //{{{
@@ -1629,31 +2875,10 @@ bool cLcd7601::initialise() {
     return false;
   reset();
 
-  // wr
-  gpioSetMode (k16WriteGpio, PI_OUTPUT);
-  gpioWrite (k16WriteGpio, 1);
-
-  // rd - unused
-  gpioSetMode (k16ReadGpio, PI_OUTPUT);
-  gpioWrite (k16ReadGpio, 1);
-
-  // rs
-  gpioSetMode (kRegisterGpio24, PI_OUTPUT);
-  gpioWrite (kRegisterGpio24, 1);
-
-  // chipSelect
-  gpioSetMode (k16ChipSelectGpio, PI_OUTPUT);
-  gpioWrite (k16ChipSelectGpio, 0);
-
   // backlight
   gpioSetMode (k16BacklightGpio, PI_OUTPUT);
   gpioWrite (k16BacklightGpio, 0);
 
-  // 16 d0-d15
-  for (int i = 0; i < 16; i++)
-    gpioSetMode (i, PI_OUTPUT);
-  gpioWrite_Bits_0_31_Clear (k16DataMask);
-
   // portrait mode (0,0) top left, top is side opposite the connector.
   writeCommandData (0x01, 0x023C); // gate_scan & display boundary
   writeCommandData (0x02, 0x0100); // inversion
@@ -1720,43 +2945,6 @@ void cLcd7601::setBacklight (bool on) {
 //}}}
 
 // protected
-//{{{
-void cLcd7601::writeCommand (const uint8_t command) {
-// slow down write
-
-  gpioWrite (kRegisterGpio24, 0);
-
-  gpioWrite_Bits_0_31_Clear (~command & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-  gpioWrite_Bits_0_31_Clear (~command & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-  gpioWrite_Bits_0_31_Clear (~command & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-
-  gpioWrite_Bits_0_31_Set (command);                      // set hi data bits
-  gpioWrite_Bits_0_31_Set (command);                      // set hi data bits
-  gpioWrite_Bits_0_31_Set (command);                      // set hi data bits
-
-  gpioWrite_Bits_0_31_Set (k16WriteMask);                 // write on k16WrGpio rising edge
-  gpioWrite_Bits_0_31_Set (k16WriteMask);                 // write on k16WrGpio rising edge
-
-  gpioWrite (kRegisterGpio24, 1);
-  }
-//}}}
-//{{{
-void cLcd7601::writeDataWord (const uint16_t data) {
-// slow down write
-
-  gpioWrite_Bits_0_31_Clear (~data & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-  gpioWrite_Bits_0_31_Clear (~data & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-  gpioWrite_Bits_0_31_Clear (~data & k16WriteClrMask); // clear lo data bits + k16WrGpio bit lo
-
-  gpioWrite_Bits_0_31_Set (data);                      // set hi data bits
-  gpioWrite_Bits_0_31_Set (data);                      // set hi data bits
-  gpioWrite_Bits_0_31_Set (data);                      // set hi data bits
-
-  gpioWrite_Bits_0_31_Set (k16WriteMask);              // write on k16WrGpio rising edge
-  gpioWrite_Bits_0_31_Set (k16WriteMask);              // write on k16WrGpio rising edge
-  }
-//}}}
-
 //{{{
 uint32_t cLcd7601::updateLcd (sSpan* spans) {
 
@@ -1780,12 +2968,7 @@ uint32_t cLcd7601::updateLcd (sSpan* spans) {
         writeCommandData (0x21, r.left);     // GRAM H start address
         writeCommand (0x22);                 // GRAM write
 
-        uint16_t* ptr = mFrameBuf + (r.top * kWidth7601) + r.left;
-        for (int16_t y = r.top; y < r.bottom; y++) {
-          for (int16_t x = r.left; x < r.right; x++)
-            writeDataWord (*ptr++);
-          ptr += kWidth7601 - r.getWidth();
-          }
+        writeRows (r);
 
         numPixels += r.getNumPixels();
         }
@@ -1810,13 +2993,9 @@ uint32_t cLcd7601::updateLcd (sSpan* spans) {
         writeCommandData (0x21, r.top);                    // GRAM H start address
         writeCommand (0x22);                               // GRAM write
 
-        for (int16_t x = r.right-1; x >= r.left; x--) {
-          uint16_t* ptr = mFrameBuf + (r.top * kHeight7601) + x;
-          for (int16_t y = r.top; y < r.bottom; y++) {
-            writeDataWord (*ptr);
-            ptr += kHeight7601;
-            }
-          }
+        for (int16_t x = r.right-1; x >= r.left; x--)
+          for (int16_t y = r.top; y < r.bottom; y++)
+            writeDataWord (getUpdatePixel (x, y));
 
         numPixels += r.getNumPixels();
         }
@@ -1841,11 +3020,10 @@ uint32_t cLcd7601::updateLcd (sSpan* spans) {
         writeCommandData (0x21, kWidth7601 - r.right);   // GRAM H start address
         writeCommand (0x22);                               // GRAM write
 
-        uint16_t* ptr = mFrameBuf + ((r.bottom-1) * kWidth7601) + r.right-1;
         for (int16_t y = r.bottom-1; y >= r.top; y--) {
+          const uint16_t* ptr = getUpdateRow (y, r.left, r.getWidth()) + r.getWidth()-1;
           for (int16_t x = r.right-1; x >= r.left; x--)
             writeDataWord (*ptr--);
-          ptr -= kWidth7601 - r.getWidth();
           }
 
         numPixels += r.getNumPixels();
@@ -1871,13 +3049,9 @@ uint32_t cLcd7601::updateLcd (sSpan* spans) {
         writeCommandData (0x21, kWidth7601 - r.bottom); // GRAM H start address
         writeCommand (0x22);                              // GRAM write
 
-        for (int16_t x = r.left; x < r.right; x++) {
-          uint16_t* ptr = mFrameBuf + ((r.bottom-1) * kHeight7601) + x;
-          for (int16_t y = r.bottom-1; y >= r.top; y--) {
-            writeDataWord (*ptr);
-            ptr -= kHeight7601;
-            }
-          }
+        for (int16_t x = r.left; x < r.right; x++)
+          for (int16_t y = r.bottom-1; y >= r.top; y--)
+            writeDataWord (getUpdatePixel (x, y));
 
         numPixels += r.getNumPixels();
         }
@@ -1887,475 +3061,24 @@ uint32_t cLcd7601::updateLcd (sSpan* spans) {
     //}}}
     }
 
+  mBus->submit();
   return numPixels;
   }
 //}}}
 //}}}
 //{{{  cLcd9341p8
-constexpr uint8_t k9341p8WrGpio = 23; // wr
-constexpr uint32_t k9341p8WrMask = 1 << k9341p8WrGpio; // wrGpio mask
-
-constexpr uint8_t k9341p8RsGpio = 22; // rs
-constexpr uint32_t k9341p8RsMask = 1 << k9341p8RsGpio; // rsGpio mask
-
-constexpr uint32_t k9341p8DataMask = 0x000030FC; // 8Databit mask - gpio13 gpio12 gpio7 gpio6 gpio5 gpio4 gpio3 gpio2
-constexpr uint32_t k9341p8WrDataMask = k9341p8WrMask | k9341p8DataMask; // wr,8Databit mask
-constexpr uint32_t k9341p8WrRsDataMask = k9341p8WrMask | k9341p8RsMask | k9341p8DataMask; // wr,rs,8bitData mask
-
-// public
 //{{{
 cLcd9341p8::cLcd9341p8 (const eRotate rotate, const eInfo info, const eMode mode)
-  : cLcd(k9341Width, k9341Height, rotate, info, mode) {}
-//}}}
-
-//{{{
-bool cLcd9341p8::initialise() {
-
-  if (!cLcd::initialise())
-    return false;
-
-  // wr - normally hi
-  gpioSetMode (k9341p8WrGpio, PI_OUTPUT);
-  gpioWrite (k9341p8WrGpio, 1);
-
-  // rs - normally hi data
-  gpioSetMode (k9341p8RsGpio, PI_OUTPUT);
-  gpioWrite (k9341p8RsGpio, 1);
-
-  // 8bit data output gpio
-  gpioSetMode (2, PI_OUTPUT);
-  gpioSetMode (3, PI_OUTPUT);
-  gpioSetMode (4, PI_OUTPUT);
-  gpioSetMode (5, PI_OUTPUT);
-  gpioSetMode (6, PI_OUTPUT);
-  gpioSetMode (7, PI_OUTPUT);
-  gpioSetMode (12, PI_OUTPUT);
-  gpioSetMode (13, PI_OUTPUT);
-  gpioWrite_Bits_0_31_Clear (k9341p8DataMask);
-
-  writeCommand (0x01); // rely on software reset, no hw reset
-  delayUs (5000);
-
-  writeCommand (0x11); // sleep out
-  delayUs (120000);
-
-  //{{{  power, driver, vcom
-  uint8_t k9341xCF[] = { 0x00, 0x83, 0x30 };
-  writeCommandMultiData (0xCF, k9341xCF, sizeof(k9341xCF)); // Power Control B
-
-  uint8_t k9341xED[] = { 0x64, 0x03, 0x12, 0x81 };
-  writeCommandMultiData (0xED, k9341xED, sizeof(k9341xED)); // Power On Sequence Control
-
-  uint8_t k9341xE8[] = { 0x85, 0x01, 0x79 };
-  writeCommandMultiData (0xE8, k9341xE8, sizeof(k9341xE8)); // Driver Timing Control A
-
-  uint8_t k9341xCB[] = { 0x39, 0x2C, 0x00, 0x34, 0x02 };
-  writeCommandMultiData (0xCB, k9341xCB, sizeof(k9341xCB)); // Driver Timing Control B
-
-  uint8_t k9341xF7 = 0x20;
-  writeCommandMultiData (0xF7, &k9341xF7, 1);  // Pump Ratio Control
-
-  uint8_t k9341xEA[] = { 0x00, 0x00 };
-  writeCommandMultiData (0xEA, k9341xEA, sizeof(k9341xEA)); // Driver Timing Control B
-
-  // 0xC0 Power Control 1 0x23 VRH=4.60V // Set the GVDD level, which is a reference level for the VCOM level and the grayscale voltage level.
-  uint8_t k9341xC1[] = { 0x11 };
-  writeCommandMultiData (0xC1, k9341xC1, sizeof(k9341xC1)); // Power control 2 SAP[2:0];BT[3:0]
-
-  uint8_t k9341xC5[] = { 0x34, 0x3D };
-  writeCommandMultiData (0xC5, k9341xC5, sizeof(k9341xC5)); // VCM control 1
-
-  uint8_t k9341xC7[] = { 0xC0 };
-  writeCommandMultiData (0xC7, k9341xC7, sizeof(k9341xC7)); // VCM control 2
-  //}}}
-
-  //{{{  madctl param
-  constexpr uint8_t kMY  = 0x80; // memory row address order swap
-  constexpr uint8_t kMX  = 0x40; // memory column address order swap
-  constexpr uint8_t kMV  = 0x20; // memory row column exchange
-  constexpr uint8_t kBgr = 0x08;
-  //constexpr uint8_t kML  = 0x10; // lcd vertical refresh
-  //constexpr uint8_t kMH  = 0x04; // lcd horizontal refresh
-
-  uint8_t madParam = 0;
-  switch (mRotate) {
-    case e0:   madParam = kBgr; break;
-    case e180: madParam = kMY | kMX | kBgr; break;
-    case e90:  madParam = kMX | kMV | kBgr; break;
-    case e270: madParam = kMY | kMV | kBgr; break;
-    }
-  //}}}
-  writeCommandMultiData (0x36, &madParam, 1); // MADCTL Memory Access Control ;
-
-  uint8_t k9341x3A = { 0x55 };
-  writeCommandMultiData (0x3A, &k9341x3A, 1); // Pixel format set DPI=16bits/pixel DBI=16bits/pixel
-
-  //{{{
-  // display frame rate in 4-wire SPI "internal clock mode" is computed with the following formula:
-  // frameRate = 615000 / [ (pow(2,DIVA) * (320 + VFP + VBP) * RTNA ]  where
-  // - DIVA is clock division ratio, 0 <= DIVA <= 3; so pow(2,DIVA) is either 1, 2, 4 or 8.
-  // - RTNA specifies the number of clocks assigned to each horizontal scanline, and must follow 16 <= RTNA <= 31.
-  // - VFP is vertical front porch, number of idle sleep scanlines before refreshing a new frame, 2 <= VFP <= 127.
-  // - VBP is vertical back porch, number of idle sleep scanlines after refreshing a new frame, 2 <= VBP <= 127.
-  // Max refresh rate then is with DIVA=0, VFP=2, VBP=2 and RTNA=16:
-  // maxFrameRate = 615000 / (1 * (320 + 2 + 2) * 16) = 118.63 Hz
-  // To get 60fps, set DIVA=0, RTNA=31, VFP=2 and VBP=2:
-  // minFrameRate = 615000 / (8 * (320 + 2 + 2) * 31) = 61.23 Hz
-  // It seems that in internal clock mode, horizontal front and back porch settings (HFP, BFP) are ignored(?)
-  //}}}
-  uint8_t k9341xB1[] = { 0x00, 0x1D };
-  writeCommandMultiData (0xB1, k9341xB1, sizeof(k9341xB1)); // Frame rate 65Hz
-
-  uint8_t k9341xB6[] = { 0x0A, 0xA2, 0x27, 0x00 };
-  writeCommandMultiData (0xB6, k9341xB6, sizeof(k9341xB6)); // Display Function Control
-
-  uint8_t k9341xB7 = 0x07;
-  writeCommandMultiData (0xB7, &k9341xB7, 1); // Entry mode
-
-  //{{{  gamma
-  uint8_t k9341xF2 = 0x08;
-  writeCommandMultiData (0xF2, &k9341xF2, 1); // 3Gamma Function Disable
-
-  uint8_t k9341x26 = 0x01;
-  writeCommandMultiData (0x26, &k9341x26, 1); // Gamma curve selected - Gamma curve 1 (G2.2)
-
-  uint8_t k9341xE0[] = { 0x1f, 0x1a, 0x18, 0x0a, 0x0f, 0x06, 0x45, 0x87, 0x32, 0x0a, 0x07, 0x02, 0x07, 0x05, 0x00 };
-  writeCommandMultiData (0xE0, k9341xE0, sizeof(k9341xE0)); // positive gamma correction
-
-  uint8_t k9341xE1[] = { 0x00, 0x25, 0x27, 0x05, 0x10, 0x09, 0x3a, 0x78, 0x4d, 0x05, 0x18, 0x0d, 0x38, 0x3a, 0x1f };
-  writeCommandMultiData (0xE1, k9341xE1, sizeof(k9341xE1)); // negative gamma correction
-  //}}}
-
-  writeCommand (0x11); // Sleep out
-  delayUs (120000);
-
-  writeCommand (0x29); // Display on
-  delayUs (50000);
-
-  updateLcd (mSpanAll);
-
-  return true;
-  }
-//}}}
-
-// protected
-//{{{
-void cLcd9341p8::writeCommand (const uint8_t command) {
-// exits leaving rs set (params)
-
-  uint32_t pins = command | (command << 12);
-  gpioWrite_Bits_0_31_Clear (~pins & k9341p8WrRsDataMask); // clear wr, rs(command), 8bitData lo bits
-  gpioWrite_Bits_0_31_Set (pins);  // set 8bitData hi bits
-  gpioWrite_Bits_0_31_Set (pins);  // extend setup time
-  gpioWrite_Bits_0_31_Set (k9341p8RsMask | k9341p8WrMask);  // st rs(data), set wr, 8bitData latched on wr rising edge
-  }
-//}}}
-//{{{
-void cLcd9341p8::writeMultiData (const uint8_t* data, int count) {
-// assumes rs set (params)
-
-  for (int i = 0; i < count; i++) {
-    uint32_t pins = *data++;
-    pins |= pins << 12;
-    gpioWrite_Bits_0_31_Clear (~pins & k9341p8WrDataMask); // clear wr + 8bitData lo bits
-    gpioWrite_Bits_0_31_Set (pins); // set 8bitData hi bits
-    gpioWrite_Bits_0_31_Set (pins); // extend setup time
-    gpioWrite_Bits_0_31_Set (k9341p8WrMask); // set wr, 8bitData latched on wr rising edge
-    }
-  }
-//}}}
-//{{{
-void cLcd9341p8::writeMultiWordData (const uint16_t* data, int count) {
-// assumes rs set (params)
-// twiddle 8bit d7.d6.d5.d4.d3.d2.d1.d0 to gpio gpio7.gpio6.gpio5.gpio4.gpio3.gpio2.gpio13.gpio12
-// to avoid spi and ic2 pins
-
-  for (int i = 0; i < count; i++) {
-    uint32_t pins = *data >> 8;
-    pins |= pins << 12;
-
-    gpioWrite_Bits_0_31_Clear (~pins & k9341p8WrDataMask); // clear wr + 8bitMsb lo bits
-    gpioWrite_Bits_0_31_Set (pins); // set 8bitMsb hi bits
-    gpioWrite_Bits_0_31_Set (pins); // extend setup time
-    gpioWrite_Bits_0_31_Set (k9341p8WrMask); // set wr, 8bitMsb latched on wr rising edge
-
-    pins = *data++ & 0xFF;
-    pins |= pins << 12;
-    gpioWrite_Bits_0_31_Clear (~pins & k9341p8WrDataMask); // clear wr + 8bitLsb lo bits
-    gpioWrite_Bits_0_31_Set (pins); // set 8bitLsb hi bits
-    gpioWrite_Bits_0_31_Set (pins); // extend setup time
-    gpioWrite_Bits_0_31_Set (k9341p8WrMask); // set wr, 8bitLsb latched on wr rising edge
-    }
-  }
-//}}}
-
-//{{{
-uint32_t cLcd9341p8::updateLcd (sSpan* spans) {
-// usually many small spans, with the occasional large span
-
-  constexpr uint8_t kColumnAddressSetCommand = 0x2A;
-  constexpr uint8_t kPageAddressSetCommand = 0x2B;
-  constexpr uint8_t kMemoryWriteCommand = 0x2C;
-
-  int numPixels = 0;
-  for (sSpan* span = spans; span; span = span->next) {
-    int16_t columnAddressSetParams[2] = { bswap_16(span->r.left), bswap_16(span->r.right-1) };
-    int16_t pageAddressSetParams[2] = { bswap_16(span->r.top), bswap_16(span->r.bottom-1) };
-
-    writeCommand (kColumnAddressSetCommand);
-    writeMultiData ((uint8_t*)columnAddressSetParams, 4);
-    writeCommand (kPageAddressSetCommand);
-    writeMultiData ((uint8_t*)pageAddressSetParams, 4);
-
-    writeCommand (kMemoryWriteCommand);
-    uint16_t* src = mFrameBuf + (span->r.top * getWidth()) + span->r.left;
-    for (int y = 0; y < span->r.getHeight(); y++) {
-      writeMultiWordData (src, span->r.getWidth());
-      src += getWidth();
-      }
-    numPixels += span->r.getNumPixels();
-    }
-
-  return numPixels;
-  }
+  : cLcd9341 (rotate, info, mode, new cLcdBusParallel8()) {}
 //}}}
 //}}}
 //{{{  cLcd9341p16 - never worked, interference on d14,d15 from uart?
 constexpr uint8_t k9341p16CsGpio = 18; // cs
-
 constexpr uint8_t k9341p16WrGpio = 17; // wr
-constexpr uint32_t k9341p16WrMask = 1 << k9341p16WrGpio; // wrGpio mask
-
 constexpr uint8_t k9341p16RsGpio = 16; // rs
-constexpr uint32_t k9341p16RsMask = 1 << k9341p16RsGpio; // rsGpio mask
 
-constexpr uint32_t k9341p16DataMask = 0x0000FFFF; // 8bitData mask
-constexpr uint32_t k9341p16WrDataMask = k9341p16WrMask | k9341p16DataMask; // wr,8bitData mask
-constexpr uint32_t k9341p16WrRsDataMask = k9341p16WrMask | k9341p16RsMask | k9341p16DataMask; // wr,rs,8bitData mask
-
-// public
 //{{{
 cLcd9341p16::cLcd9341p16 (const eRotate rotate, const eInfo info, const eMode mode)
-  : cLcd(k9341Width, k9341Height, rotate, info, mode) {}
-//}}}
-
-//{{{
-bool cLcd9341p16::initialise() {
-
-  if (!cLcd::initialise())
-    return false;
-
-  // wr - normally hi
-  gpioSetMode (k9341p16WrGpio, PI_OUTPUT);
-  gpioWrite (k9341p16WrGpio, 1);
-
-  // rs - normally hi data
-  gpioSetMode (k9341p16RsGpio, PI_OUTPUT);
-  gpioWrite (k9341p16RsGpio, 1);
-
-  // 8 d0-d7
-  for (int i = 0; i < 16; i++)
-    gpioSetMode (i, PI_OUTPUT);
-  gpioWrite_Bits_0_31_Clear (k9341p16DataMask);
-
-  // chipSelect always lo
-  gpioSetMode (k9341p16CsGpio, PI_OUTPUT);
-  gpioWrite (k9341p16CsGpio, 0);
-
-  writeCommand (0x01); // rely on software reset, no hw reset
-  delayUs (5000);
-
-  writeCommand (0x11); // sleep out
-  delayUs (120000);
-
-  //{{{  power, driver, vcom
-  uint8_t k9341xCF[] = { 0x00, 0x83, 0x30 };
-  writeCommandMultiData (0xCF, k9341xCF, sizeof(k9341xCF)); // Power Control B
-
-  uint8_t k9341xED[] = { 0x64, 0x03, 0x12, 0x81 };
-  writeCommandMultiData (0xED, k9341xED, sizeof(k9341xED)); // Power On Sequence Control
-
-  uint8_t k9341xE8[] = { 0x85, 0x01, 0x79 };
-  writeCommandMultiData (0xE8, k9341xE8, sizeof(k9341xE8)); // Driver Timing Control A
-
-  uint8_t k9341xCB[] = { 0x39, 0x2C, 0x00, 0x34, 0x02 };
-  writeCommandMultiData (0xCB, k9341xCB, sizeof(k9341xCB)); // Driver Timing Control B
-
-  uint8_t k9341xF7 = 0x20;
-  writeCommandMultiData (0xF7, &k9341xF7, 1);  // Pump Ratio Control
-
-  uint8_t k9341xEA[] = { 0x00, 0x00 };
-  writeCommandMultiData (0xEA, k9341xEA, sizeof(k9341xEA)); // Driver Timing Control B
-
-  // 0xC0 Power Control 1 0x23 VRH=4.60V // Set the GVDD level, which is a reference level for the VCOM level and the grayscale voltage level.
-  uint8_t k9341xC1[] = { 0x11 };
-  writeCommandMultiData (0xC1, k9341xC1, sizeof(k9341xC1)); // Power control 2 SAP[2:0];BT[3:0]
-
-  uint8_t k9341xC5[] = { 0x34, 0x3D };
-  writeCommandMultiData (0xC5, k9341xC5, sizeof(k9341xC5)); // VCM control 1
-
-  uint8_t k9341xC7[] = { 0xC0 };
-  writeCommandMultiData (0xC7, k9341xC7, sizeof(k9341xC7)); // VCM control 2
-  //}}}
-
-  //{{{  madctl param
-  constexpr uint8_t kMY  = 0x80; // memory row address order swap
-  constexpr uint8_t kMX  = 0x40; // memory column address order swap
-  constexpr uint8_t kMV  = 0x20; // memory row column exchange
-  constexpr uint8_t kBgr = 0x08;
-  //constexpr uint8_t kML  = 0x10; // lcd vertical refresh
-  //constexpr uint8_t kMH  = 0x04; // lcd horizontal refresh
-
-  uint8_t madParam = 0;
-  switch (mRotate) {
-    case e0:   madParam = kBgr; break;
-    case e180: madParam = kMY | kMX | kBgr; break;
-    case e90:  madParam = kMX | kMV | kBgr; break;
-    case e270: madParam = kMY | kMV | kBgr; break;
-    }
-  //}}}
-  writeCommandMultiData (0x36, &madParam, 1); // MADCTL Memory Access Control ;
-
-  uint8_t k9341x3A = { 0x55 };
-  writeCommandMultiData (0x3A, &k9341x3A, 1); // Pixel format set DPI=16bits/pixel DBI=16bits/pixel
-
-  //{{{
-  // display frame rate in 4-wire SPI "internal clock mode" is computed with the following formula:
-  // frameRate = 615000 / [ (pow(2,DIVA) * (320 + VFP + VBP) * RTNA ]  where
-  // - DIVA is clock division ratio, 0 <= DIVA <= 3; so pow(2,DIVA) is either 1, 2, 4 or 8.
-  // - RTNA specifies the number of clocks assigned to each horizontal scanline, and must follow 16 <= RTNA <= 31.
-  // - VFP is vertical front porch, number of idle sleep scanlines before refreshing a new frame, 2 <= VFP <= 127.
-  // - VBP is vertical back porch, number of idle sleep scanlines after refreshing a new frame, 2 <= VBP <= 127.
-  // Max refresh rate then is with DIVA=0, VFP=2, VBP=2 and RTNA=16:
-  // maxFrameRate = 615000 / (1 * (320 + 2 + 2) * 16) = 118.63 Hz
-  // To get 60fps, set DIVA=0, RTNA=31, VFP=2 and VBP=2:
-  // minFrameRate = 615000 / (8 * (320 + 2 + 2) * 31) = 61.23 Hz
-  // It seems that in internal clock mode, horizontal front and back porch settings (HFP, BFP) are ignored(?)
-  //}}}
-  uint8_t k9341xB1[] = { 0x00, 0x1D };
-  writeCommandMultiData (0xB1, k9341xB1, sizeof(k9341xB1)); // Frame rate 65Hz
-
-  uint8_t k9341xB6[] = { 0x0A, 0xA2, 0x27, 0x00 };
-  writeCommandMultiData (0xB6, k9341xB6, sizeof(k9341xB6)); // Display Function Control
-
-  uint8_t k9341xB7 = 0x07;
-  writeCommandMultiData (0xB7, &k9341xB7, 1); // Entry mode
-
-  //{{{  gamma
-  uint8_t k9341xF2 = 0x08;
-  writeCommandMultiData (0xF2, &k9341xF2, 1); // 3Gamma Function Disable
-
-  uint8_t k9341x26 = 0x01;
-  writeCommandMultiData (0x26, &k9341x26, 1); // Gamma curve selected - Gamma curve 1 (G2.2)
-
-  uint8_t k9341xE0[] = { 0x1f, 0x1a, 0x18, 0x0a, 0x0f, 0x06, 0x45, 0x87, 0x32, 0x0a, 0x07, 0x02, 0x07, 0x05, 0x00 };
-  writeCommandMultiData (0xE0, k9341xE0, sizeof(k9341xE0)); // positive gamma correction
-
-  uint8_t k9341xE1[] = { 0x00, 0x25, 0x27, 0x05, 0x10, 0x09, 0x3a, 0x78, 0x4d, 0x05, 0x18, 0x0d, 0x38, 0x3a, 0x1f };
-  writeCommandMultiData (0xE1, k9341xE1, sizeof(k9341xE1)); // negative gamma correction
-  //}}}
-
-  writeCommand (0x11); // Sleep out
-  delayUs (120000);
-
-  writeCommand (0x29); // Display on
-  delayUs (50000);
-
-  updateLcd (mSpanAll);
-
-  return true;
-  }
-//}}}
-
-// protected
-//{{{
-void cLcd9341p16::writeCommand (const uint8_t command) {
-// exits leaving rs set (params)
-
-  uint32_t byte = command;
-
-  gpioWrite_Bits_0_31_Clear ((~byte) & k9341p16WrRsDataMask); // clear wr, rs(command), 16bitData lo bits
-
-  gpioWrite_Bits_0_31_Set (byte); // set 16bitData hi bits
-  gpioWrite_Bits_0_31_Set (byte); // extend setup time
-  gpioWrite_Bits_0_31_Set (byte); // extend setup time
-
-  // latch d0-15 on this edge
-  gpioWrite_Bits_0_31_Set (k9341p16WrMask);  // set wr, 16bitData latched on wr rising edge
-  gpioWrite_Bits_0_31_Set (k9341p16WrMask);  // set wr
-  gpioWrite_Bits_0_31_Set (k9341p16RsMask | k9341p16WrMask);  // set rs(data), set wr
-  gpioWrite_Bits_0_31_Set (k9341p16RsMask | k9341p16WrMask);  // set rs(data), set wr
-  }
-//}}}
-//{{{
-void cLcd9341p16::writeMultiData (const uint8_t* data, int count) {
-// assumes rs set (params)
-
-  for (int i = 0; i < count; i++) {
-    uint32_t byte = *data++;
-
-    gpioWrite_Bits_0_31_Clear ((~byte) & k9341p16WrDataMask); // clear wr + 8bitData lo bits
-
-    gpioWrite_Bits_0_31_Set (byte); // set 8bitData hi bits
-    gpioWrite_Bits_0_31_Set (byte); // extend setup time
-    gpioWrite_Bits_0_31_Set (byte); // extend setup time
-
-    // latch data on this edge
-    gpioWrite_Bits_0_31_Set (k9341p16WrMask); // set wr, 8bitData latched on wr rising edge
-    gpioWrite_Bits_0_31_Set (k9341p16WrMask); // set wr
-    gpioWrite_Bits_0_31_Set (k9341p16WrMask); // set wr
-    }
-  }
-//}}}
-//{{{
-void cLcd9341p16::writeMultiWordData (const uint16_t* data, int count) {
-// assumes rs set (params), count is even
-
-  for (int i = 0; i < count; i++) {
-    uint32_t rgb565 = *data++;
-
-    gpioWrite_Bits_0_31_Clear ((~rgb565) & k9341p16WrDataMask); // clear wr + 8bitData lo bits
-
-    gpioWrite_Bits_0_31_Set (rgb565); // set 8bitData hi bits
-    gpioWrite_Bits_0_31_Set (rgb565); // set 8bitData hi bits
-    gpioWrite_Bits_0_31_Set (rgb565); // set 8bitData hi bits
-
-    // latch data on this edge
-    gpioWrite_Bits_0_31_Set (k9341p16WrMask); // set wr, 8bitData latched on wr rising edge
-    gpioWrite_Bits_0_31_Set (k9341p16WrMask); // set wr
-    gpioWrite_Bits_0_31_Set (k9341p16WrMask); // set wr
-    }
-  }
-//}}}
-
-//{{{
-uint32_t cLcd9341p16::updateLcd (sSpan* spans) {
-// usually many small spans, with the occasional large span
-
-  constexpr uint8_t kColumnAddressSetCommand = 0x2A;
-  constexpr uint8_t kPageAddressSetCommand = 0x2B;
-  constexpr uint8_t kMemoryWriteCommand = 0x2C;
-
-  int numPixels = 0;
-  for (sSpan* span = spans; span; span = span->next) {
-    uint16_t columnAddressSetParams[2] = { bswap_16(span->r.left), bswap_16(span->r.right-1) };
-    uint16_t pageAddressSetParams[2] = { bswap_16(span->r.top), bswap_16(span->r.bottom-1) };
-
-    writeCommand (kColumnAddressSetCommand);
-    writeMultiData ((uint8_t*)columnAddressSetParams, 4);
-    writeCommand (kPageAddressSetCommand);
-    writeMultiData ((uint8_t*)pageAddressSetParams, 4);
-
-    writeCommand (kMemoryWriteCommand);
-    uint16_t* src = mFrameBuf + (span->r.top * getWidth()) + span->r.left;
-    for (int y = 0; y < span->r.getHeight(); y++) {
-      writeMultiWordData (src, span->r.getWidth());
-      src += getWidth();
-      }
-    numPixels += span->r.getNumPixels();
-    }
-
-  return numPixels;
-  }
+  : cLcd9341 (rotate, info, mode, new cLcdBusParallel16 (k9341p16WrGpio, k9341p16RsGpio, -1, k9341p16CsGpio)) {}
 //}}}
 //}}}
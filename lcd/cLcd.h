@@ -4,11 +4,23 @@
 #include <cstdint>
 #include <string>
 #include "cPointRect.h"
+#include "cPath.h"
 
 struct sSpan;
+struct cIndex8;
+template <class tFormat> class cFrameBuf;
+class cNativeFrameBuf;
+class cCompositor;
+class cDisplayList;
 class cDrawAA;
+class cFont;
 class cFrameDiff;
+class cLayer;
+class cLcdBus;
+class cMaskCache;
+class cSdfAtlas;
 class cSnapshot;
+class cSprite;
 //}}}
 
 //{{{  colours - uint16 RGB565
@@ -43,12 +55,19 @@ public:
   enum eRotate { e0, e90, e180, e270 };
   enum eInfo { eNone, eOverlay };
   enum eMode { eAll, eSingle, eCoarse, eExact };
+  enum eSubpixel { eSubpixelNone, eSubpixelRGB, eSubpixelBGR };
+  enum eFilter { eNearest, eBox, eBilinear };
+  enum eRgbFormat { eRgb888, eBgr888, eXrgb8888 };
 
-  cLcd (const int16_t width, const int16_t height, const eRotate rotate, const eInfo info, const eMode mode);
+  cLcd (const int16_t width, const int16_t height, const eRotate rotate, const eInfo info, const eMode mode,
+        cLcdBus* bus);
   virtual ~cLcd();
 
   virtual bool initialise();
 
+  // transport, owned, opened by initialise
+  cLcdBus* getBus() { return mBus; }
+
   constexpr uint16_t getWidth() { return mWidth; }
   constexpr uint16_t getHeight() { return mHeight; }
   constexpr uint32_t getNumPixels() { return mWidth * mHeight; }
@@ -62,38 +81,111 @@ public:
   //}}}
 
   // present
+  // - native panel, or indexed, draws clear, rect, pix, outline, ellipse, line, aa, text and cached aa into native frameBuf,
+  //   other primitives, displayList and compositor log an error and do nothing
   void clear (const uint16_t colour = kBlack);
   void snapshot();
   bool present();
+  bool present (cDisplayList& displayList);
+  bool present (cCompositor& compositor);
+
+  // indexed, indexFrameBuf is the native frameBuf, sent expanded through palette, palette change resends everything
+  // - native primitives draw colour argument as index, alpha and aa coverage thresholded at half
+  // - drawing straight into getIndexFrameBuf isn't tracked, so next clear clears everything
+  void setIndexed (const uint16_t* palette);
+  bool getIndexed() { return mIndexFrameBuf != nullptr; }
+  cFrameBuf<cIndex8>* getIndexFrameBuf() { mTrack.cleared = false; return mIndexFrameBuf; }
+  void setPalette (const uint16_t* palette);
+  void setPaletteEntry (const uint8_t index, const uint16_t colour);
+
+  // layer, primitives draw into layer frameBuf until endLayer, no nesting
+  void beginLayer (cLayer& layer);
+  void beginLayer (cLayer& layer, const cRect& r);
+  void endLayer();
+
+  // clip, every primitive draws only inside clip
+  cRect getClip() { return mClip; }
+  void setClip (const cRect& r);
+  void resetClip();
+  void pushClip (const cRect& r);
+  void popClip();
 
   void pix (const uint16_t colour, const uint8_t alpha, const cPoint& p);
   void copy (const uint16_t* src, cRect& srcRect, const uint16_t srcStride, const cPoint& dstPoint);
+  void copyScaled (const uint16_t* src, const cRect& srcRect, const uint16_t srcStride,
+                   const cRect& dstRect, const eFilter filter = eBilinear);
+
+  // convert to rgb565 straight into frameBuf, src same size as dstRect, strides in bytes
+  void copyRgb (const uint8_t* src, const int srcStride, const eRgbFormat format,
+                const cRect& dstRect, const bool dither = true);
+  void copyYuv420 (const uint8_t* yPlane, const uint8_t* uPlane, const uint8_t* vPlane,
+                   const int yStride, const int uvStride, const cRect& dstRect, const bool dither = true);
+  void blit (const cSprite& sprite, const cPoint& p);
 
   // gradient
   void hGrad (const uint16_t colourL, const uint16_t colourR, const cRect& r);
   void vGrad (const uint16_t colourT, const uint16_t colourB, const cRect& r);
   void grad (const uint16_t colourTL ,const uint16_t colourTR,
              const uint16_t colourBL, const uint16_t colourBR, const cRect& r);
+  void radialGrad (const cPoint& centre, const int radius, const uint16_t colourIn, const uint16_t colourOut);
+
   // draw
   void rect (const uint16_t colour, const cRect& r);
   void rect (const uint16_t colour, const uint8_t alpha, const cRect& r);
   void rectOutline (const uint16_t colour, const cRect& r);
+  void roundedRect (const uint16_t colour, const uint8_t alpha, const cRect& r, int radius);
+  void roundedRectOutline (const uint16_t colour, const cRect& r, int radius);
   void ellipse (const uint16_t colour, const uint8_t alpha, cPoint centre, cPoint radius);
   void ellipseOutline (const uint16_t colour, cPoint centre, cPoint radius);
   void line (const uint16_t colour, cPoint p1, cPoint p2);
+  void thickLine (const uint16_t colour, const uint8_t alpha, const cPoint& p1, const cPoint& p2, const int width);
 
   // aa draw
   void moveToAA (const cPointF& p);
   void lineToAA (const cPointF& p);
+  void quadToAA (const cPointF& c, const cPointF& p);
+  void cubicToAA (const cPointF& c1, const cPointF& c2, const cPointF& p);
   void renderAA (const uint16_t colour, bool fillNonZero);
+  void setThreadsAA (int numThreads);
+
+  // aa compound, paths after styleAA take its colour, renderCompoundAA composites all with one sort
+  // - paths added before first styleAA have no colour, styleAA or renderCompoundAA logs and drops them
+  void styleAA (const uint16_t colour, bool fillNonZero = true);
+  void renderCompoundAA();
+
+  // aa cached, path mask rendered once per quarter pixel offset, then blitted from mask cache
+  // - misses rasterised on mask cache own drawAA, any pending aa path and its clip left alone
+  void setMaskCache (const uint32_t maxBytes);
+  cMaskCache* getMaskCache() { return mMaskCache; }
+  cSdfAtlas* getSdfAtlas() { return mSdfAtlas; }
+  void fillCachedAA (const uint16_t colour, const cPath& path, const cPointF& pos, bool fillNonZero = true);
+  void strokeCachedAA (const uint16_t colour, const cPath& path, const cPointF& pos, float width,
+                       cPath::eJoin join = cPath::eMiterJoin, cPath::eCap cap = cPath::eButtCap);
+
+  // aa paths, added to current aa draw, renderAA to composite
+  void fillAA (const cPath& path);
+  void strokeAA (const cPath& path, float width,
+                 cPath::eJoin join = cPath::eMiterJoin, cPath::eCap cap = cPath::eButtCap);
 
   // aa draw helpers
   void wideLineAA (const cPointF& p1, const cPointF& p2, float width);
   void pointedLineAA (const cPointF& p1, const cPointF& p2, float width);
-  void ellipseAA (const cPointF& centre, const cPointF& radius, int steps);
-  void ellipseOutlineAA (const cPointF& centre, const cPointF& radius, float width, int steps);
+  void ellipseAA (const cPointF& centre, const cPointF& radius, int steps = 0);
+  void ellipseOutlineAA (const cPointF& centre, const cPointF& radius, float width, int steps = 0);
 
+  // text, glyph outlines of font rendered through aa draw, so any pending aa path composites with it
   int text (const uint16_t colour, const cPoint& p, const int height, const std::string& str);
+  cPointF textAA (const uint16_t colour, const cPointF& p, const float height, const std::string& str,
+                  const float angle = 0.f);
+  // text sampled from signed distance field atlas of font, one atlas for all heights
+  cPointF textSdf (const uint16_t colour, const cPointF& p, const float height, const std::string& str);
+
+  // text rasterised at 3x horizontal across panel rgb stripe, cached per third pixel offset in mask cache
+  // - stripe order of unrotated panel, swapped at 180, greyscale textAA at 90, 270 where stripes run along y
+  // - glyph misses rasterised on mask cache own drawAA, unlike textAA a pending aa path is left alone
+  void setSubpixel (const eSubpixel subpixel) { mSubpixel = subpixel; }
+  cPointF textSubpixel (const uint16_t colour, const cPointF& p, const float height, const std::string& str);
+  cRect measureText (const cPoint& p, const int height, const std::string& str);
 
   void delayUs (const int us);
   double timeUs();
@@ -102,9 +194,10 @@ public:
 protected:
   void reset();
 
-  virtual void writeCommand (const uint8_t command) = 0;
-  virtual void writeDataWord (const uint16_t data) {}
-  virtual void writeMultiData (const uint8_t* data, int count) {}
+  void writeCommand (const uint8_t command);
+  void writeDataWord (const uint16_t data);
+  void writeMultiData (const uint8_t* data, int count);
+  void writeRows (const cRect& r);
 
   //{{{
   void writeCommandData (const uint8_t command, const uint16_t data) {
@@ -113,7 +206,7 @@ protected:
     }
   //}}}
   //{{{
-  void writeCommandMultiData (const uint8_t command, uint8_t* data, int length) {
+  void writeCommandMultiData (const uint8_t command, const uint8_t* data, int length) {
     writeCommand (command);
     writeMultiData (data, length);
     }
@@ -121,6 +214,10 @@ protected:
 
   virtual uint32_t updateLcd (sSpan* spans) = 0;
 
+  // updateLcd source, frameBuf row or pixel, or indexFrameBuf expanded through palette
+  const uint16_t* getUpdateRow (const int y, const int left, const int width);
+  uint16_t getUpdatePixel (const int x, const int y);
+
   // vars
   const eRotate mRotate;
   const eInfo mInfo;
@@ -135,8 +232,13 @@ protected:
   // uint16_t colour frameBufs
   uint16_t* mFrameBuf = nullptr;
 
+  // native frameBuf, set by panel before cLcd::initialise, no rgb565 frameBuf or frameDiff allocated then
+  cNativeFrameBuf* mNativeFrameBuf = nullptr;
+
   // span for whole screen
   sSpan* mSpanAll = nullptr;
+
+  cLcdBus* mBus = nullptr;
 //}}}
 //{{{
 private:
@@ -148,42 +250,98 @@ private:
   std::string getInfoString();
   std::string getPaddedInfoString();
 
+  bool presentNative();
+  bool rejectNative (const char* primitive);
+
+  // draw into native frameBuf, not while drawing into rgb565 layer
+  bool drawNative() { return mNativeFrameBuf && !mInLayer; }
+
+  //{{{
+  void drawn (const cRect& r) {
+  // extend drawn rect of frameBuf since clear, not while drawing into layer
+  // - r wholly outside clip intersects inverted, kept out or clear would fill negative widths
+    cRect clipped = r.intersect (mClip);
+    if (!mInLayer && !clipped.isEmpty())
+      mTrack.drawn = mTrack.drawn.combine (clipped);
+    }
+  //}}}
+
   void setFont (const uint8_t* font, const int fontSize);
 
+  void span (const uint16_t colour, const uint8_t alpha, int x1, int x2, const int y);
+  void cachedAA (const uint16_t colour, const cPath& path, const cPointF& pos, uint64_t key,
+                 bool fillNonZero, float width, cPath::eJoin join, cPath::eCap cap);
+
+  void copyNearest (const uint16_t* src, const uint16_t srcStride, const cRect& clipped,
+                    const int xStart, const int yStart, const int xStep, const int yStep);
+  void copyBox2 (const uint16_t* src, const uint16_t srcStride, const cRect& clipped);
+  void copyBilinear (const uint16_t* src, const cRect& srcRect, const uint16_t srcStride, const cRect& clipped,
+                     const int xStart, const int yStart, const int xStep, const int yStep);
+
   // vars
   const bool mSnapshotEnabled;
   const bool mTypeEnabled;
 
   cDrawAA* mDrawAA = nullptr;
+  cFont* mFont = nullptr;
+  cSdfAtlas* mSdfAtlas = nullptr;
+  eSubpixel mSubpixel = eSubpixelRGB;
+  cPointF mCurAA;
+  cMaskCache* mMaskCache = nullptr;
   uint8_t mGamma[256];
 
+  // one row of pixels for primitives to build runs in, allocated once by initialise
+  uint16_t* mScratchRow = nullptr;
+
   cFrameDiff* mFrameDiff = nullptr;
   int mDiffUs = 0;
 
-  cSnapshot* mSnapshot = nullptr;
-//}}}
-  };
-//}}}
+  // clear tracking, while cleared frameBuf is colour outside drawn rect
+  // - clear resets only drawn rect, diff only rows drawn in either frameBuf
+  struct sClearTrack {
+    bool cleared = false;
+    uint16_t colour = 0;
+    cRect drawn;
+    };
+  sClearTrack mTrack;
+  sClearTrack mPrevTrack;
 
-// spi header classes
-//{{{
-class cLcdSpiHeader : public cLcd {
-public:
-  cLcdSpiHeader (const int16_t width, const int16_t height, const eRotate rotate, const eInfo info, const eMode mode);
-  virtual ~cLcdSpiHeader();
+  cRect mClip;
 
-protected:
-  virtual void writeCommand (const uint8_t command);
-  virtual void writeDataWord (const uint16_t data);
+  // pushed clips, pushClip beyond kMaxClips still intersects but popClip then can't restore
+  static constexpr int kMaxClips = 16;
+  cRect mClipStack[kMaxClips];
+  int mNumClips = 0;
+
+  // last presented displayList, frameDiff previous frameBuf is stale after it
+  cDisplayList* mDisplayList = nullptr;
+
+  // last presented compositor, frameBufs only hold its layers while it keeps presenting
+  cCompositor* mCompositor = nullptr;
 
-  int mSpiHandle = 0;
+  // drawing into layer, saved frameBuf and clip, saved frameBuf null on native panel
+  bool mInLayer = false;
+  uint16_t* mLayerSavedFrameBuf = nullptr;
+  cRect mLayerSavedClip;
+
+  // indexed frameBuf, also nativeFrameBuf, palette and row expanded for updateLcd
+  cFrameBuf<cIndex8>* mIndexFrameBuf = nullptr;
+  uint16_t mPalette[256];
+  bool mPaletteChanged = false;
+  uint16_t* mUpdateRow = nullptr;
+
+  cSnapshot* mSnapshot = nullptr;
+//}}}
   };
 //}}}
+
+// spi classes
 //{{{
-class cLcd9320 : public cLcdSpiHeader {
-// 2.8 inch 1240x320 - HY28A
+class cLcd9320 : public cLcd {
+// 2.8 inch 240x320 - HY28A, spi header bus
 public:
-  cLcd9320 (cLcd::eRotate rotate, cLcd::eInfo info, eMode mode);
+  cLcd9320 (eRotate rotate, eInfo info, eMode mode);
+  cLcd9320 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus);
   virtual ~cLcd9320() {}
 
   virtual void setBacklight (bool on);
@@ -194,31 +352,27 @@ protected:
   virtual uint32_t updateLcd (sSpan* spans);
   };
 //}}}
-
-// spi rs pin classes
 //{{{
-class cLcdSpi : public cLcd {
+class cLcd7735 : public cLcd {
+// 1.8 inch 128x160, spi bus
 public:
-  cLcdSpi (int16_t width, int16_t height, eRotate rotate, eInfo info, eMode mode, int spiSpeed, int registerGpio);
-  virtual ~cLcdSpi();
-
-protected:
-  virtual void writeCommand (const uint8_t command);
-  virtual void writeDataWord (const uint16_t data);
-  virtual void writeMultiData (uint8_t* data, int length);
+  cLcd7735 (eRotate rotate, eInfo info, eMode mode, int spiSpeed);
+  cLcd7735 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus);
+  virtual ~cLcd7735() {}
 
-  const int mSpiSpeed = 0;
-  const int mRegisterGpio = 0;
+  virtual bool initialise();
 
-  int mSpiHandle = 0;
+protected:
+  virtual uint32_t updateLcd (sSpan* spans);
   };
 //}}}
 //{{{
-class cLcd7735 : public cLcdSpi {
-// 1.8 inch 128x160
+class cLcd9225 : public cLcd {
+// 2.2 inch 176x220, spi bus
 public:
-  cLcd7735 (cLcd::eRotate rotate, cLcd::eInfo info, eMode mode, int spiSpeed);
-  virtual ~cLcd7735() {}
+  cLcd9225 (eRotate rotate, eInfo info, eMode mode, int spiSpeed);
+  cLcd9225 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus);
+  virtual ~cLcd9225() {}
 
   virtual bool initialise();
 
@@ -227,11 +381,12 @@ protected:
   };
 //}}}
 //{{{
-class cLcd9225 : public cLcdSpi {
-// 2.2 inch 186x220
+class cLcd9341 : public cLcd {
+// 2.4 inch 240x320, aux spi bus
 public:
-  cLcd9225 (cLcd::eRotate rotate, cLcd::eInfo info, eMode mode, int spiSpeed);
-  virtual ~cLcd9225() {}
+  cLcd9341 (eRotate rotate, eInfo info, eMode mode, int spiSpeed);
+  cLcd9341 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus);
+  virtual ~cLcd9341() {}
 
   virtual bool initialise();
 
@@ -240,78 +395,74 @@ protected:
   };
 //}}}
 //{{{
-class cLcd9341 : public cLcdSpi {
+class cLcd9341dma : public cLcd9341 {
+// cLcd9341 on main spi, updates streamed by a dma chain while the next frame is drawn
 public:
-  cLcd9341 (cLcd::eRotate rotate, cLcd::eInfo info, eMode mode, int spiSpeed);
-  virtual ~cLcd9341() {}
+  cLcd9341dma (eRotate rotate, eInfo info, eMode mode, int spiSpeed);
+  virtual ~cLcd9341dma() {}
+  };
+//}}}
+//{{{
+class cLcd9486 : public cLcd {
+// 3.5 inch 320x480, spi bus, rgb666 only over spi
+// - drawn and diffed natively in cFrameBuf<cRgb666>, its rows sent 3 bytes a pixel, no rgb565 frameBufs
+public:
+  cLcd9486 (eRotate rotate, eInfo info, eMode mode, int spiSpeed);
+  cLcd9486 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus);
+  virtual ~cLcd9486();
 
   virtual bool initialise();
 
 protected:
   virtual uint32_t updateLcd (sSpan* spans);
+
+private:
+  uint8_t* mIndexedRow = nullptr;
   };
 //}}}
 
 // parallel classes
 //{{{
 class cLcd7601 : public cLcd {
+// 320x480, 16bit parallel J8 bus
 public:
   cLcd7601 (eRotate rotate, eInfo info, eMode mode);
+  cLcd7601 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus);
   virtual ~cLcd7601() {}
 
   virtual bool initialise();
   virtual void setBacklight (bool on);
 
 protected:
-  virtual void writeCommand (const uint8_t command);
-  virtual void writeDataWord (const uint16_t data);
-
   virtual uint32_t updateLcd (sSpan* spans);
   };
 //}}}
 //{{{
 class cLcd1289 : public cLcd {
+// 240x320, 16bit parallel J8 bus
 public:
   cLcd1289 (eRotate rotate, eInfo info, eMode mode);
+  cLcd1289 (eRotate rotate, eInfo info, eMode mode, cLcdBus* bus);
   virtual ~cLcd1289() {}
 
 protected:
-  virtual void writeCommand (const uint8_t command);
-  virtual void writeDataWord (const uint16_t data);
-
   virtual bool initialise();
   virtual uint32_t updateLcd (sSpan* spans);
   };
 //}}}
 //{{{
-class cLcd9341p8 : public cLcd {
+class cLcd9341p8 : public cLcd9341 {
+// cLcd9341 on 8bit parallel bus
 public:
   cLcd9341p8 (eRotate rotate, eInfo info, eMode mode);
   virtual ~cLcd9341p8() {}
-
-  virtual bool initialise();
-
-protected:
-  virtual void writeCommand (const uint8_t command);
-  virtual void writeMultiData (const uint8_t* data, int count);
-  void writeMultiWordData (const uint16_t* data, int count);
-
-  virtual uint32_t updateLcd (sSpan* spans);
   };
 //}}}
 //{{{
-class cLcd9341p16 : public cLcd {
+class cLcd9341p16 : public cLcd9341 {
+// cLcd9341 on 16bit parallel bus
 public:
   cLcd9341p16 (eRotate rotate, eInfo info, eMode mode);
   virtual ~cLcd9341p16() {}
-
-  virtual bool initialise();
-
-protected:
-  virtual void writeCommand (const uint8_t command);
-  virtual void writeMultiData (const uint8_t* data, int count);
-  void writeMultiWordData (const uint16_t* data, int count);
-
-  virtual uint32_t updateLcd (sSpan* spans);
   };
 //}}}
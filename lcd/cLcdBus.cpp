@@ -0,0 +1,442 @@
+// cLcdBus.cpp
+#include "cLcdBus.h"
+#include <cstring>
+#include <byteswap.h>
+
+#include "../pigpio/pigpioLite.h"
+
+using namespace std;
+
+// spi
+//{{{  cLcdBusSpi
+//{{{
+cLcdBusSpi::~cLcdBusSpi() {
+
+  if (mSpiHandle >= 0)
+    spiClose (mSpiHandle);
+  }
+//}}}
+
+//{{{
+bool cLcdBusSpi::open() {
+
+  // rs - normally hi data
+  gpioSetMode (mRsGpio, PI_OUTPUT);
+  gpioWrite (mRsGpio, 1);
+
+  // mode 0, spi manages ce0 active lo
+  mSpiHandle = spiOpen (0, mSpiSpeed, 0);
+  return mSpiHandle >= 0;
+  }
+//}}}
+
+//{{{
+void cLcdBusSpi::command (const uint8_t command) {
+
+  gpioWrite (mRsGpio, 0);
+  spiWrite (mSpiHandle, (char*)(&command), 1);
+  gpioWrite (mRsGpio, 1);
+  }
+//}}}
+//{{{
+void cLcdBusSpi::data (const uint8_t* data, const int count) {
+// spiWrite count limited to 16 bits
+
+  int length = count;
+  while (length > 0) {
+    int sendBytes = (length > 0xFFFF) ? 0xFFFF : length;
+    spiWrite (mSpiHandle, (char*)data, sendBytes);
+    data += sendBytes;
+    length -= sendBytes;
+    }
+  }
+//}}}
+//{{{
+void cLcdBusSpi::pixels (const uint16_t* pixels, const int count) {
+
+  int length = count;
+  while (length > 0) {
+    int sendPixels = (length > kChunkPixels) ? kChunkPixels : length;
+    for (int i = 0; i < sendPixels; i++)
+      mChunk[i] = bswap_16 (*pixels++);
+    spiWrite (mSpiHandle, (char*)mChunk, sendPixels * 2);
+    length -= sendPixels;
+    }
+  }
+//}}}
+//}}}
+//{{{  cLcdBusAuxSpi
+//{{{
+cLcdBusAuxSpi::~cLcdBusAuxSpi() {
+
+  if (mSpiHandle >= 0)
+    spiClose (mSpiHandle);
+  }
+//}}}
+
+//{{{
+bool cLcdBusAuxSpi::open() {
+
+  // rs - normally hi data
+  gpioSetMode (mRsGpio, PI_OUTPUT);
+  gpioWrite (mRsGpio, 1);
+
+  //{{{  spiFlags
+  // 21 20 19 18 17 16 15 14 13 12 11 10  9  8  7  6  5  4  3  2  1  0
+  //  b  b  b  b  b  b  R  T  n  n  n  n  W  A u2 u1 u0 p2 p1 p0  m  m
+
+    //mm defines the SPI mode, modes 1,3 do not appear to work on the auxiliary SPI.
+      //Mode POL PHA
+       //0    0   0
+       //1    0   1
+       //2    1   0
+       //3    1   1
+
+    //px = 0 if CEx is active low (default), 1 = active high.
+
+    //ux = 0 CEx GPIO is reserved for SPI (default), 1 otherwise.
+
+    //A = 0 main SPI, 1 for the auxiliary SPI.
+
+    //W = 0 if the device is not 3-wire, 1 if the device is 3-wire. Main SPI only.
+      //nnnn = number of bytes (0-15) to write before switching MOSI line to MISO to read data.
+             //This field is ignored if W is not set.  Main SPI only.
+
+    //T = 1 if the least significant bit is transmitted on MOSI first
+          //default (0) shifts the most significant bit out first.  Auxiliary SPI only.
+
+    //R = 1 if the least significant bit is received on MISO first
+          //default (0) receives the most significant bit first.  Auxiliary SPI only.
+
+    //bbbbbb = word size in bits (0-32).  The default (0) sets 8 bits per word.  Auxiliary SPI only.
+  //}}}
+  // mode 0, aux spi, ce2 managed by spiWriteAuxFast active lo
+  mSpiHandle = spiOpen (2, mSpiSpeed, 0x0160);
+  return mSpiHandle >= 0;
+  }
+//}}}
+
+//{{{
+void cLcdBusAuxSpi::command (const uint8_t command) {
+
+  gpioWrite (mRsGpio, 0);
+  spiWriteAuxFast (&command, 1);
+  gpioWrite (mRsGpio, 1);
+  }
+//}}}
+//{{{
+void cLcdBusAuxSpi::data (const uint8_t* data, const int count) {
+// preswap byte pairs, spiWriteAuxFast swaps them back, odd last byte sent alone
+
+  uint8_t swapped[64];
+
+  int length = count & ~1;
+  while (length > 0) {
+    int sendBytes = (length > (int)sizeof(swapped)) ? (int)sizeof(swapped) : length;
+    for (int i = 0; i < sendBytes; i += 2) {
+      swapped[i] = data[i+1];
+      swapped[i+1] = data[i];
+      }
+    spiWriteAuxFast (swapped, sendBytes);
+    data += sendBytes;
+    length -= sendBytes;
+    }
+
+  if (count & 1)
+    spiWriteAuxFast (data, 1);
+  }
+//}}}
+//{{{
+void cLcdBusAuxSpi::pixels (const uint16_t* pixels, const int count) {
+
+  if (count == 1) {
+    // register value, send through data as bytes
+    const uint8_t bytes[2] = { uint8_t(*pixels >> 8), uint8_t(*pixels & 0xFF) };
+    data (bytes, 2);
+    }
+  else if (count > 0)
+    spiWriteAuxFast ((const uint8_t*)pixels, count * 2);
+  }
+//}}}
+//}}}
+//{{{  cLcdBusSpiHeader
+//{{{
+cLcdBusSpiHeader::~cLcdBusSpiHeader() {
+
+  if (mSpiHandle >= 0)
+    spiClose (mSpiHandle);
+  }
+//}}}
+
+//{{{
+bool cLcdBusSpiHeader::open() {
+
+  gpioSetMode (mCeGpio, PI_OUTPUT);
+  gpioWrite (mCeGpio, 1);
+
+  // spi - we manage (ce2),(ce1),ce0 active lo, mode 3
+  mSpiHandle = spiOpen (0, mSpiSpeed, 0xE3);
+  return mSpiHandle >= 0;
+  }
+//}}}
+
+//{{{
+void cLcdBusSpiHeader::command (const uint8_t command) {
+
+  mChunk[0] = 0x70;
+  mChunk[1] = 0;
+  mChunk[2] = command;
+  transfer (3);
+  }
+//}}}
+//{{{
+void cLcdBusSpiHeader::data (const uint8_t* data, const int count) {
+
+  mChunk[0] = 0x72;
+
+  int length = count;
+  while (length > 0) {
+    int sendBytes = (length > kChunkBytes) ? kChunkBytes : length;
+    memcpy (mChunk + 1, data, sendBytes);
+    transfer (1 + sendBytes);
+    data += sendBytes;
+    length -= sendBytes;
+    }
+  }
+//}}}
+//{{{
+void cLcdBusSpiHeader::pixels (const uint16_t* pixels, const int count) {
+
+  mChunk[0] = 0x72;
+
+  int length = count;
+  while (length > 0) {
+    int sendPixels = (length > kChunkBytes / 2) ? kChunkBytes / 2 : length;
+    uint8_t* dst = mChunk + 1;
+    for (int i = 0; i < sendPixels; i++) {
+      *dst++ = *pixels >> 8;
+      *dst++ = *pixels++ & 0xFF;
+      }
+    transfer (1 + (sendPixels * 2));
+    length -= sendPixels;
+    }
+  }
+//}}}
+
+// private
+//{{{
+void cLcdBusSpiHeader::transfer (const int count) {
+// header and bytes from chunk in one ce lo transfer
+
+  gpioWrite (mCeGpio, 0);
+  spiWrite (mSpiHandle, (char*)mChunk, count);
+  gpioWrite (mCeGpio, 1);
+  }
+//}}}
+//}}}
+
+// parallel
+//{{{  cLcdBusParallel8
+constexpr uint8_t kParallel8WrGpio = 23;
+constexpr uint32_t kParallel8WrMask = 1 << kParallel8WrGpio;
+
+constexpr uint8_t kParallel8RsGpio = 22;
+constexpr uint32_t kParallel8RsMask = 1 << kParallel8RsGpio;
+
+constexpr uint32_t kParallel8DataMask = 0x000030FC; // gpio13 gpio12 gpio7 gpio6 gpio5 gpio4 gpio3 gpio2
+constexpr uint32_t kParallel8WrDataMask = kParallel8WrMask | kParallel8DataMask;
+
+//{{{
+bool cLcdBusParallel8::open() {
+
+  // wr - normally hi
+  gpioSetMode (kParallel8WrGpio, PI_OUTPUT);
+  gpioWrite (kParallel8WrGpio, 1);
+
+  // rs - normally hi data
+  gpioSetMode (kParallel8RsGpio, PI_OUTPUT);
+  gpioWrite (kParallel8RsGpio, 1);
+
+  // 8bit data output gpio
+  for (int i = 0; i < 14; i++)
+    if (kParallel8DataMask & (1 << i))
+      gpioSetMode (i, PI_OUTPUT);
+  gpioWrite_Bits_0_31_Clear (kParallel8DataMask);
+
+  return true;
+  }
+//}}}
+
+//{{{
+void cLcdBusParallel8::command (const uint8_t command) {
+
+  gpioWrite_Bits_0_31_Clear (kParallel8RsMask); // rs lo command
+  write (command);
+  gpioWrite_Bits_0_31_Set (kParallel8RsMask);   // rs hi data
+  }
+//}}}
+//{{{
+void cLcdBusParallel8::data (const uint8_t* data, const int count) {
+
+  for (int i = 0; i < count; i++)
+    write (*data++);
+  }
+//}}}
+//{{{
+void cLcdBusParallel8::pixels (const uint16_t* pixels, const int count) {
+
+  for (int i = 0; i < count; i++) {
+    write (*pixels >> 8);
+    write (*pixels++ & 0xFF);
+    }
+  }
+//}}}
+
+// private
+//{{{
+inline void cLcdBusParallel8::write (const uint8_t byte) {
+// twiddle d7.d6.d5.d4.d3.d2.d1.d0 to gpio7.gpio6.gpio5.gpio4.gpio3.gpio2.gpio13.gpio12
+
+  uint32_t pins = byte | (byte << 12);
+  gpioWrite_Bits_0_31_Clear (~pins & kParallel8WrDataMask); // clear wr + data lo bits
+  gpioWrite_Bits_0_31_Set (pins);                           // set data hi bits
+  gpioWrite_Bits_0_31_Set (pins);                           // extend setup time
+  gpioWrite_Bits_0_31_Set (kParallel8WrMask);               // set wr, data latched on wr rising edge
+  }
+//}}}
+//}}}
+//{{{  cLcdBusParallel16
+constexpr uint32_t kParallel16DataMask = 0x0000FFFF;
+
+//{{{
+bool cLcdBusParallel16::open() {
+
+  // wr - normally hi
+  gpioSetMode (mWrGpio, PI_OUTPUT);
+  gpioWrite (mWrGpio, 1);
+
+  // rs - normally hi data
+  gpioSetMode (mRsGpio, PI_OUTPUT);
+  gpioWrite (mRsGpio, 1);
+
+  // rd - unused
+  if (mRdGpio >= 0) {
+    gpioSetMode (mRdGpio, PI_OUTPUT);
+    gpioWrite (mRdGpio, 1);
+    }
+
+  // chipSelect always lo
+  if (mCsGpio >= 0) {
+    gpioSetMode (mCsGpio, PI_OUTPUT);
+    gpioWrite (mCsGpio, 0);
+    }
+
+  // 16 d0-d15
+  for (int i = 0; i < 16; i++)
+    gpioSetMode (i, PI_OUTPUT);
+  gpioWrite_Bits_0_31_Clear (kParallel16DataMask);
+
+  return true;
+  }
+//}}}
+
+//{{{
+void cLcdBusParallel16::command (const uint8_t command) {
+
+  gpioWrite (mRsGpio, 0);
+  write (command);
+  gpioWrite (mRsGpio, 1);
+  }
+//}}}
+//{{{
+void cLcdBusParallel16::data (const uint8_t* data, const int count) {
+// byte per write, on d7-d0
+
+  for (int i = 0; i < count; i++)
+    write (*data++);
+  }
+//}}}
+//{{{
+void cLcdBusParallel16::pixels (const uint16_t* pixels, const int count) {
+
+  for (int i = 0; i < count; i++)
+    write (*pixels++);
+  }
+//}}}
+
+// private
+//{{{
+inline void cLcdBusParallel16::write (const uint16_t word) {
+// slow down write, clocks ok but data not ready
+
+  uint32_t wrMask = 1 << mWrGpio;
+  uint32_t wrDataMask = wrMask | kParallel16DataMask;
+
+  gpioWrite_Bits_0_31_Clear (~word & wrDataMask); // clear wr + data lo bits
+  gpioWrite_Bits_0_31_Clear (~word & wrDataMask); // extend setup time
+  gpioWrite_Bits_0_31_Clear (~word & wrDataMask); // extend setup time
+
+  gpioWrite_Bits_0_31_Set (word);                 // set data hi bits
+  gpioWrite_Bits_0_31_Set (word);                 // extend setup time
+  gpioWrite_Bits_0_31_Set (word);                 // extend setup time
+
+  gpioWrite_Bits_0_31_Set (wrMask);               // set wr, data latched on wr rising edge
+  gpioWrite_Bits_0_31_Set (wrMask);               // extend hold time
+  }
+//}}}
+//}}}
+
+// memory
+//{{{  cLcdBusRecorder
+//{{{
+void cLcdBusRecorder::command (const uint8_t command) {
+
+  mOps.push_back ({ true, (uint32_t)mBytes.size(), 1 });
+  mBytes.push_back (command);
+  mNumCommands++;
+  }
+//}}}
+//{{{
+void cLcdBusRecorder::data (const uint8_t* data, const int count) {
+
+  mBytes.insert (mBytes.end(), data, data + count);
+  addData (count);
+  }
+//}}}
+//{{{
+void cLcdBusRecorder::pixels (const uint16_t* pixels, const int count) {
+
+  for (int i = 0; i < count; i++) {
+    mBytes.push_back (pixels[i] >> 8);
+    mBytes.push_back (pixels[i] & 0xFF);
+    }
+  addData (count * 2);
+  mNumPixels += count;
+  }
+//}}}
+
+//{{{
+void cLcdBusRecorder::clear() {
+
+  mOps.clear();
+  mBytes.clear();
+  mNumCommands = 0;
+  mNumPixels = 0;
+  }
+//}}}
+
+// private
+//{{{
+void cLcdBusRecorder::addData (const uint32_t count) {
+// bytes already appended, extend last data op or start one
+
+  if (!count)
+    return;
+
+  if (!mOps.empty() && !mOps.back().command)
+    mOps.back().count += count;
+  else
+    mOps.push_back ({ false, (uint32_t)mBytes.size() - count, count });
+  }
+//}}}
+//}}}
@@ -0,0 +1,216 @@
+// cLcdBus.h - lcd transports, command, data and pixel stream over spi, aux spi, parallel or memory
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "cPointRect.h"
+
+//{{{
+class cLcdBus {
+// - command sent with rs lo, data and pixels with rs hi, panel sets its window before streaming pixels
+// - data bytes sent in the order given, pixels and 16bit register values are native uint16 sent msb first,
+//   one transfer each on a 16bit bus
+// - data and pixels are consumed before the call returns, caller may reuse its buffer
+// - pixelRows sends the rows of a frameBuf rect, a dma bus can stream them as one strided block
+// - submit starts anything queued, wait returns once it has all been sent, both no-ops on synchronous buses
+// - getPending true while anything queued or submitted has not been sent, always false on synchronous buses
+// - getPixelAlign, power of 2 pixels a panel window's left and width are best aligned to, 1 for any
+public:
+  virtual ~cLcdBus() {}
+
+  virtual const char* getName() const = 0;
+  virtual bool open() = 0;
+
+  virtual void command (const uint8_t command) = 0;
+  virtual void data (const uint8_t* data, const int count) = 0;
+  virtual void pixels (const uint16_t* pixels, const int count) = 0;
+  //{{{
+  virtual void pixelRows (const uint16_t* frameBuf, const int stride, const cRect& r) {
+  // rows of r from frameBuf of stride pixels, each row through pixels
+
+    for (int y = r.top; y < r.bottom; y++)
+      pixels (frameBuf + (y * stride) + r.left, r.getWidth());
+    }
+  //}}}
+
+  virtual void submit() {}
+  virtual void wait() {}
+  virtual bool getPending() const { return false; }
+  virtual int getPixelAlign() const { return 1; }
+
+  //{{{
+  void commandData (const uint8_t command, const uint8_t* data, const int count) {
+    this->command (command);
+    this->data (data, count);
+    }
+  //}}}
+  //{{{
+  void commandWord (const uint8_t command, const uint16_t word) {
+    this->command (command);
+    pixels (&word, 1);
+    }
+  //}}}
+  };
+//}}}
+
+// spi
+//{{{
+class cLcdBusSpi : public cLcdBus {
+// main spi, spi manages ce0, rs gpio, pixels byteswapped through chunk buffer for spiWrite
+public:
+  cLcdBusSpi (const int spiSpeed, const uint8_t rsGpio) : mSpiSpeed(spiSpeed), mRsGpio(rsGpio) {}
+  virtual ~cLcdBusSpi();
+
+  virtual const char* getName() const { return "spi"; }
+  virtual bool open();
+
+  virtual void command (const uint8_t command);
+  virtual void data (const uint8_t* data, const int count);
+  virtual void pixels (const uint16_t* pixels, const int count);
+
+private:
+  static constexpr int kChunkPixels = 1024;
+
+  const int mSpiSpeed;
+  const uint8_t mRsGpio;
+
+  int mSpiHandle = -1;
+  uint16_t mChunk[kChunkPixels];
+  };
+//}}}
+//{{{
+class cLcdBusAuxSpi : public cLcdBus {
+// aux spi, cs2 managed by spiWriteAuxFast, rs gpio
+// - spiWriteAuxFast sends each 16bit word msb first, so pixels go straight out, data bytes are preswapped
+public:
+  cLcdBusAuxSpi (const int spiSpeed, const uint8_t rsGpio) : mSpiSpeed(spiSpeed), mRsGpio(rsGpio) {}
+  virtual ~cLcdBusAuxSpi();
+
+  virtual const char* getName() const { return "auxSpi"; }
+  virtual bool open();
+
+  virtual void command (const uint8_t command);
+  virtual void data (const uint8_t* data, const int count);
+  virtual void pixels (const uint16_t* pixels, const int count);
+
+private:
+  const int mSpiSpeed;
+  const uint8_t mRsGpio;
+
+  int mSpiHandle = -1;
+  };
+//}}}
+//{{{
+class cLcdBusSpiHeader : public cLcdBus {
+// main spi, no rs, ce gpio managed here, each transfer starts with a header byte
+// - 0x70 index register write, 0x72 data write, followed by 16bit index or data msb first
+public:
+  cLcdBusSpiHeader (const int spiSpeed, const uint8_t ceGpio) : mSpiSpeed(spiSpeed), mCeGpio(ceGpio) {}
+  virtual ~cLcdBusSpiHeader();
+
+  virtual const char* getName() const { return "spiHeader"; }
+  virtual bool open();
+
+  virtual void command (const uint8_t command);
+  virtual void data (const uint8_t* data, const int count);
+  virtual void pixels (const uint16_t* pixels, const int count);
+
+private:
+  static constexpr int kChunkBytes = 2048;
+
+  void transfer (const int count);
+
+  const int mSpiSpeed;
+  const uint8_t mCeGpio;
+
+  int mSpiHandle = -1;
+  uint8_t mChunk[1 + kChunkBytes];
+  };
+//}}}
+
+// parallel
+//{{{
+class cLcdBusParallel8 : public cLcdBus {
+// 8bit parallel, wr gpio23, rs gpio22, cs tied lo
+// - d1.d0 on gpio13.gpio12, d7..d2 on gpio7..gpio2, avoiding spi and i2c pins
+public:
+  cLcdBusParallel8() {}
+  virtual ~cLcdBusParallel8() {}
+
+  virtual const char* getName() const { return "parallel8"; }
+  virtual bool open();
+
+  virtual void command (const uint8_t command);
+  virtual void data (const uint8_t* data, const int count);
+  virtual void pixels (const uint16_t* pixels, const int count);
+
+private:
+  void write (const uint8_t byte);
+  };
+//}}}
+//{{{
+class cLcdBusParallel16 : public cLcdBus {
+// 16bit parallel, d15..d0 on gpio15..gpio0, wr and rs gpio, optional rd held hi and cs held lo
+// - each write holds data and wr over repeated register writes, for setup time
+public:
+  cLcdBusParallel16 (const uint8_t wrGpio, const uint8_t rsGpio, const int rdGpio = -1, const int csGpio = -1)
+    : mWrGpio(wrGpio), mRsGpio(rsGpio), mRdGpio(rdGpio), mCsGpio(csGpio) {}
+  virtual ~cLcdBusParallel16() {}
+
+  virtual const char* getName() const { return "parallel16"; }
+  virtual bool open();
+
+  virtual void command (const uint8_t command);
+  virtual void data (const uint8_t* data, const int count);
+  virtual void pixels (const uint16_t* pixels, const int count);
+
+private:
+  void write (const uint16_t word);
+
+  const uint8_t mWrGpio;
+  const uint8_t mRsGpio;
+  const int mRdGpio;
+  const int mCsGpio;
+  };
+//}}}
+
+// memory
+//{{{
+class cLcdBusRecorder : public cLcdBus {
+// records what a byte wide bus would send, for tests and timing without the transport
+// - consecutive data and pixels merge into one op, so streams compare regardless of how they were split
+public:
+  //{{{
+  struct sOp {
+    bool command;   // rs lo, one byte
+    uint32_t first; // index of first byte
+    uint32_t count; // bytes
+    };
+  //}}}
+
+  cLcdBusRecorder() {}
+  virtual ~cLcdBusRecorder() {}
+
+  virtual const char* getName() const { return "recorder"; }
+  virtual bool open() { return true; }
+
+  virtual void command (const uint8_t command);
+  virtual void data (const uint8_t* data, const int count);
+  virtual void pixels (const uint16_t* pixels, const int count);
+
+  const std::vector<sOp>& getOps() const { return mOps; }
+  const std::vector<uint8_t>& getBytes() const { return mBytes; }
+  uint32_t getNumCommands() const { return mNumCommands; }
+  uint32_t getNumPixels() const { return mNumPixels; }
+
+  void clear();
+
+private:
+  void addData (const uint32_t count);
+
+  std::vector<sOp> mOps;
+  std::vector<uint8_t> mBytes;
+
+  uint32_t mNumCommands = 0;
+  uint32_t mNumPixels = 0;
+  };
+//}}}
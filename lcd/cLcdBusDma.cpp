@@ -0,0 +1,389 @@
+// cLcdBusDma.cpp
+#include "cLcdBusDma.h"
+#include <cstring>
+
+#include "../pigpio/pigpioLite.h"
+#include "../../shared/utils/cLog.h"
+
+using namespace std;
+
+//{{{  cDmaHostPi
+//{{{
+cDmaHostPi::~cDmaHostPi() {
+
+  if (mSpiHandle >= 0)
+    spiClose (mSpiHandle);
+  }
+//}}}
+
+//{{{
+bool cDmaHostPi::open (const int spiSpeed, const uint8_t rsGpio) {
+
+  // rs - normally hi data
+  gpioSetMode (rsGpio, PI_OUTPUT);
+  gpioWrite (rsGpio, 1);
+
+  // mode 0, pins and clock, cs register then taken over for dma
+  mSpiHandle = spiOpen (0, spiSpeed, 0);
+  return mSpiHandle >= 0;
+  }
+//}}}
+
+//{{{
+bool cDmaHostPi::alloc (sMem& mem, const uint32_t size) {
+
+  void* virt;
+  mem.size = (size + 4095) & ~4095;
+  mem.handle = dmaMemAlloc (mem.size, &virt, &mem.bus);
+  mem.virt = mem.handle ? (uint8_t*)virt : nullptr;
+  return mem.handle != 0;
+  }
+//}}}
+//{{{
+void cDmaHostPi::free (sMem& mem) {
+
+  if (mem.handle)
+    dmaMemFree (mem.handle, mem.virt, mem.size);
+  mem = sMem();
+  }
+//}}}
+
+volatile uint32_t* cDmaHostPi::getDmaChannel (const int channel) { return dmaChannelRegs (channel); }
+volatile uint32_t* cDmaHostPi::getSpi() { return spiMainRegs(); }
+//}}}
+//{{{  cLcdBusDmaSpi
+constexpr uint32_t kSpiFifoBus = cDmaHost::kSpiBus + (cDmaHost::kSpiFifo * 4);
+
+constexpr uint32_t kTxTi = cDmaHost::kDmaPerMapSpiTx | cDmaHost::kDmaDestDreq | cDmaHost::kDmaSrcInc |
+                           cDmaHost::kDmaWaitResp;
+constexpr uint32_t kRxTi = cDmaHost::kDmaPerMapSpiRx | cDmaHost::kDmaSrcDreq | cDmaHost::kDmaDestIgnore;
+constexpr uint32_t kSequenceTi = cDmaHost::kDmaWaitResp;
+
+// constant words after transfer words
+constexpr int kRsConstant = 0;
+constexpr int kSpiIdleConstant = 1;
+constexpr int kDmaStartConstant = 2;
+constexpr int kNumConstants = 4;
+
+// public
+//{{{
+cLcdBusDmaSpi::cLcdBusDmaSpi (const int spiSpeed, const uint8_t rsGpio, cDmaHost* host,
+                              const int txChannel, const int sequenceChannel)
+  : mSpiSpeed(spiSpeed), mRsGpio(rsGpio), mHost(host ? host : new cDmaHostPi()),
+    mTxChannel(txChannel), mSequenceChannel(sequenceChannel) {}
+//}}}
+//{{{
+cLcdBusDmaSpi::~cLcdBusDmaSpi() {
+
+  wait();
+
+  mHost->free (mMirror);
+  mHost->free (mArena);
+  mHost->free (mChain);
+  delete mHost;
+  }
+//}}}
+
+//{{{
+bool cLcdBusDmaSpi::open() {
+
+  if (mTxChannel >= cDmaHost::kDmaFirstLite) {
+    cLog::log (LOGERROR, "dmaSpi tx channel is lite, no 2d mode");
+    return false;
+    }
+
+  if (!mHost->open (mSpiSpeed, mRsGpio))
+    return false;
+
+  if (!mHost->alloc (mChain, (kMaxControlBlocks * sizeof(cDmaHost::sControlBlock)) +
+                             (((kMaxTransfers * 2) + kNumConstants) * 4)) ||
+      !mHost->alloc (mArena, kArenaBytes))
+    return false;
+
+  mControlBlocks = (cDmaHost::sControlBlock*)mChain.virt;
+  mWords = (uint32_t*)(mControlBlocks + kMaxControlBlocks);
+  mConstants = mWords + (kMaxTransfers * 2);
+  mConstants[kRsConstant] = 1 << mRsGpio;
+  mConstants[kSpiIdleConstant] = cDmaHost::kSpiDmaEn | cDmaHost::kSpiAdcs | cDmaHost::kSpiClear;
+  mConstants[kDmaStartConstant] = cDmaHost::kDmaEnd | cDmaHost::kDmaActive;
+
+  mSequenceRegs = mHost->getDmaChannel (mSequenceChannel);
+  mTxRegs = mHost->getDmaChannel (mTxChannel);
+  mSequenceRegs[cDmaHost::kDmaCs] = cDmaHost::kDmaReset;
+  mTxRegs[cDmaHost::kDmaCs] = cDmaHost::kDmaReset;
+
+  // dma mode, ce0 deasserted after dlen bytes, mode 0, fifos cleared
+  mHost->getSpi()[cDmaHost::kSpiCs] = mConstants[kSpiIdleConstant];
+
+  reset();
+  return true;
+  }
+//}}}
+
+//{{{
+void cLcdBusDmaSpi::command (const uint8_t command) {
+
+  queue();
+  reserve (1, 1);
+  *append (false, 1) = command;
+  close();
+  }
+//}}}
+//{{{
+void cLcdBusDmaSpi::data (const uint8_t* data, const int count) {
+
+  queue();
+
+  uint32_t length = count;
+  while (length > 0) {
+    uint32_t sendBytes = (length > kMaxTransferBytes) ? kMaxTransferBytes : length;
+    reserve (1, sendBytes);
+    memcpy (append (true, sendBytes), data, sendBytes);
+    data += sendBytes;
+    length -= sendBytes;
+    }
+  }
+//}}}
+//{{{
+void cLcdBusDmaSpi::pixels (const uint16_t* pixels, const int count) {
+// msb first, byte at a time, arena position need not be aligned
+
+  queue();
+
+  uint32_t length = count;
+  while (length > 0) {
+    uint32_t sendPixels = (length > kMaxTransferBytes / 2) ? kMaxTransferBytes / 2 : length;
+    reserve (1, sendPixels * 2);
+    uint8_t* dst = append (true, sendPixels * 2);
+    for (uint32_t i = 0; i < sendPixels; i++) {
+      *dst++ = *pixels >> 8;
+      *dst++ = uint8_t(*pixels++);
+      }
+    length -= sendPixels;
+    }
+  }
+//}}}
+//{{{
+void cLcdBusDmaSpi::pixelRows (const uint16_t* frameBuf, const int stride, const cRect& r) {
+// byteswapped into mirror, sent from there as 2d blocks of rows
+// - even left, width and stride, so rows are whole words, else rows through pixels
+
+  const int width = r.getWidth();
+  if ((width <= 0) || (r.getHeight() <= 0))
+    return;
+
+  if ((r.left & 1) || (width & 1) || (stride & 1) || (width * 2 > (int)kMaxTransferBytes)) {
+    cLcdBus::pixelRows (frameBuf, stride, r);
+    return;
+    }
+
+  queue();
+
+  const uint32_t mirrorBytes = stride * r.bottom * 2;
+  if ((stride != mMirrorStride) || (mirrorBytes > mMirror.size)) {
+    //{{{  new mirror, after anything queued from the old one has gone
+    submit();
+    wait();
+
+    mHost->free (mMirror);
+    mMirrorStride = 0;
+    if (!mHost->alloc (mMirror, mirrorBytes)) {
+      cLog::log (LOGERROR, "dmaSpi mirror alloc failed");
+      cLcdBus::pixelRows (frameBuf, stride, r);
+      return;
+      }
+    mMirrorStride = stride;
+    }
+    //}}}
+
+  const uint32_t rowBytes = width * 2;
+  const uint32_t rowsPerTransfer = kMaxTransferBytes / rowBytes;
+  reserve ((r.getHeight() + rowsPerTransfer - 1) / rowsPerTransfer, 0);
+  close();
+
+  // byteswap pixel pairs, whole word writes to uncached memory
+  for (int y = r.top; y < r.bottom; y++) {
+    const uint32_t* src = (const uint32_t*)(frameBuf + (y * stride) + r.left);
+    uint32_t* dst = (uint32_t*)mMirror.virt + (((y * stride) + r.left) / 2);
+    for (int x = 0; x < width / 2; x++) {
+      uint32_t pair = *src++;
+      *dst++ = ((pair & 0x00FF00FF) << 8) | ((pair >> 8) & 0x00FF00FF);
+      }
+    }
+
+  uint32_t src = mMirror.bus + (((r.top * stride) + r.left) * 2);
+  for (int y = r.top; y < r.bottom; y += rowsPerTransfer) {
+    uint32_t rows = ((r.bottom - y) < (int)rowsPerTransfer) ? r.bottom - y : rowsPerTransfer;
+    transfer (true, src, rowBytes, rows, (stride - width) * 2);
+    src += rows * stride * 2;
+    }
+  }
+//}}}
+
+//{{{
+void cLcdBusDmaSpi::submit() {
+// start sequencer at head of chain, returns at once
+
+  if (mInFlight)
+    return;
+
+  close();
+  if (!mNumTransfers)
+    return;
+
+  // chain written before dma reads it
+  __sync_synchronize();
+
+  mSequenceRegs[cDmaHost::kDmaConblkAd] = getBus (mSequenceHead);
+  mSequenceRegs[cDmaHost::kDmaCs] = cDmaHost::kDmaEnd | cDmaHost::kDmaActive;
+
+  mInFlight = true;
+  mNumSubmittedTransfers = mNumTransfers;
+  mNumSubmittedControlBlocks = mNumControlBlocks;
+  }
+//}}}
+//{{{
+void cLcdBusDmaSpi::wait() {
+// anything queued submitted first, returns once sequencer has drained the last transfer
+
+  submit();
+  if (!mInFlight)
+    return;
+
+  while (mSequenceRegs[cDmaHost::kDmaCs] & cDmaHost::kDmaActive)
+    if (!mHost->service()) {
+      cLog::log (LOGERROR, string ("dmaSpi chain stalled on ") + mHost->getName());
+      mSequenceRegs[cDmaHost::kDmaCs] = cDmaHost::kDmaReset;
+      mTxRegs[cDmaHost::kDmaCs] = cDmaHost::kDmaReset;
+      break;
+      }
+
+  mInFlight = false;
+  reset();
+  }
+//}}}
+
+// private
+//{{{
+void cLcdBusDmaSpi::queue() {
+// chain memory is reused, so queueing behind a submitted chain waits for it
+
+  if (mInFlight)
+    wait();
+  }
+//}}}
+//{{{
+void cLcdBusDmaSpi::reserve (const uint32_t transfers, const uint32_t bytes) {
+// room for transfers and arena bytes, besides closing the open transfer, else send what is queued
+
+  if ((mNumTransfers + transfers + 1 > kMaxTransfers) || (mArenaUsed + bytes + 4 > kArenaBytes)) {
+    submit();
+    wait();
+    }
+  }
+//}}}
+//{{{
+uint8_t* cLcdBusDmaSpi::append (const bool rs, const uint32_t bytes) {
+// arena bytes at end of open transfer, else close it and open a word aligned one
+
+  if (!mOpen || (mOpenRs != rs) || (mOpenBytes + bytes > kMaxTransferBytes)) {
+    close();
+    mArenaUsed = (mArenaUsed + 3) & ~3;
+    mOpen = true;
+    mOpenRs = rs;
+    mOpenFirst = mArenaUsed;
+    mOpenBytes = 0;
+    }
+
+  uint8_t* dst = mArena.virt + mArenaUsed;
+  mOpenBytes += bytes;
+  mArenaUsed += bytes;
+  return dst;
+  }
+//}}}
+//{{{
+void cLcdBusDmaSpi::close() {
+
+  if (mOpen) {
+    mOpen = false;
+    transfer (mOpenRs, mArena.bus + mOpenFirst, mOpenBytes, 1, 0);
+    }
+  }
+//}}}
+
+//{{{
+void cLcdBusDmaSpi::transfer (const bool rs, const uint32_t src, const uint32_t rowBytes, const uint32_t rows,
+                              const int32_t srcStride) {
+// tx header and data control blocks, then sequencer sets rs, starts tx and drains rx
+
+  const uint32_t bytes = rowBytes * rows;
+  uint32_t* words = mWords + (mNumTransfers++ * 2);
+
+  // first fifo write of a transfer, ta clear, sets dlen and cs
+  words[0] = (bytes << 16) | cDmaHost::kSpiTa;
+
+  // tx, data as whole words, padding past dlen cleared from fifo before next transfer
+  cDmaHost::sControlBlock* header = addControlBlock (kTxTi, getBus (words), kSpiFifoBus, 4);
+  cDmaHost::sControlBlock* data;
+  if (rows > 1) {
+    // 2d, rows - 1 per datasheet errata
+    data = addControlBlock (kTxTi | cDmaHost::kDmaTdMode, src, kSpiFifoBus, ((rows - 1) << 16) | rowBytes);
+    data->stride = uint32_t(srcStride) & 0xFFFF;
+    }
+  else
+    data = addControlBlock (kTxTi, src, kSpiFifoBus, (bytes + 3) & ~3);
+  header->next = getBus (data);
+  words[1] = getBus (header);
+
+  // sequencer, rs once previous transfer has shifted out, always at head of chain
+  if ((rs != mRs) || !mSequenceHead) {
+    sequence (addControlBlock (kSequenceTi, getBus (mConstants + kRsConstant),
+                               rs ? cDmaHost::kGpioSet0Bus : cDmaHost::kGpioClr0Bus, 4));
+    mRs = rs;
+    }
+  sequence (addControlBlock (kSequenceTi, getBus (words + 1),
+                             getDmaBus (mTxChannel) + (cDmaHost::kDmaConblkAd * 4), 4));
+  sequence (addControlBlock (kSequenceTi, getBus (mConstants + kSpiIdleConstant),
+                             cDmaHost::kSpiBus + (cDmaHost::kSpiCs * 4), 4));
+  sequence (addControlBlock (kSequenceTi, getBus (mConstants + kDmaStartConstant),
+                             getDmaBus (mTxChannel) + (cDmaHost::kDmaCs * 4), 4));
+  sequence (addControlBlock (kRxTi, kSpiFifoBus, 0, bytes));
+  }
+//}}}
+//{{{
+cDmaHost::sControlBlock* cLcdBusDmaSpi::addControlBlock (const uint32_t ti, const uint32_t src,
+                                                         const uint32_t dst, const uint32_t len) {
+
+  cDmaHost::sControlBlock* controlBlock = mControlBlocks + mNumControlBlocks++;
+  controlBlock->ti = ti;
+  controlBlock->src = src;
+  controlBlock->dst = dst;
+  controlBlock->len = len;
+  controlBlock->stride = 0;
+  controlBlock->next = 0;
+  return controlBlock;
+  }
+//}}}
+//{{{
+void cLcdBusDmaSpi::sequence (cDmaHost::sControlBlock* controlBlock) {
+// link onto sequencer chain
+
+  if (mSequenceTail)
+    mSequenceTail->next = getBus (controlBlock);
+  else
+    mSequenceHead = controlBlock;
+  mSequenceTail = controlBlock;
+  }
+//}}}
+//{{{
+void cLcdBusDmaSpi::reset() {
+
+  mNumTransfers = 0;
+  mNumControlBlocks = 0;
+  mArenaUsed = 0;
+  mOpen = false;
+  mSequenceHead = nullptr;
+  mSequenceTail = nullptr;
+  }
+//}}}
+//}}}
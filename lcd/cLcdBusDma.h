@@ -0,0 +1,202 @@
+// cLcdBusDma.h - main spi lcd bus streamed by a dma control block chain, cpu free while it goes out
+#pragma once
+#include <cstdint>
+#include "cLcdBus.h"
+
+//{{{
+class cDmaHost {
+// soc resources cLcdBusDmaSpi drives, the pi through pigpioLite, or simulated by cDmaModel
+// - memory uncached, page aligned, at a bus address the dma sees
+// - registers as the cpu sees them, dma channel file cs first, spi0 file cs first
+public:
+  //{{{
+  struct sMem {
+    uint8_t* virt = nullptr;
+    uint32_t bus = 0;
+    uint32_t size = 0;
+    uint32_t handle = 0;
+    };
+  //}}}
+  //{{{
+  struct sControlBlock {
+    uint32_t ti;
+    uint32_t src;
+    uint32_t dst;
+    uint32_t len;    // 2d mode, ylength rows - 1 << 16 | xlength row bytes
+    uint32_t stride; // 2d mode, dst stride << 16 | src stride, signed bytes added after each row
+    uint32_t next;
+    uint32_t reserved[2];
+    };
+  //}}}
+
+  // bus addresses, same on every pi
+  static constexpr uint32_t kDmaBus = 0x7E007000;
+  static constexpr uint32_t kDmaChannelBytes = 0x100;
+  static constexpr uint32_t kSpiBus = 0x7E204000;
+  static constexpr uint32_t kGpioSet0Bus = 0x7E20001C;
+  static constexpr uint32_t kGpioClr0Bus = 0x7E200028;
+
+  // dma channel registers, words
+  static constexpr int kDmaCs = 0;
+  static constexpr int kDmaConblkAd = 1;
+  static constexpr int kDmaDebug = 8;
+
+  static constexpr uint32_t kDmaActive = 1 << 0;
+  static constexpr uint32_t kDmaEnd    = 1 << 1;
+  static constexpr uint32_t kDmaReset  = 1u << 31;
+
+  // control block ti
+  static constexpr uint32_t kDmaTdMode     = 1 << 1;
+  static constexpr uint32_t kDmaWaitResp   = 1 << 3;
+  static constexpr uint32_t kDmaDestInc    = 1 << 4;
+  static constexpr uint32_t kDmaDestDreq   = 1 << 6;
+  static constexpr uint32_t kDmaDestIgnore = 1 << 7;
+  static constexpr uint32_t kDmaSrcInc     = 1 << 8;
+  static constexpr uint32_t kDmaSrcDreq    = 1 << 10;
+  static constexpr uint32_t kDmaSrcIgnore  = 1 << 11;
+  static constexpr uint32_t kDmaPerMapSpiTx = 6 << 16;
+  static constexpr uint32_t kDmaPerMapSpiRx = 7 << 16;
+
+  // channels 7.. are lite, no 2d mode
+  static constexpr int kDmaFirstLite = 7;
+
+  // spi registers, words
+  static constexpr int kSpiCs = 0;
+  static constexpr int kSpiFifo = 1;
+  static constexpr int kSpiDlen = 3;
+
+  static constexpr uint32_t kSpiClear = 3 << 4;
+  static constexpr uint32_t kSpiTa    = 1 << 7;
+  static constexpr uint32_t kSpiDmaEn = 1 << 8;
+  static constexpr uint32_t kSpiAdcs  = 1 << 11;
+  static constexpr uint32_t kSpiDone  = 1 << 16;
+
+  virtual ~cDmaHost() {}
+
+  virtual const char* getName() const = 0;
+  virtual bool open (const int spiSpeed, const uint8_t rsGpio) = 0;
+
+  virtual bool alloc (sMem& mem, const uint32_t size) = 0;
+  virtual void free (sMem& mem) = 0;
+
+  virtual volatile uint32_t* getDmaChannel (const int channel) = 0;
+  virtual volatile uint32_t* getSpi() = 0;
+
+  // called while waiting, a simulated host runs its dma here, false if the chain can never finish
+  virtual bool service() { return true; }
+  };
+//}}}
+//{{{
+class cDmaHostPi : public cDmaHost {
+// pigpioLite mailbox memory and mapped registers, spiOpen sets up spi0 pins and clock
+public:
+  cDmaHostPi() {}
+  virtual ~cDmaHostPi();
+
+  virtual const char* getName() const { return "pi"; }
+  virtual bool open (const int spiSpeed, const uint8_t rsGpio);
+
+  virtual bool alloc (sMem& mem, const uint32_t size);
+  virtual void free (sMem& mem);
+
+  virtual volatile uint32_t* getDmaChannel (const int channel);
+  virtual volatile uint32_t* getSpi();
+
+private:
+  int mSpiHandle = -1;
+  };
+//}}}
+
+//{{{
+class cLcdBusDmaSpi : public cLcdBus {
+// main spi ce0, rs gpio, everything queued into one dma chain, submit starts it and returns at once
+// - data and pixels copied into uncached memory, pixelRows byteswapped into a frame shaped mirror,
+//   so the caller diffs and draws its next frame while this one goes out
+// - each spi transfer is a tx chain, dlen header word then data, pixelRows rect as 2d blocks striding the mirror
+// - sequencer channel drains spi rx, a drain completes once its bytes have shifted out, then the sequencer
+//   sets rs, clears spi ta and fifos, points the tx channel at the next transfer and starts it
+// - pixelRows rects with even left and width go as 2d blocks of whole words, others row by row
+// - aux spi has no dma dreq, so this is main spi
+public:
+  cLcdBusDmaSpi (const int spiSpeed, const uint8_t rsGpio, cDmaHost* host = nullptr,
+                 const int txChannel = 5, const int sequenceChannel = 4);
+  virtual ~cLcdBusDmaSpi();
+
+  virtual const char* getName() const { return "dmaSpi"; }
+  virtual bool open();
+
+  virtual void command (const uint8_t command);
+  virtual void data (const uint8_t* data, const int count);
+  virtual void pixels (const uint16_t* pixels, const int count);
+  virtual void pixelRows (const uint16_t* frameBuf, const int stride, const cRect& r);
+
+  virtual void submit();
+  virtual void wait();
+  virtual bool getPending() const { return mInFlight || mNumTransfers || mOpen; }
+  virtual int getPixelAlign() const { return 2; }
+
+  cDmaHost* getHost() { return mHost; }
+  uint32_t getNumTransfers() const { return mNumSubmittedTransfers; }
+  uint32_t getNumControlBlocks() const { return mNumSubmittedControlBlocks; }
+
+private:
+  static constexpr uint32_t kMaxTransfers = 1024;
+  static constexpr uint32_t kMaxControlBlocks = kMaxTransfers * 7;
+  static constexpr uint32_t kArenaBytes = 0x20000;
+  static constexpr uint32_t kMaxTransferBytes = 0xFFFC;
+
+  void queue();
+  void reserve (const uint32_t transfers, const uint32_t bytes);
+  uint8_t* append (const bool rs, const uint32_t bytes);
+  void close();
+
+  void transfer (const bool rs, const uint32_t src, const uint32_t rowBytes, const uint32_t rows,
+                 const int32_t srcStride);
+  cDmaHost::sControlBlock* addControlBlock (const uint32_t ti, const uint32_t src, const uint32_t dst,
+                                            const uint32_t len);
+  void sequence (cDmaHost::sControlBlock* controlBlock);
+  void reset();
+
+  uint32_t getBus (const void* virt) const { return mChain.bus + uint32_t((const uint8_t*)virt - mChain.virt); }
+  uint32_t getDmaBus (const int channel) const { return cDmaHost::kDmaBus + (channel * cDmaHost::kDmaChannelBytes); }
+
+  const int mSpiSpeed;
+  const uint8_t mRsGpio;
+  cDmaHost* mHost;
+  const int mTxChannel;
+  const int mSequenceChannel;
+
+  volatile uint32_t* mSequenceRegs = nullptr;
+  volatile uint32_t* mTxRegs = nullptr;
+
+  // control blocks, then per transfer header and tx address words, then constant words
+  cDmaHost::sMem mChain;
+  cDmaHost::sControlBlock* mControlBlocks = nullptr;
+  uint32_t* mWords = nullptr;
+  uint32_t* mConstants = nullptr;
+
+  // commands, data and pixels
+  cDmaHost::sMem mArena;
+  uint32_t mArenaUsed = 0;
+
+  // frameBuf shaped, pixelRows rects byteswapped in place
+  cDmaHost::sMem mMirror;
+  int mMirrorStride = 0;
+
+  uint32_t mNumTransfers = 0;
+  uint32_t mNumControlBlocks = 0;
+  cDmaHost::sControlBlock* mSequenceHead = nullptr;
+  cDmaHost::sControlBlock* mSequenceTail = nullptr;
+  bool mRs = true;
+
+  // open transfer, at end of arena, grows while data or pixels follow each other
+  bool mOpen = false;
+  bool mOpenRs = true;
+  uint32_t mOpenFirst = 0;
+  uint32_t mOpenBytes = 0;
+
+  bool mInFlight = false;
+  uint32_t mNumSubmittedTransfers = 0;
+  uint32_t mNumSubmittedControlBlocks = 0;
+  };
+//}}}
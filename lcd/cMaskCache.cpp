@@ -0,0 +1,125 @@
+// cMaskCache.cpp
+#include "cMaskCache.h"
+#include "cDrawAA.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// public
+//{{{
+cMaskCache::~cMaskCache() {
+
+  clear();
+  delete mDrawAA;
+  }
+//}}}
+
+//{{{
+void cMaskCache::setMaxBytes (const uint32_t maxBytes) {
+
+  mMaxBytes = maxBytes;
+  evict (maxBytes);
+  }
+//}}}
+//{{{
+void cMaskCache::clear() {
+
+  evict (0);
+  }
+//}}}
+
+//{{{
+const cMaskCache::sMask* cMaskCache::find (const uint64_t key) {
+// hit moves mask to head of lru
+
+  auto it = mMasks.find (key);
+  if (it == mMasks.end()) {
+    mMisses++;
+    return nullptr;
+    }
+
+  mHits++;
+  sMask* mask = it->second;
+  if (mask != mHead) {
+    unlink (mask);
+    linkHead (mask);
+    }
+
+  return mask;
+  }
+//}}}
+//{{{
+cMaskCache::sMask* cMaskCache::add (const uint64_t key, const cRect& bounds) {
+// new zeroed mask at head, lru evicted to make room, nullptr if it could never fit
+
+  uint32_t bytes = getMaskBytes (bounds);
+  if (bytes > mMaxBytes)
+    return nullptr;
+
+  evict (mMaxBytes - bytes);
+
+  // header and mask in one allocation
+  sMask* mask = (sMask*)malloc (bytes);
+  mask->key = key;
+  mask->bounds = bounds;
+  mask->mask = (uint8_t*)(mask + 1);
+  memset (mask->mask, 0, bytes - sizeof(sMask));
+
+  linkHead (mask);
+  mMasks[key] = mask;
+  mBytes += bytes;
+
+  return mask;
+  }
+//}}}
+
+//{{{
+cDrawAA& cMaskCache::getDrawAA() {
+
+  if (!mDrawAA)
+    mDrawAA = new cDrawAA();
+  return *mDrawAA;
+  }
+//}}}
+
+// private
+//{{{
+void cMaskCache::unlink (sMask* mask) {
+
+  if (mask->prev)
+    mask->prev->next = mask->next;
+  else
+    mHead = mask->next;
+
+  if (mask->next)
+    mask->next->prev = mask->prev;
+  else
+    mTail = mask->prev;
+  }
+//}}}
+//{{{
+void cMaskCache::linkHead (sMask* mask) {
+
+  mask->prev = nullptr;
+  mask->next = mHead;
+  if (mHead)
+    mHead->prev = mask;
+  else
+    mTail = mask;
+  mHead = mask;
+  }
+//}}}
+//{{{
+void cMaskCache::evict (const uint32_t maxBytes) {
+// free least recently used until bytes under maxBytes
+
+  while (mTail && (mBytes > maxBytes)) {
+    sMask* mask = mTail;
+    unlink (mask);
+    mMasks.erase (mask->key);
+    mBytes -= getMaskBytes (mask->bounds);
+    free (mask);
+    }
+  }
+//}}}
@@ -0,0 +1,73 @@
+// cMaskCache.h - coverage masks of repeated aa paths, keyed by path hash and subpixel offset, lru evicted
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include "cPointRect.h"
+
+class cDrawAA;
+
+//{{{
+class cMaskCache {
+// - mask is gamma corrected coverage, bounds relative to the integer position the path was drawn at
+// - lru as intrusive list, hit moves mask to head, add evicts from tail until under maxBytes
+public:
+  //{{{
+  struct sMask {
+    uint64_t key;
+    cRect bounds;
+    uint8_t* mask;
+
+    sMask* prev;
+    sMask* next;
+    };
+  //}}}
+
+  cMaskCache (const uint32_t maxBytes) : mMaxBytes(maxBytes) {}
+  ~cMaskCache();
+
+  uint32_t getBytes() const { return mBytes; }
+  uint32_t getMaxBytes() const { return mMaxBytes; }
+  uint32_t getNumMasks() const { return (uint32_t)mMasks.size(); }
+  uint32_t getHits() const { return mHits; }
+  uint32_t getMisses() const { return mMisses; }
+
+  void setMaxBytes (const uint32_t maxBytes);
+  void clear();
+
+  const sMask* find (const uint64_t key);
+  sMask* add (const uint64_t key, const cRect& bounds);
+
+  // unclipped rasteriser for misses, own so no pending path or clip box of the caller's reaches a mask
+  cDrawAA& getDrawAA();
+
+  //{{{
+  static uint64_t mix (uint64_t hash, const uint32_t value) {
+  // fnv-1a, value folded in a byte at a time, as cPath::getHash
+
+    for (int i = 0; i < 4; i++) {
+      hash ^= (value >> (i * 8)) & 0xFF;
+      hash *= 0x100000001b3ull;
+      }
+    return hash;
+    }
+  //}}}
+
+private:
+  static uint32_t getMaskBytes (cRect bounds) { return sizeof(sMask) + bounds.getNumPixels(); }
+
+  void unlink (sMask* mask);
+  void linkHead (sMask* mask);
+  void evict (const uint32_t maxBytes);
+
+  uint32_t mMaxBytes;
+  uint32_t mBytes = 0;
+  uint32_t mHits = 0;
+  uint32_t mMisses = 0;
+
+  sMask* mHead = nullptr;
+  sMask* mTail = nullptr;
+  std::unordered_map<uint64_t, sMask*> mMasks;
+
+  cDrawAA* mDrawAA = nullptr;
+  };
+//}}}
@@ -0,0 +1,304 @@
+// cPath.cpp
+#include "cPath.h"
+#include "cDrawAA.h"
+
+using namespace std;
+
+//{{{
+static inline float dot (const cPointF& a, const cPointF& b) {
+  return (a.x * b.x) + (a.y * b.y);
+  }
+//}}}
+//{{{
+static inline float cross (const cPointF& a, const cPointF& b) {
+  return (a.x * b.y) - (a.y * b.x);
+  }
+//}}}
+//{{{
+static inline cPointF normal (const cPointF& d) {
+// left normal of unit direction
+  return cPointF (-d.y, d.x);
+  }
+//}}}
+//{{{
+static inline cPointF direction (const cPointF& p1, const cPointF& p2) {
+  cPointF d = p2 - p1;
+  return d / d.magnitude();
+  }
+//}}}
+
+// public
+//{{{
+void cPath::clear() {
+
+  mPoints.clear();
+  mContours.clear();
+  }
+//}}}
+//{{{
+void cPath::translate (const cPointF& offset) {
+
+  for (auto& point : mPoints)
+    point = point + offset;
+  }
+//}}}
+//{{{
+uint64_t cPath::getHash() const {
+// fnv-1a over points and contours, identifies geometry for cMaskCache
+
+  uint64_t hash = 0xcbf29ce484222325ull;
+  //{{{
+  auto add = [&](const void* data, const size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+      hash ^= ((const uint8_t*)data)[i];
+      hash *= 0x100000001b3ull;
+      }
+    };
+  //}}}
+
+  add (mPoints.data(), mPoints.size() * sizeof(cPointF));
+  for (auto& contour : mContours) {
+    add (&contour.num, sizeof(contour.num));
+    add (&contour.closed, sizeof(contour.closed));
+    }
+
+  return hash;
+  }
+//}}}
+
+//{{{
+void cPath::moveTo (const cPointF& p) {
+
+  mContours.push_back ({ (int)mPoints.size(), 1, false });
+  mPoints.push_back (p);
+  }
+//}}}
+//{{{
+void cPath::lineTo (const cPointF& p) {
+// repeated points dropped, stroke directions need length
+
+  if (mContours.empty() || mContours.back().closed) {
+    moveTo (p);
+    return;
+    }
+
+  const cPointF& last = mPoints.back();
+  if ((p.x == last.x) && (p.y == last.y))
+    return;
+
+  mPoints.push_back (p);
+  mContours.back().num++;
+  }
+//}}}
+//{{{
+void cPath::quadTo (const cPointF& c, const cPointF& p) {
+
+  if (mContours.empty())
+    moveTo (c);
+
+  flattenQuad (mPoints.back(), c, p, mTolerance, [&](const cPointF& point) { lineTo (point); });
+  }
+//}}}
+//{{{
+void cPath::cubicTo (const cPointF& c1, const cPointF& c2, const cPointF& p) {
+
+  if (mContours.empty())
+    moveTo (c1);
+
+  flattenCubic (mPoints.back(), c1, c2, p, mTolerance, [&](const cPointF& point) { lineTo (point); });
+  }
+//}}}
+//{{{
+void cPath::close() {
+// closing point dropped if it repeats the first
+
+  if (mContours.empty() || mContours.back().closed)
+    return;
+
+  sContour& contour = mContours.back();
+  const cPointF& first = mPoints[contour.first];
+  const cPointF& last = mPoints.back();
+  if ((contour.num > 1) && (first.x == last.x) && (first.y == last.y)) {
+    mPoints.pop_back();
+    contour.num--;
+    }
+  contour.closed = true;
+  }
+//}}}
+
+//{{{
+void cPath::fill (cDrawAA& drawAA) const {
+
+  for (auto& contour : mContours)
+    if (contour.num > 2) {
+      const cPointF* point = mPoints.data() + contour.first;
+      drawAA.moveTo (toFixed (point->x), toFixed (point->y));
+      for (int i = 1; i < contour.num; i++) {
+        point++;
+        drawAA.lineTo (toFixed (point->x), toFixed (point->y));
+        }
+      }
+  }
+//}}}
+//{{{
+void cPath::stroke (cDrawAA& drawAA, const float width,
+                    const eJoin join, const eCap cap, const float miterLimit) const {
+
+  if (width <= 0.f)
+    return;
+
+  for (auto& contour : mContours)
+    strokeContour (drawAA, contour, width / 2.f, join, cap, miterLimit);
+  }
+//}}}
+
+// private
+//{{{
+void cPath::polygon (cDrawAA& drawAA, const cPointF* points, const int numPoints) {
+// emit polygon wound positive, reversed if its signed area is negative
+
+  float area = 0.f;
+  for (int i = 0; i < numPoints; i++)
+    area += cross (points[i], points[(i + 1) % numPoints]);
+  if (area == 0.f)
+    return;
+
+  int first = area > 0.f ? 0 : numPoints - 1;
+  int inc = area > 0.f ? 1 : -1;
+  drawAA.moveTo (toFixed (points[first].x), toFixed (points[first].y));
+  for (int i = 1; i < numPoints; i++) {
+    const cPointF& point = points[first + (i * inc)];
+    drawAA.lineTo (toFixed (point.x), toFixed (point.y));
+    }
+  }
+//}}}
+//{{{
+void cPath::fan (cDrawAA& drawAA, const cPointF& centre, const cPointF& from, const float angle, const int steps) {
+// pie from centre, edge from centre + from rotated through angle, in steps, rotation stepped not recomputed
+
+  float c = cosf (angle / steps);
+  float s = sinf (angle / steps);
+
+  vector<cPointF> points;
+  points.reserve (steps + 2);
+  points.push_back (centre);
+
+  cPointF v = from;
+  points.push_back (centre + v);
+  for (int i = 0; i < steps; i++) {
+    v = cPointF ((v.x * c) - (v.y * s), (v.x * s) + (v.y * c));
+    points.push_back (centre + v);
+    }
+
+  polygon (drawAA, points.data(), (int)points.size());
+  }
+//}}}
+
+//{{{
+void cPath::strokeContour (cDrawAA& drawAA, const sContour& contour, const float halfWidth,
+                           const eJoin join, const eCap cap, const float miterLimit) const {
+
+  const cPointF* points = mPoints.data() + contour.first;
+  int numPoints = contour.num;
+
+  if (numPoints == 1) {
+    //{{{  single point, round cap is disc, square cap is square
+    const cPointF& p = points[0];
+    if (cap == eRoundCap)
+      fan (drawAA, p, cPointF (halfWidth, 0.f), 2.f * (float)M_PI,
+           getArcSegments (halfWidth, 2.f * (float)M_PI, mTolerance));
+
+    else if (cap == eSquareCap) {
+      cPointF square[4] = { p + cPointF (-halfWidth, -halfWidth), p + cPointF (halfWidth, -halfWidth),
+                            p + cPointF (halfWidth, halfWidth), p + cPointF (-halfWidth, halfWidth) };
+      polygon (drawAA, square, 4);
+      }
+
+    return;
+    }
+    //}}}
+
+  bool closed = contour.closed && (numPoints > 2);
+  int numSegments = closed ? numPoints : numPoints - 1;
+
+  // segment quads
+  for (int i = 0; i < numSegments; i++) {
+    const cPointF& p1 = points[i];
+    const cPointF& p2 = points[(i + 1) % numPoints];
+    cPointF n = normal (direction (p1, p2)) * halfWidth;
+    cPointF quad[4] = { p1 + n, p2 + n, p2 - n, p1 - n };
+    polygon (drawAA, quad, 4);
+    }
+
+  // joins
+  for (int i = closed ? 0 : 1; i < (closed ? numPoints : numPoints - 1); i++) {
+    const cPointF& p = points[i];
+    const cPointF& prev = points[(i + numPoints - 1) % numPoints];
+    const cPointF& next = points[(i + 1) % numPoints];
+    strokeJoin (drawAA, p, direction (prev, p), direction (p, next), halfWidth, join, miterLimit);
+    }
+
+  // caps
+  if (!closed) {
+    strokeCap (drawAA, points[0], direction (points[1], points[0]), halfWidth, cap);
+    strokeCap (drawAA, points[numPoints-1], direction (points[numPoints-2], points[numPoints-1]), halfWidth, cap);
+    }
+  }
+//}}}
+//{{{
+void cPath::strokeJoin (cDrawAA& drawAA, const cPointF& p, const cPointF& da, const cPointF& db,
+                        const float halfWidth, const eJoin join, const float miterLimit) const {
+// fill outer gap between segment quads of incoming direction da, outgoing db
+
+  float turn = cross (da, db);
+  if ((fabsf (turn) < 1e-6f) && (dot (da, db) > 0.f))
+    // straight on
+    return;
+
+  // outer side is opposite the turn
+  float side = turn > 0.f ? -1.f : 1.f;
+  cPointF na = normal (da) * side;
+  cPointF nb = normal (db) * side;
+
+  if (join == eRoundJoin) {
+    float angle = acosf (fmaxf (-1.f, fminf (1.f, dot (na, nb))));
+    // rotate na towards da, the way nb lies
+    float rotation = cross (na, da) >= 0.f ? angle : -angle;
+    fan (drawAA, p, na * halfWidth, rotation, getArcSegments (halfWidth, angle, mTolerance));
+    return;
+    }
+
+  cPointF bevel[4] = { p, p + (na * halfWidth), p + (nb * halfWidth), p };
+  if (join == eMiterJoin) {
+    // miter tip along bisector, halfWidth / cos (half angle) out, ratio to halfWidth against limit
+    cPointF bisector = na + nb;
+    float length2 = dot (bisector, bisector);
+    if ((length2 > 1e-6f) && ((2.f / sqrtf (length2)) <= miterLimit)) {
+      cPointF miter[4] = { p, p + (na * halfWidth), p + (bisector * (2.f * halfWidth / length2)), p + (nb * halfWidth) };
+      polygon (drawAA, miter, 4);
+      return;
+      }
+    }
+
+  polygon (drawAA, bevel, 3);
+  }
+//}}}
+//{{{
+void cPath::strokeCap (cDrawAA& drawAA, const cPointF& p, const cPointF& d, const float halfWidth,
+                       const eCap cap) const {
+// cap at end point p, d unit direction pointing out of the line
+
+  cPointF n = normal (d) * halfWidth;
+
+  if (cap == eRoundCap)
+    // half disc from n through d to -n
+    fan (drawAA, p, n, cross (n, d) >= 0.f ? (float)M_PI : -(float)M_PI,
+         getArcSegments (halfWidth, (float)M_PI, mTolerance));
+
+  else if (cap == eSquareCap) {
+    cPointF out = d * halfWidth;
+    cPointF square[4] = { p + n, p + n + out, p - n + out, p - n };
+    polygon (drawAA, square, 4);
+    }
+  }
+//}}}
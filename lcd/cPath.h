@@ -0,0 +1,140 @@
+// cPath.h - float path, curves flattened to tolerance, filled or stroked into cDrawAA
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include "cPointRect.h"
+
+class cDrawAA;
+
+//{{{
+class cPath {
+// - curves flattened as added, segment count from curvature, so error stays under tolerance pixels
+// - stroke emits segment quads, joins and caps as separate polygons, all wound the same way,
+//   so nonzero fill renders their union without seams
+public:
+  enum eJoin { eMiterJoin, eRoundJoin, eBevelJoin };
+  enum eCap { eButtCap, eRoundCap, eSquareCap };
+
+  cPath (const float tolerance = 0.25f) : mTolerance(tolerance) {}
+
+  float getTolerance() const { return mTolerance; }
+  void setTolerance (const float tolerance) { mTolerance = tolerance; }
+
+  bool isEmpty() const { return mPoints.empty(); }
+  int getNumPoints() const { return (int)mPoints.size(); }
+  void clear();
+  void translate (const cPointF& offset);
+  uint64_t getHash() const;
+
+  void moveTo (const cPointF& p);
+  void lineTo (const cPointF& p);
+  void quadTo (const cPointF& c, const cPointF& p);
+  void cubicTo (const cPointF& c1, const cPointF& c2, const cPointF& p);
+  void close();
+
+  void fill (cDrawAA& drawAA) const;
+  void stroke (cDrawAA& drawAA, const float width,
+               const eJoin join = eMiterJoin, const eCap cap = eButtCap, const float miterLimit = 4.f) const;
+
+  //{{{
+  static int32_t toFixed (const float v) {
+  // 24.8, rounded not truncated, so whole pixel translation is exact either side of 0
+    return (int32_t)floorf ((v * 256.f) + 0.5f);
+    }
+  //}}}
+  //{{{
+  static int getQuadSegments (const cPointF& p0, const cPointF& c, const cPointF& p1, const float tolerance) {
+  // chord error of n uniform steps is |p0 - 2c + p1| / (4 n^2)
+
+    float ddx = p0.x - (2.f * c.x) + p1.x;
+    float ddy = p0.y - (2.f * c.y) + p1.y;
+    int n = (int)ceilf (sqrtf (sqrtf ((ddx * ddx) + (ddy * ddy)) / (4.f * tolerance)));
+    return n < 1 ? 1 : n;
+    }
+  //}}}
+  //{{{
+  static int getCubicSegments (const cPointF& p0, const cPointF& c1, const cPointF& c2, const cPointF& p1,
+                               const float tolerance) {
+  // chord error of n uniform steps is at most 3/4 max second difference / n^2
+
+    float dd1x = p0.x - (2.f * c1.x) + c2.x;
+    float dd1y = p0.y - (2.f * c1.y) + c2.y;
+    float dd2x = c1.x - (2.f * c2.x) + p1.x;
+    float dd2y = c1.y - (2.f * c2.y) + p1.y;
+    float dd = sqrtf (fmaxf ((dd1x * dd1x) + (dd1y * dd1y), (dd2x * dd2x) + (dd2y * dd2y)));
+    int n = (int)ceilf (sqrtf ((0.75f * dd) / tolerance));
+    return n < 1 ? 1 : n;
+    }
+  //}}}
+  //{{{
+  static int getArcSegments (const float radius, const float angle, const float tolerance) {
+  // sagitta of each chord under tolerance
+
+    float c = 1.f - (tolerance / radius);
+    float step = 2.f * acosf (c < 0.f ? 0.f : c);
+    int n = (int)ceilf (angle / step);
+    return n < 1 ? 1 : n;
+    }
+  //}}}
+
+  //{{{
+  template <class tLineTo>
+  static void flattenQuad (const cPointF& p0, const cPointF& c, const cPointF& p1, const float tolerance,
+                           tLineTo lineTo) {
+
+    int n = getQuadSegments (p0, c, p1, tolerance);
+    for (int i = 1; i < n; i++) {
+      float t = float(i) / n;
+      float mt = 1.f - t;
+      lineTo (cPointF ((mt * mt * p0.x) + (2.f * mt * t * c.x) + (t * t * p1.x),
+                       (mt * mt * p0.y) + (2.f * mt * t * c.y) + (t * t * p1.y)));
+      }
+    lineTo (p1);
+    }
+  //}}}
+  //{{{
+  template <class tLineTo>
+  static void flattenCubic (const cPointF& p0, const cPointF& c1, const cPointF& c2, const cPointF& p1,
+                            const float tolerance, tLineTo lineTo) {
+
+    int n = getCubicSegments (p0, c1, c2, p1, tolerance);
+    for (int i = 1; i < n; i++) {
+      float t = float(i) / n;
+      float mt = 1.f - t;
+      float a = mt * mt * mt;
+      float b = 3.f * mt * mt * t;
+      float d = 3.f * mt * t * t;
+      float e = t * t * t;
+      lineTo (cPointF ((a * p0.x) + (b * c1.x) + (d * c2.x) + (e * p1.x),
+                       (a * p0.y) + (b * c1.y) + (d * c2.y) + (e * p1.y)));
+      }
+    lineTo (p1);
+    }
+  //}}}
+
+private:
+  //{{{
+  struct sContour {
+    int first;
+    int num;
+    bool closed;
+    };
+  //}}}
+
+  static void polygon (cDrawAA& drawAA, const cPointF* points, const int numPoints);
+  static void fan (cDrawAA& drawAA, const cPointF& centre, const cPointF& from, const float angle,
+                   const int steps);
+
+  void strokeContour (cDrawAA& drawAA, const sContour& contour, const float halfWidth,
+                      const eJoin join, const eCap cap, const float miterLimit) const;
+  void strokeJoin (cDrawAA& drawAA, const cPointF& p, const cPointF& da, const cPointF& db,
+                   const float halfWidth, const eJoin join, const float miterLimit) const;
+  void strokeCap (cDrawAA& drawAA, const cPointF& p, const cPointF& d, const float halfWidth,
+                  const eCap cap) const;
+
+  float mTolerance;
+  std::vector<cPointF> mPoints;
+  std::vector<sContour> mContours;
+  };
+//}}}
@@ -0,0 +1,168 @@
+// cPixelFormat.h - native panel pixel formats, rgb565 colours converted once per primitive
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "cBlend.h"
+
+//{{{
+struct cRgb565 {
+  typedef uint16_t tPixel;
+  static constexpr int kBitsPerPixel = 16;
+
+  static constexpr tPixel fromRgb565 (const uint16_t colour) { return colour; }
+
+  static int getRowBytes (const int width) { return width * 2; }
+  //{{{
+  static void setPixel (uint8_t* row, const int x, const tPixel pixel) {
+    ((uint16_t*)row)[x] = pixel;
+    }
+  //}}}
+  //{{{
+  static tPixel getPixel (const uint8_t* row, const int x) {
+    return ((const uint16_t*)row)[x];
+    }
+  //}}}
+  //{{{
+  static tPixel blend (const tPixel back, const tPixel fore, const uint8_t alpha) {
+    return cBlend::blend (cBlend::expand (fore), back, alpha);
+    }
+  //}}}
+  //{{{
+  static void fillRow (uint8_t* row, int x1, const int x2, const tPixel pixel) {
+    for (uint16_t* dst = (uint16_t*)row + x1; x1 < x2; x1++)
+      *dst++ = pixel;
+    }
+  //}}}
+  };
+//}}}
+//{{{
+struct cRgb666 {
+// 3 bytes per pixel, 6 bits each at top of byte, as ili9486/9488 spi
+  typedef uint32_t tPixel;
+  static constexpr int kBitsPerPixel = 24;
+
+  //{{{
+  static constexpr tPixel fromRgb565 (const uint16_t colour) {
+    return (((colour >> 8) & 0xF8) << 16) | (((colour >> 3) & 0xFC) << 8) | ((colour << 3) & 0xF8);
+    }
+  //}}}
+
+  static int getRowBytes (const int width) { return width * 3; }
+  //{{{
+  static void setPixel (uint8_t* row, const int x, const tPixel pixel) {
+    row += x * 3;
+    row[0] = pixel >> 16;
+    row[1] = pixel >> 8;
+    row[2] = pixel;
+    }
+  //}}}
+  //{{{
+  static tPixel getPixel (const uint8_t* row, const int x) {
+    row += x * 3;
+    return (row[0] << 16) | (row[1] << 8) | row[2];
+    }
+  //}}}
+  //{{{
+  static tPixel blend (const tPixel back, const tPixel fore, const uint8_t alpha) {
+  // each channel in its own byte, 6 bits kept
+
+    tPixel pixel = 0;
+    for (int shift = 0; shift < 24; shift += 8) {
+      int b = (back >> shift) & 0xFC;
+      int f = (fore >> shift) & 0xFC;
+      pixel |= ((b + (((f - b) * alpha) / 255)) & 0xFC) << shift;
+      }
+    return pixel;
+    }
+  //}}}
+  //{{{
+  static void fillRow (uint8_t* row, int x1, const int x2, const tPixel pixel) {
+    for (; x1 < x2; x1++)
+      setPixel (row, x1, pixel);
+    }
+  //}}}
+  };
+//}}}
+//{{{
+struct cGray8 {
+  typedef uint8_t tPixel;
+  static constexpr int kBitsPerPixel = 8;
+
+  //{{{
+  static constexpr tPixel fromRgb565 (const uint16_t colour) {
+  // luma from 8 bit expanded channels
+    return ((((colour >> 8) & 0xF8) * 77) + (((colour >> 3) & 0xFC) * 150) + (((colour << 3) & 0xF8) * 29)) >> 8;
+    }
+  //}}}
+
+  static int getRowBytes (const int width) { return width; }
+  static void setPixel (uint8_t* row, const int x, const tPixel pixel) { row[x] = pixel; }
+  static tPixel getPixel (const uint8_t* row, const int x) { return row[x]; }
+  static tPixel blend (const tPixel back, const tPixel fore, const uint8_t alpha) { return back + (((fore - back) * alpha) / 255); }
+  //{{{
+  static void fillRow (uint8_t* row, const int x1, const int x2, const tPixel pixel) {
+    memset (row + x1, pixel, x2 - x1);
+    }
+  //}}}
+  };
+//}}}
+//{{{
+struct cIndex8 {
+// 8 bit palette index, colour argument of primitives is the index, expanded through palette at transmit
+// - no colours between indices, alpha and aa coverage thresholded at half
+  typedef uint8_t tPixel;
+  static constexpr int kBitsPerPixel = 8;
+
+  static constexpr tPixel fromRgb565 (const uint16_t colour) { return colour & 0xFF; }
+
+  static int getRowBytes (const int width) { return width; }
+  static void setPixel (uint8_t* row, const int x, const tPixel pixel) { row[x] = pixel; }
+  static tPixel getPixel (const uint8_t* row, const int x) { return row[x]; }
+  static tPixel blend (const tPixel back, const tPixel fore, const uint8_t alpha) { return alpha >= 0x80 ? fore : back; }
+  //{{{
+  static void fillRow (uint8_t* row, const int x1, const int x2, const tPixel pixel) {
+    memset (row + x1, pixel, x2 - x1);
+    }
+  //}}}
+  };
+//}}}
+//{{{
+struct cMono1 {
+// 1 bit per pixel, msb leftmost, 1 is white, as sharp memory lcd, alpha and aa coverage thresholded at half
+  typedef uint8_t tPixel;
+  static constexpr int kBitsPerPixel = 1;
+
+  static constexpr tPixel fromRgb565 (const uint16_t colour) { return cGray8::fromRgb565 (colour) >= 0x80; }
+
+  static int getRowBytes (const int width) { return (width + 7) / 8; }
+  //{{{
+  static void setPixel (uint8_t* row, const int x, const tPixel pixel) {
+    if (pixel)
+      row[x >> 3] |= 0x80 >> (x & 7);
+    else
+      row[x >> 3] &= ~(0x80 >> (x & 7));
+    }
+  //}}}
+  //{{{
+  static tPixel getPixel (const uint8_t* row, const int x) {
+    return (row[x >> 3] >> (7 - (x & 7))) & 1;
+    }
+  //}}}
+  static tPixel blend (const tPixel back, const tPixel fore, const uint8_t alpha) { return alpha >= 0x80 ? fore : back; }
+  //{{{
+  static void fillRow (uint8_t* row, int x1, const int x2, const tPixel pixel) {
+  // partial bytes at ends, whole bytes memset
+
+    for (; (x1 < x2) && (x1 & 7); x1++)
+      setPixel (row, x1, pixel);
+
+    int bytes = (x2 - x1) >> 3;
+    memset (row + (x1 >> 3), pixel ? 0xFF : 0x00, bytes);
+    x1 += bytes * 8;
+
+    for (; x1 < x2; x1++)
+      setPixel (row, x1, pixel);
+    }
+  //}}}
+  };
+//}}}
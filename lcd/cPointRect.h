@@ -171,7 +171,7 @@ public:
   //{{{
   cRect() {
     left = 0;
-    bottom = 0;
+    top = 0;
     right = 0;
     bottom = 0;
     }
@@ -193,9 +193,9 @@ public:
     }
   //}}}
 
-  int16_t getWidth() { return right - left; }
-  int16_t getHeight() { return bottom - top; }
-  int getNumPixels() { return getWidth() * getHeight(); }
+  int16_t getWidth() const { return right - left; }
+  int16_t getHeight() const { return bottom - top; }
+  int getNumPixels() const { return getWidth() * getHeight(); }
 
   cPoint getTL() { return cPoint(left, top); }
   cPoint getTL (const int16_t offset) { return cPoint(left+offset, top+offset); }
@@ -220,6 +220,40 @@ public:
     }
   //}}}
   //{{{
+  bool isEmpty() const {
+    return (right <= left) || (bottom <= top);
+    }
+  //}}}
+  //{{{
+  bool intersects (const cRect& r) const {
+  // return true if rects overlap
+    return (r.left < right) && (r.right > left) && (r.top < bottom) && (r.bottom > top);
+    }
+  //}}}
+  //{{{
+  cRect intersect (const cRect& r) const {
+  // return overlap of rects, may be empty
+    return cRect (left > r.left ? left : r.left, top > r.top ? top : r.top,
+                  right < r.right ? right : r.right, bottom < r.bottom ? bottom : r.bottom);
+    }
+  //}}}
+  //{{{
+  cRect combine (const cRect& r) const {
+  // return bounding rect of both rects, empty rects ignored
+    if (isEmpty())
+      return r;
+    if (r.isEmpty())
+      return *this;
+    return cRect (left < r.left ? left : r.left, top < r.top ? top : r.top,
+                  right > r.right ? right : r.right, bottom > r.bottom ? bottom : r.bottom);
+    }
+  //}}}
+  //{{{
+  bool operator == (const cRect& r) const {
+    return (left == r.left) && (top == r.top) && (right == r.right) && (bottom == r.bottom);
+    }
+  //}}}
+  //{{{
   //std::string cRect::getString() {
     //return "l:" + dec(left) + " r:" + dec(right) + " t:" + dec(top) + " b:" + dec(bottom);
     //}
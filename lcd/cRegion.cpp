@@ -0,0 +1,444 @@
+// cRegion.cpp - band ops after x11 miRegionOp
+#include "cRegion.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+// public
+//{{{
+int cRegion::getNumPixels() const {
+
+  int numPixels = 0;
+  for (auto& r : mRects)
+    numPixels += (r.right - r.left) * (r.bottom - r.top);
+  return numPixels;
+  }
+//}}}
+
+//{{{
+bool cRegion::contains (const cPoint& p) const {
+
+  if ((p.x < mBounds.left) || (p.x >= mBounds.right) || (p.y < mBounds.top) || (p.y >= mBounds.bottom))
+    return false;
+
+  for (auto& r : mRects) {
+    if (r.top > p.y)
+      break;
+    if ((p.y < r.bottom) && (p.x >= r.left) && (p.x < r.right))
+      return true;
+    }
+
+  return false;
+  }
+//}}}
+//{{{
+bool cRegion::intersects (const cRect& r) const {
+
+  if (!mBounds.intersects (r))
+    return false;
+
+  for (auto& rect : mRects) {
+    if (rect.top >= r.bottom)
+      break;
+    if (rect.intersects (r))
+      return true;
+    }
+
+  return false;
+  }
+//}}}
+
+//{{{
+void cRegion::clear() {
+
+  mRects.clear();
+  mBounds = cRect();
+  }
+//}}}
+//{{{
+void cRegion::set (const cRect& r) {
+
+  mRects.clear();
+  if (r.isEmpty())
+    mBounds = cRect();
+  else {
+    mRects.push_back (r);
+    mBounds = r;
+    }
+  }
+//}}}
+
+//{{{
+void cRegion::unite (const cRect& r) {
+
+  if (r.isEmpty())
+    return;
+
+  if (isEmpty() || (r.intersect (mBounds) == mBounds))
+    // r covers region
+    set (r);
+
+  else if ((mRects.size() == 1) && (mBounds.intersect (r) == r))
+    // region rect covers r
+    return;
+
+  else
+    op (mRects.data(), (int)mRects.size(), &r, 1, eUnion);
+  }
+//}}}
+//{{{
+void cRegion::unite (const cRegion& region) {
+
+  if ((&region == this) || region.isEmpty())
+    return;
+
+  if (isEmpty()) {
+    mRects = region.mRects;
+    mBounds = region.mBounds;
+    }
+
+  else if (region.mRects.size() == 1)
+    unite (region.mBounds);
+
+  else
+    op (mRects.data(), (int)mRects.size(), region.mRects.data(), (int)region.mRects.size(), eUnion);
+  }
+//}}}
+//{{{
+void cRegion::intersect (const cRect& r) {
+
+  if (isEmpty())
+    return;
+
+  if (r.isEmpty() || !mBounds.intersects (r))
+    clear();
+
+  else if (mRects.size() == 1)
+    set (mBounds.intersect (r));
+
+  else if (mBounds.intersect (r) == mBounds)
+    // r covers region
+    return;
+
+  else
+    op (mRects.data(), (int)mRects.size(), &r, 1, eIntersect);
+  }
+//}}}
+//{{{
+void cRegion::intersect (const cRegion& region) {
+
+  if (&region == this)
+    return;
+
+  if (isEmpty() || region.isEmpty() || !mBounds.intersects (region.mBounds))
+    clear();
+
+  else if (region.mRects.size() == 1)
+    intersect (region.mBounds);
+
+  else
+    op (mRects.data(), (int)mRects.size(), region.mRects.data(), (int)region.mRects.size(), eIntersect);
+  }
+//}}}
+//{{{
+void cRegion::subtract (const cRect& r) {
+
+  if (isEmpty() || r.isEmpty() || !mBounds.intersects (r))
+    return;
+
+  op (mRects.data(), (int)mRects.size(), &r, 1, eSubtract);
+  }
+//}}}
+//{{{
+void cRegion::subtract (const cRegion& region) {
+
+  if (&region == this)
+    clear();
+
+  else if (isEmpty() || region.isEmpty() || !mBounds.intersects (region.mBounds))
+    return;
+
+  else
+    op (mRects.data(), (int)mRects.size(), region.mRects.data(), (int)region.mRects.size(), eSubtract);
+  }
+//}}}
+
+//{{{
+sSpan* cRegion::toSpans (sSpan* spans, const int maxSpans) const {
+// link rects as spans in caller array of maxSpans
+
+  if (isEmpty() || (maxSpans < 1))
+    return nullptr;
+
+  if ((int)mRects.size() > maxSpans) {
+    // too many, single bounds span
+    *spans = { mBounds, uint16_t(mBounds.right),
+               uint32_t((mBounds.right - mBounds.left) * (mBounds.bottom - mBounds.top)), nullptr };
+    return spans;
+    }
+
+  sSpan* span = spans;
+  for (auto& r : mRects) {
+    *span = { r, uint16_t(r.right), uint32_t((r.right - r.left) * (r.bottom - r.top)), span + 1 };
+    span++;
+    }
+  span[-1].next = nullptr;
+
+  return spans;
+  }
+//}}}
+//{{{
+void cRegion::fromSpans (const sSpan* spans) {
+
+  clear();
+  for (const sSpan* span = spans; span; span = span->next)
+    unite (span->r);
+  }
+//}}}
+
+// private
+//{{{
+void cRegion::op (const cRect* r1, const int numRects1, const cRect* r2, const int numRects2, const eOp op) {
+// walk both regions band by band
+// - parts of a band in only one region are appended if op keeps them, union keeps both, subtract keeps r1
+// - overlapping parts of bands are combined by op band function
+// - result in mOpRects, swapped into mRects
+
+  mOpRects.clear();
+
+  const bool appendNon1 = op != eIntersect;
+  const bool appendNon2 = op == eUnion;
+
+  const cRect* r1End = r1 + numRects1;
+  const cRect* r2End = r2 + numRects2;
+
+  int16_t ybot = ((numRects1 > 0) && (numRects2 > 0)) ? min (r1->top, r2->top) : INT16_MIN;
+  int prevBand = -1;
+
+  while ((r1 != r1End) && (r2 != r2End)) {
+    const cRect* r1BandEnd = findBandEnd (r1, r1End);
+    const cRect* r2BandEnd = findBandEnd (r2, r2End);
+
+    // non overlapping part above other band
+    int16_t ytop;
+    if (r1->top < r2->top) {
+      if (appendNon1) {
+        int16_t top = max (r1->top, ybot);
+        int16_t bottom = min (r1->bottom, r2->top);
+        if (top < bottom) {
+          int curBand = (int)mOpRects.size();
+          appendBand (r1, r1BandEnd, top, bottom);
+          prevBand = coalesce (prevBand, curBand);
+          }
+        }
+      ytop = r2->top;
+      }
+    else if (r2->top < r1->top) {
+      if (appendNon2) {
+        int16_t top = max (r2->top, ybot);
+        int16_t bottom = min (r2->bottom, r1->top);
+        if (top < bottom) {
+          int curBand = (int)mOpRects.size();
+          appendBand (r2, r2BandEnd, top, bottom);
+          prevBand = coalesce (prevBand, curBand);
+          }
+        }
+      ytop = r1->top;
+      }
+    else
+      ytop = r1->top;
+
+    // overlapping part of bands
+    ybot = min (r1->bottom, r2->bottom);
+    if (ybot > ytop) {
+      int curBand = (int)mOpRects.size();
+      switch (op) {
+        case eUnion:     unionBand (r1, r1BandEnd, r2, r2BandEnd, ytop, ybot); break;
+        case eIntersect: intersectBand (r1, r1BandEnd, r2, r2BandEnd, ytop, ybot); break;
+        case eSubtract:  subtractBand (r1, r1BandEnd, r2, r2BandEnd, ytop, ybot); break;
+        }
+      prevBand = coalesce (prevBand, curBand);
+      }
+
+    // next band if finished
+    if (r1->bottom == ybot)
+      r1 = r1BandEnd;
+    if (r2->bottom == ybot)
+      r2 = r2BandEnd;
+    }
+
+  // remaining bands of one region, first may be partly done
+  if ((r1 != r1End) && appendNon1) {
+    const cRect* r1BandEnd = findBandEnd (r1, r1End);
+    int curBand = (int)mOpRects.size();
+    appendBand (r1, r1BandEnd, max (r1->top, ybot), r1->bottom);
+    coalesce (prevBand, curBand);
+    mOpRects.insert (mOpRects.end(), r1BandEnd, r1End);
+    }
+  else if ((r2 != r2End) && appendNon2) {
+    const cRect* r2BandEnd = findBandEnd (r2, r2End);
+    int curBand = (int)mOpRects.size();
+    appendBand (r2, r2BandEnd, max (r2->top, ybot), r2->bottom);
+    coalesce (prevBand, curBand);
+    mOpRects.insert (mOpRects.end(), r2BandEnd, r2End);
+    }
+
+  mRects.swap (mOpRects);
+  calcBounds();
+  }
+//}}}
+
+//{{{
+void cRegion::appendBand (const cRect* r, const cRect* rEnd, const int16_t top, const int16_t bottom) {
+
+  for (; r != rEnd; r++)
+    mOpRects.push_back (cRect (r->left, top, r->right, bottom));
+  }
+//}}}
+//{{{
+void cRegion::unionBand (const cRect* r1, const cRect* r1End, const cRect* r2, const cRect* r2End,
+                         const int16_t top, const int16_t bottom) {
+// merge by left, extending last rect while next overlaps or touches it
+
+  size_t band = mOpRects.size();
+
+  while ((r1 != r1End) || (r2 != r2End)) {
+    const cRect* r;
+    if ((r2 == r2End) || ((r1 != r1End) && (r1->left < r2->left)))
+      r = r1++;
+    else
+      r = r2++;
+
+    if ((mOpRects.size() > band) && (mOpRects.back().right >= r->left)) {
+      if (mOpRects.back().right < r->right)
+        mOpRects.back().right = r->right;
+      }
+    else
+      mOpRects.push_back (cRect (r->left, top, r->right, bottom));
+    }
+  }
+//}}}
+//{{{
+void cRegion::intersectBand (const cRect* r1, const cRect* r1End, const cRect* r2, const cRect* r2End,
+                             const int16_t top, const int16_t bottom) {
+
+  while ((r1 != r1End) && (r2 != r2End)) {
+    int16_t left = max (r1->left, r2->left);
+    int16_t right = min (r1->right, r2->right);
+    if (left < right)
+      mOpRects.push_back (cRect (left, top, right, bottom));
+
+    // advance whichever ends first
+    if (r1->right == right)
+      r1++;
+    if (r2->right == right)
+      r2++;
+    }
+  }
+//}}}
+//{{{
+void cRegion::subtractBand (const cRect* r1, const cRect* r1End, const cRect* r2, const cRect* r2End,
+                            const int16_t top, const int16_t bottom) {
+// x1 is left of what remains of minuend r1
+
+  int16_t x1 = r1->left;
+
+  while ((r1 != r1End) && (r2 != r2End)) {
+    if (r2->right <= x1)
+      // subtrahend left of minuend
+      r2++;
+
+    else if (r2->left <= x1) {
+      // subtrahend covers left of minuend
+      x1 = r2->right;
+      if (x1 >= r1->right) {
+        if (++r1 != r1End)
+          x1 = r1->left;
+        }
+      else
+        r2++;
+      }
+
+    else if (r2->left < r1->right) {
+      // subtrahend splits minuend
+      mOpRects.push_back (cRect (x1, top, r2->left, bottom));
+      x1 = r2->right;
+      if (x1 >= r1->right) {
+        if (++r1 != r1End)
+          x1 = r1->left;
+        }
+      else
+        r2++;
+      }
+
+    else {
+      // subtrahend right of minuend
+      if (r1->right > x1)
+        mOpRects.push_back (cRect (x1, top, r1->right, bottom));
+      if (++r1 != r1End)
+        x1 = r1->left;
+      }
+    }
+
+  // remaining minuends
+  while (r1 != r1End) {
+    mOpRects.push_back (cRect (x1, top, r1->right, bottom));
+    if (++r1 != r1End)
+      x1 = r1->left;
+    }
+  }
+//}}}
+//{{{
+int cRegion::coalesce (int prevBand, int curBand) {
+// merge curBand into prevBand if they touch and have same rects, return start of last band
+
+  int numRects = (int)mOpRects.size() - curBand;
+  if (numRects == 0)
+    return prevBand;
+
+  if ((prevBand < 0) || (curBand - prevBand != numRects) ||
+      (mOpRects[prevBand].bottom != mOpRects[curBand].top))
+    return curBand;
+
+  for (int i = 0; i < numRects; i++)
+    if ((mOpRects[prevBand + i].left != mOpRects[curBand + i].left) ||
+        (mOpRects[prevBand + i].right != mOpRects[curBand + i].right))
+      return curBand;
+
+  int16_t bottom = mOpRects[curBand].bottom;
+  for (int i = 0; i < numRects; i++)
+    mOpRects[prevBand + i].bottom = bottom;
+  mOpRects.resize (curBand);
+
+  return prevBand;
+  }
+//}}}
+//{{{
+void cRegion::calcBounds() {
+
+  if (mRects.empty()) {
+    mBounds = cRect();
+    return;
+    }
+
+  mBounds = cRect (mRects.front().left, mRects.front().top, mRects.front().right, mRects.back().bottom);
+  for (auto& r : mRects) {
+    if (r.left < mBounds.left)
+      mBounds.left = r.left;
+    if (r.right > mBounds.right)
+      mBounds.right = r.right;
+    }
+  }
+//}}}
+
+//{{{
+const cRect* cRegion::findBandEnd (const cRect* r, const cRect* rEnd) {
+
+  int16_t top = r->top;
+  while ((r != rEnd) && (r->top == top))
+    r++;
+  return r;
+  }
+//}}}
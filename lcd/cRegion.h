@@ -0,0 +1,63 @@
+// cRegion.h - set of rects, y banded, x11/pixman style
+#pragma once
+#include <vector>
+#include "cPointRect.h"
+
+//{{{
+class cRegion {
+// rects in bands of equal top and bottom, bands sorted by top, rects in band sorted by left
+// - rects never overlap or touch in a band, vertically adjacent bands with same rects are coalesced
+// - vectors keep their capacity, steady state ops don't allocate
+public:
+  cRegion() {}
+  cRegion (const cRect& r) { set (r); }
+
+  bool isEmpty() const { return mRects.empty(); }
+  cRect getBounds() const { return mBounds; }
+  int getNumRects() const { return (int)mRects.size(); }
+  int getNumPixels() const;
+
+  const cRect* begin() const { return mRects.data(); }
+  const cRect* end() const { return mRects.data() + mRects.size(); }
+
+  bool contains (const cPoint& p) const;
+  bool intersects (const cRect& r) const;
+
+  void clear();
+  void set (const cRect& r);
+
+  void unite (const cRect& r);
+  void unite (const cRegion& region);
+  void intersect (const cRect& r);
+  void intersect (const cRegion& region);
+  void subtract (const cRect& r);
+  void subtract (const cRegion& region);
+
+  // spans, collapse to bounds if more than maxSpans rects, return first span or nullptr
+  sSpan* toSpans (sSpan* spans, const int maxSpans) const;
+  void fromSpans (const sSpan* spans);
+
+private:
+  enum eOp { eUnion, eIntersect, eSubtract };
+
+  void op (const cRect* rects1, const int numRects1, const cRect* rects2, const int numRects2, const eOp op);
+
+  void appendBand (const cRect* r, const cRect* rEnd, const int16_t top, const int16_t bottom);
+  void unionBand (const cRect* r1, const cRect* r1End, const cRect* r2, const cRect* r2End,
+                  const int16_t top, const int16_t bottom);
+  void intersectBand (const cRect* r1, const cRect* r1End, const cRect* r2, const cRect* r2End,
+                      const int16_t top, const int16_t bottom);
+  void subtractBand (const cRect* r1, const cRect* r1End, const cRect* r2, const cRect* r2End,
+                     const int16_t top, const int16_t bottom);
+  int coalesce (int prevBand, int curBand);
+  void calcBounds();
+
+  static const cRect* findBandEnd (const cRect* r, const cRect* rEnd);
+
+  std::vector<cRect> mRects;
+  cRect mBounds;
+
+  // op output, swapped with mRects
+  std::vector<cRect> mOpRects;
+  };
+//}}}
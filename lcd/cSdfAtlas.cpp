@@ -0,0 +1,159 @@
+// cSdfAtlas.cpp
+#include "cSdfAtlas.h"
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include "cFont.h"
+#include "cBlend.h"
+
+using namespace std;
+
+//{{{
+cSdfAtlas::cSdfAtlas (cFont& font, const float emPixels, const int padding, const uint32_t first, const uint32_t last)
+    : mEmPixels(emPixels), mPadding(padding), mFirst(first), mLast(last) {
+// glyph fields rendered, shelf packed in codepoint order, then copied into one atlas
+
+  for (unsigned i = 0; i < 256; i++)
+    mGamma[i] = (uint8_t)(pow(double(i) / 255.0, 1.6) * 255.0);
+
+  uint32_t numGlyphs = last - first + 1;
+  mGlyphs = (sGlyph*)calloc (numGlyphs, sizeof(sGlyph));
+  uint8_t** sdfs = (uint8_t**)calloc (numGlyphs, sizeof(uint8_t*));
+
+  // onEdge falls to 0 at padding outside
+  float distScale = float(kOnEdge) / padding;
+
+  int x = 0;
+  int y = 0;
+  int shelfHeight = 0;
+  for (uint32_t i = 0; i < numGlyphs; i++) {
+    int width;
+    int height;
+    int left;
+    int top;
+    sdfs[i] = font.getSdf (first + i, emPixels, padding, kOnEdge, distScale, width, height, left, top);
+
+    sGlyph& glyph = mGlyphs[i];
+    glyph.advance = font.getGlyph (first + i)->advance;
+    if (!sdfs[i])
+      continue;
+
+    if (x + width > kAtlasWidth) {
+      // next shelf
+      x = 0;
+      y += shelfHeight;
+      shelfHeight = 0;
+      }
+
+    glyph.x = x;
+    glyph.y = y;
+    glyph.width = width;
+    glyph.height = height;
+    glyph.left = left;
+    glyph.top = top;
+
+    x += width;
+    if (height > shelfHeight)
+      shelfHeight = height;
+    }
+  mHeight = y + shelfHeight;
+
+  mAtlas = (uint8_t*)calloc (mWidth * mHeight, 1);
+  for (uint32_t i = 0; i < numGlyphs; i++)
+    if (sdfs[i]) {
+      sGlyph& glyph = mGlyphs[i];
+      for (int row = 0; row < glyph.height; row++)
+        memcpy (mAtlas + ((glyph.y + row) * mWidth) + glyph.x, sdfs[i] + (row * glyph.width), glyph.width);
+      free (sdfs[i]);
+      }
+
+  free (sdfs);
+  }
+//}}}
+//{{{
+cSdfAtlas::~cSdfAtlas() {
+
+  free (mAtlas);
+  free (mGlyphs);
+  free (mRow);
+  }
+//}}}
+
+//{{{
+cRect cSdfAtlas::getGlyphRect (const sGlyph* glyph, const cPointF& pen, const float height) const {
+// destination pixels glyph field covers, pen on baseline
+
+  if (!glyph->width)
+    return cRect();
+
+  float scale = height / mEmPixels;
+  return cRect ((int)floorf (pen.x + (glyph->left * scale)), (int)floorf (pen.y + (glyph->top * scale)),
+                (int)ceilf (pen.x + ((glyph->left + glyph->width) * scale)),
+                (int)ceilf (pen.y + ((glyph->top + glyph->height) * scale)));
+  }
+//}}}
+//{{{
+cRect cSdfAtlas::render (uint16_t* frameBuf, const uint16_t width, const cRect& clip, const uint16_t colour,
+                         const sGlyph* glyph, const cPointF& pen, const float height) {
+// glyph sampled at height, pixel centres stepped through atlas in 16.16, rows blended through coverage
+
+  cRect clipped = getGlyphRect (glyph, pen, height).intersect (clip);
+  if (clipped.isEmpty())
+    return cRect();
+
+  if (clipped.getWidth() > mRowSize) {
+    mRowSize = clipped.getWidth();
+    free (mRow);
+    mRow = (uint8_t*)malloc (mRowSize);
+    }
+
+  // atlas texel of destination pixel centre, texel centres at +0.5
+  float scale = height / mEmPixels;
+  float invScale = mEmPixels / height;
+  int32_t step = (int32_t)(invScale * 65536.f);
+  int32_t u = (int32_t)(((((clipped.left + 0.5f) - pen.x) * invScale) - glyph->left - 0.5f) * 65536.f);
+  int32_t v = (int32_t)(((((clipped.top + 0.5f) - pen.y) * invScale) - glyph->top - 0.5f) * 65536.f);
+
+  // distance to destination pixels, 8.8 coverage per atlas unit
+  int32_t coverageScale = (int32_t)((scale * 255.f * mPadding / kOnEdge) * 256.f);
+
+  for (int y = clipped.top; y < clipped.bottom; y++, v += step) {
+    sampleRow (glyph, u, v, step, coverageScale, clipped.getWidth(), mRow);
+    cBlend::maskRow (frameBuf + (y * width) + clipped.left, colour, mRow, clipped.getWidth());
+    }
+
+  return clipped;
+  }
+//}}}
+
+// private
+//{{{
+void cSdfAtlas::sampleRow (const sGlyph* glyph, const int32_t u, const int32_t v, const int32_t step,
+                           const int32_t scale, const int num, uint8_t* coverage) const {
+// bilinear distance along row, texels clamped to glyph field whose border is beyond the outline
+
+  int32_t ty = v >> 16;
+  int32_t fy = (v >> 8) & 0xFF;
+  int32_t ty0 = ty < 0 ? 0 : ty >= glyph->height ? glyph->height - 1 : ty;
+  int32_t ty1 = ty + 1 < 0 ? 0 : ty + 1 >= glyph->height ? glyph->height - 1 : ty + 1;
+  const uint8_t* row0 = mAtlas + ((glyph->y + ty0) * mWidth) + glyph->x;
+  const uint8_t* row1 = mAtlas + ((glyph->y + ty1) * mWidth) + glyph->x;
+
+  int32_t tu = u;
+  for (int i = 0; i < num; i++, tu += step) {
+    int32_t tx = tu >> 16;
+    int32_t fx = (tu >> 8) & 0xFF;
+    int32_t tx0 = tx < 0 ? 0 : tx >= glyph->width ? glyph->width - 1 : tx;
+    int32_t tx1 = tx + 1 < 0 ? 0 : tx + 1 >= glyph->width ? glyph->width - 1 : tx + 1;
+
+    // 8.8 distance value
+    int32_t top = (row0[tx0] << 8) + ((row0[tx1] - row0[tx0]) * fx);
+    int32_t bottom = (row1[tx0] << 8) + ((row1[tx1] - row1[tx0]) * fx);
+    int32_t value = top + (((bottom - top) * fy) >> 8);
+
+    // half coverage on edge, one destination pixel to full
+    int32_t alpha = ((127 << 16) + 0x8000 + ((value - (kOnEdge << 8)) * scale)) >> 16;
+    coverage[i] = mGamma[alpha < 0 ? 0 : alpha > 255 ? 255 : alpha];
+    }
+  }
+//}}}
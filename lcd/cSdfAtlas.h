@@ -0,0 +1,67 @@
+// cSdfAtlas.h - signed distance field glyph atlas, built once from cFont, sampled at any pixel height
+#pragma once
+#include <cstdint>
+#include "cPointRect.h"
+
+class cFont;
+
+//{{{
+class cSdfAtlas {
+// - one 8 bit atlas of glyphs first..last, shelf packed, distance kOnEdge on outline, rising inside
+// - sampled bilinear, distance rescaled to destination pixels, so edge stays a pixel wide at any height
+// - one atlas replaces a glyph cache per size, a new size costs nothing
+public:
+  //{{{
+  struct sGlyph {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    int16_t left;
+    int16_t top;
+    float advance;
+    };
+  //}}}
+
+  cSdfAtlas (cFont& font, const float emPixels = 32.f, const int padding = 4,
+             const uint32_t first = 32, const uint32_t last = 126);
+  ~cSdfAtlas();
+
+  float getEmPixels() const { return mEmPixels; }
+  uint16_t getWidth() const { return mWidth; }
+  uint16_t getHeight() const { return mHeight; }
+  uint32_t getBytes() const { return mWidth * mHeight; }
+  const uint8_t* getAtlas() const { return mAtlas; }
+
+  //{{{
+  const sGlyph* getGlyph (const uint32_t codepoint) const {
+    return (codepoint >= mFirst) && (codepoint <= mLast) ? &mGlyphs[codepoint - mFirst] : nullptr;
+    }
+  //}}}
+
+  cRect getGlyphRect (const sGlyph* glyph, const cPointF& pen, const float height) const;
+  cRect render (uint16_t* frameBuf, const uint16_t width, const cRect& clip, const uint16_t colour,
+                const sGlyph* glyph, const cPointF& pen, const float height);
+
+private:
+  static constexpr uint8_t kOnEdge = 128;
+  static constexpr uint16_t kAtlasWidth = 256;
+
+  void sampleRow (const sGlyph* glyph, const int32_t u, const int32_t v, const int32_t step,
+                  const int32_t scale, const int num, uint8_t* coverage) const;
+
+  const float mEmPixels;
+  const int mPadding;
+  const uint32_t mFirst;
+  const uint32_t mLast;
+
+  uint16_t mWidth = kAtlasWidth;
+  uint16_t mHeight = 0;
+  uint8_t* mAtlas = nullptr;
+  sGlyph* mGlyphs = nullptr;
+
+  uint8_t* mRow = nullptr;
+  int mRowSize = 0;
+  uint8_t mGamma[256];
+  };
+//}}}
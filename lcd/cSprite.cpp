@@ -0,0 +1,205 @@
+// cSprite.cpp
+#include "cSprite.h"
+#include "cBlend.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+// public
+//{{{
+cSprite::cSprite (const uint16_t width, const uint16_t height, const uint16_t* pixels)
+    : mFormat(eOpaque), mWidth(width), mHeight(height) {
+
+  mPixels = (uint16_t*)malloc (width * height * 2);
+  memcpy (mPixels, pixels, width * height * 2);
+  }
+//}}}
+//{{{
+cSprite::cSprite (const uint16_t width, const uint16_t height, const uint16_t* pixels, const uint8_t* alpha)
+    : cSprite (width, height, pixels) {
+
+  mFormat = eAlpha;
+  mAlpha = (uint8_t*)malloc (width * height);
+  memcpy (mAlpha, alpha, width * height);
+  }
+//}}}
+//{{{
+cSprite::cSprite (const uint16_t width, const uint16_t height, const uint16_t* pixels, const uint16_t colourKey)
+    : cSprite (width, height, pixels) {
+
+  mFormat = eColourKey;
+  mColourKey = colourKey;
+  }
+//}}}
+//{{{
+cSprite::~cSprite() {
+
+  free (mPixels);
+  free (mAlpha);
+  free (mRle);
+  free (mRleRows);
+  }
+//}}}
+
+//{{{
+void cSprite::compressRle() {
+// encode rows as ops, skip transparent runs, copy opaque runs, alpha blend the rest
+// - op word, copy followed by pixels, alpha followed by pixels and alpha bytes padded to word
+
+  if (mFormat == eRle)
+    return;
+
+  // worst case every pixel its own alpha op
+  mRle = (uint16_t*)malloc (mWidth * mHeight * 3 * 2 + mHeight * 2);
+  mRleRows = (uint32_t*)malloc (mHeight * 4);
+
+  uint16_t* rle = mRle;
+  for (int y = 0; y < mHeight; y++) {
+    mRleRows[y] = uint32_t(rle - mRle);
+
+    int x = 0;
+    while (x < mWidth) {
+      // classify run by first pixel, extend while same kind
+      uint8_t alpha = getRowAlpha (x, y);
+      uint16_t kind = (alpha == 0) ? kRleSkip : (alpha == 0xFF) ? kRleCopy : kRleAlpha;
+
+      int length = 1;
+      while ((x + length < mWidth) && (length < kRleMaxLength)) {
+        uint8_t nextAlpha = getRowAlpha (x + length, y);
+        uint16_t nextKind = (nextAlpha == 0) ? kRleSkip : (nextAlpha == 0xFF) ? kRleCopy : kRleAlpha;
+        if (nextKind != kind)
+          break;
+        length++;
+        }
+
+      *rle++ = kind | length;
+
+      const uint16_t* src = mPixels + (y * mWidth) + x;
+      if (kind == kRleCopy) {
+        memcpy (rle, src, length * 2);
+        rle += length;
+        }
+      else if (kind == kRleAlpha) {
+        memcpy (rle, src, length * 2);
+        rle += length;
+        memcpy (rle, mAlpha + (y * mWidth) + x, length);
+        rle += (length + 1) / 2;
+        }
+
+      x += length;
+      }
+    }
+
+  mRle = (uint16_t*)realloc (mRle, (rle - mRle) * 2);
+
+  free (mPixels);
+  mPixels = nullptr;
+  free (mAlpha);
+  mAlpha = nullptr;
+
+  mFormat = eRle;
+  }
+//}}}
+
+//{{{
+void cSprite::blit (uint16_t* frameBuf, const uint16_t stride, const cRect& clip, const cPoint& p) const {
+// blit to frameBuf at p, clip once to visible rect, then whole rows through row blenders
+
+  int16_t left = max (p.x, clip.left);
+  int16_t right = min (int16_t(p.x + mWidth), clip.right);
+  int16_t top = max (p.y, clip.top);
+  int16_t bottom = min (int16_t(p.y + mHeight), clip.bottom);
+  if ((left >= right) || (top >= bottom))
+    return;
+
+  int numPix = right - left;
+  int srcOffset = ((top - p.y) * mWidth) + (left - p.x);
+  uint16_t* dst = frameBuf + (top * stride) + left;
+
+  switch (mFormat) {
+    //{{{
+    case eOpaque: {
+      const uint16_t* src = mPixels + srcOffset;
+      for (int16_t y = top; y < bottom; y++, dst += stride, src += mWidth)
+        memcpy (dst, src, numPix * 2);
+      break;
+      }
+    //}}}
+    //{{{
+    case eAlpha: {
+      const uint16_t* src = mPixels + srcOffset;
+      const uint8_t* alpha = mAlpha + srcOffset;
+      for (int16_t y = top; y < bottom; y++, dst += stride, src += mWidth, alpha += mWidth)
+        cBlend::alphaRow (dst, src, alpha, numPix);
+      break;
+      }
+    //}}}
+    //{{{
+    case eColourKey: {
+      const uint16_t* src = mPixels + srcOffset;
+      for (int16_t y = top; y < bottom; y++, dst += stride, src += mWidth)
+        cBlend::keyRow (dst, src, mColourKey, numPix);
+      break;
+      }
+    //}}}
+    //{{{
+    case eRle:
+      for (int16_t y = top; y < bottom; y++)
+        blitRle (frameBuf + (y * stride), left, right, y - p.y, p.x);
+      break;
+    //}}}
+    }
+  }
+//}}}
+
+// private
+//{{{
+uint8_t cSprite::getRowAlpha (const int x, const int y) const {
+
+  switch (mFormat) {
+    case eAlpha:
+      return mAlpha[(y * mWidth) + x];
+    case eColourKey:
+      return mPixels[(y * mWidth) + x] == mColourKey ? 0 : 0xFF;
+    default:
+      return 0xFF;
+    }
+  }
+//}}}
+//{{{
+void cSprite::blitRle (uint16_t* dstRow, int16_t left, int16_t right, int16_t row, int16_t x) const {
+// walk row ops, stop past clip right, clip partial ops at both ends
+
+  const uint16_t* rle = mRle + mRleRows[row];
+  int16_t rowEnd = x + mWidth;
+  while (x < rowEnd) {
+    if (x >= right)
+      return;
+
+    uint16_t op = *rle++;
+    uint16_t kind = op & kRleKindMask;
+    int16_t length = op & kRleMaxLength;
+
+    int16_t visLeft = max (x, left);
+    int16_t visRight = min (int16_t(x + length), right);
+    int16_t numPix = visRight - visLeft;
+    int16_t skip = visLeft - x;
+
+    if (kind == kRleCopy) {
+      if (numPix > 0)
+        memcpy (dstRow + visLeft, rle + skip, numPix * 2);
+      rle += length;
+      }
+    else if (kind == kRleAlpha) {
+      if (numPix > 0)
+        cBlend::alphaRow (dstRow + visLeft, rle + skip, (const uint8_t*)(rle + length) + skip, numPix);
+      rle += length + ((length + 1) / 2);
+      }
+
+    x += length;
+    }
+  }
+//}}}
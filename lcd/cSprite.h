@@ -0,0 +1,50 @@
+// cSprite.h - rgb565 sprite, opaque, a8 alpha mask, colourKey or rle transparent runs
+#pragma once
+#include "cPointRect.h"
+
+class cSprite {
+public:
+  enum eFormat { eOpaque, eAlpha, eColourKey, eRle };
+
+  cSprite (const uint16_t width, const uint16_t height, const uint16_t* pixels);
+  cSprite (const uint16_t width, const uint16_t height, const uint16_t* pixels, const uint8_t* alpha);
+  cSprite (const uint16_t width, const uint16_t height, const uint16_t* pixels, const uint16_t colourKey);
+  ~cSprite();
+
+  // owns its pixel, alpha and rle buffers
+  cSprite (const cSprite&) = delete;
+  cSprite& operator= (const cSprite&) = delete;
+
+  eFormat getFormat() const { return mFormat; }
+  uint16_t getWidth() const { return mWidth; }
+  uint16_t getHeight() const { return mHeight; }
+  cPoint getSize() const { return cPoint (mWidth, mHeight); }
+
+  void compressRle();
+
+  void blit (uint16_t* frameBuf, const uint16_t stride, const cRect& clip, const cPoint& p) const;
+
+private:
+  //{{{  rle op, kind in top 2 bits, length in bottom 14 bits
+  static constexpr uint16_t kRleSkip = 0x0000;
+  static constexpr uint16_t kRleCopy = 0x4000;
+  static constexpr uint16_t kRleAlpha = 0x8000;
+  static constexpr uint16_t kRleKindMask = 0xC000;
+  static constexpr uint16_t kRleMaxLength = 0x3FFF;
+  //}}}
+
+  uint8_t getRowAlpha (const int x, const int y) const;
+  void blitRle (uint16_t* dstRow, int16_t left, int16_t right, int16_t row, int16_t x) const;
+
+  eFormat mFormat = eOpaque;
+  const uint16_t mWidth;
+  const uint16_t mHeight;
+
+  uint16_t* mPixels = nullptr;
+  uint8_t* mAlpha = nullptr;
+  uint16_t mColourKey = 0;
+
+  // rle ops + data, row start offsets
+  uint16_t* mRle = nullptr;
+  uint32_t* mRleRows = nullptr;
+  };
@@ -3640,6 +3640,66 @@ int spiClose (uint32_t handle) {
   }
 //}}}
 
+//{{{
+volatile uint32_t* spiMainRegs() {
+// main spi register file, for callers driving it by dma
+  return spiReg;
+  }
+//}}}
+//{{{
+volatile uint32_t* dmaChannelRegs (uint32_t channel) {
+// dma channel 0..14 register file, 0x100 bytes each
+  return dmaReg + (channel * 0x40);
+  }
+//}}}
+//{{{
+uint32_t dmaMemAlloc (uint32_t size, void** virt, uint32_t* bus) {
+// uncached mailbox memory, page aligned, returns handle, 0 on failure
+// - /dev/mem and mailbox reopened, both are closed once initialise has its own blocks
+
+  fdMem = open ("/dev/mem", O_RDWR | O_SYNC);
+  fdMbox = mbOpen();
+
+  DMAMem_t mem = { 0, 0, nullptr, 0 };
+  if ((fdMem >= 0) && (fdMbox >= 0) && mbDMAAlloc (&mem, size, pi_mem_flag)) {
+    if (mem.virtual_addr == MAP_FAILED) {
+      mem.virtual_addr = nullptr;
+      mbUnlockMemory (fdMbox, mem.handle);
+      mbReleaseMemory (fdMbox, mem.handle);
+      mem.handle = 0;
+      }
+    }
+
+  if (fdMbox >= 0)
+    mbClose (fdMbox);
+  fdMbox = -1;
+  if (fdMem >= 0)
+    close (fdMem);
+  fdMem = -1;
+
+  if (!mem.handle) {
+    cLog::log (LOGERROR, "dmaMemAlloc failed");
+    return 0;
+    }
+
+  *virt = mem.virtual_addr;
+  *bus = (uint32_t)mem.bus_addr;
+  return mem.handle;
+  }
+//}}}
+//{{{
+void dmaMemFree (uint32_t handle, void* virt, uint32_t size) {
+
+  fdMbox = mbOpen();
+
+  DMAMem_t mem = { handle, 0, (uintptr_t*)virt, size };
+  mbDMAFree (&mem);
+
+  mbClose (fdMbox);
+  fdMbox = -1;
+  }
+//}}}
+
 // bitbang helpers
 //{{{
 static void wfRx_lock (int i) {
@@ -323,6 +323,12 @@ int spiXfer (uint32_t handle, char* txBuf, char* rxBuf, uint32_t count);
 
 int spiClose (uint32_t handle);
 
+// main spi and dma registers, uncached dma memory, for callers running their own dma chains
+volatile uint32_t* spiMainRegs();
+volatile uint32_t* dmaChannelRegs (uint32_t channel);
+uint32_t dmaMemAlloc (uint32_t size, void** virt, uint32_t* bus);
+void dmaMemFree (uint32_t handle, void* virt, uint32_t size);
+
 // bitbang
 int bbSPIOpen (uint32_t CS, uint32_t MISO, uint32_t MOSI, uint32_t SCLK, uint32_t baud, uint32_t spiFlags);
 int bbSPIXfer (uint32_t CS, char* inBuf, char* outBuf, uint32_t count);
@@ -96,6 +96,27 @@ void cSharpLcd::displayFrame() {
   gpioWrite (SCS, 0);
   }
 //}}}
+//{{{
+int cSharpLcd::displayFrame (cFrameBuf<cMono1>& frameBuf) {
+// send only changed lines of native 1bpp frameBuf, return number of lines sent
+// - each changed row run is one multi line write, next line command byte or padding byte is its trailer
+
+  int lines = 0;
+  for (sSpan* span = frameBuf.diff(); span; span = span->next) {
+    for (int lineNumber = span->r.top; lineNumber < span->r.bottom; lineNumber++)
+      memcpy (mFrameBuffer + (lineNumber * kRowBytes) + kRowHeader, frameBuf.getRow (lineNumber), kRowDataBytes);
+
+    gpioWrite (SCS, 1);
+    spiWrite (mHandle, mFrameBuffer + (span->r.top * kRowBytes), ((span->r.bottom - span->r.top) * kRowBytes) + 1);
+    gpioWrite (SCS, 0);
+
+    lines += span->r.bottom - span->r.top;
+    }
+
+  frameBuf.copy();
+  return lines;
+  }
+//}}}
 
 //{{{
 void cSharpLcd::setLine() {
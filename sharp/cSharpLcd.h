@@ -1,6 +1,7 @@
 // cSharpLcd.h
 #pragma once
 #include <stdint.h>
+#include "../lcd/cFrameBuf.h"
 
 class cSharpLcd {
 public:
@@ -15,6 +16,7 @@ public:
   void turnOn();
 
   void displayFrame();
+  int displayFrame (cFrameBuf<cMono1>& frameBuf);
 
   // line buffer
   void setLine();
@@ -3,6 +3,7 @@
 #include <unistd.h>
 #include <cstdio>
 #include <cmath>
+#include <algorithm>
 
 using namespace std;
 
@@ -154,6 +155,32 @@ int main() {
       toggle = !toggle;
       }
     //}}}
+
+    printf ("native 1bpp frameBuf\n");
+    //{{{  bouncing block, only changed lines sent
+    cFrameBuf<cMono1> frameBuf (lcdWidth, lcdHeight);
+    sharpLcd.clearDisplay();
+
+    constexpr int kFrames = 200;
+    int firstLines = 0;
+    int laterLines = 0;
+    int maxLaterLines = 0;
+    for (int i = 0; i < kFrames; i++) {
+      frameBuf.clear (0xFFFF);
+      int x = abs ((i * 3) % (2 * (lcdWidth - 16)) - (lcdWidth - 16));
+      frameBuf.rect (0x0000, cRect (x, 40, x + 16, 56));
+      int lines = sharpLcd.displayFrame (frameBuf);
+      if (i == 0)
+        firstLines = lines;
+      else {
+        laterLines += lines;
+        maxLaterLines = max (maxLaterLines, lines);
+        }
+      usleep (10000);
+      }
+    printf ("first frame %d lines, later frames %d lines average, %d max\n",
+            firstLines, laterLines / (kFrames - 1), maxLaterLines);
+    //}}}
     }
 
   sleep(1);
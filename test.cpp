@@ -1,6 +1,14 @@
 // test.cpp
 //{{{  includes
 #include "lcd/cLcd.h"
+#include "lcd/cDisplayList.h"
+#include "lcd/cDrawAA.h"
+#include "lcd/cLcdBus.h"
+#include "lcd/cLcdBusDma.h"
+#include "lcd/cDmaModel.h"
+#include "lcd/cMaskCache.h"
+#include "lcd/cSdfAtlas.h"
+#include "lcd/cSprite.h"
 #include "cTouchscreen.h"
 
 #include "../shared/utils/utils.h"
@@ -291,9 +299,516 @@ void radial (cLcd* lcd, int dim) {
 
   lcd->present();
 
+  // native rgb565 radialGrad, same square, no surface composite
+  lcd->clear();
+
+  time = lcd->timeUs();
+  lcd->radialGrad (cPoint (width/2, height/2), dim/2, kWhite, kBlack);
+  double time4 = lcd->timeUs() - time;
+
+  lcd->present();
+
   cLog::log (LOGINFO1, dec(int(time1*1000000.)) + " " +
                        dec(int(time2*1000000.)) + " " +
-                       dec(int(time3*1000000.)));
+                       dec(int(time3*1000000.)) + " " +
+                       dec(int(time4*1000000.)));
+  }
+//}}}
+
+//{{{
+void sprites (cLcd* lcd) {
+// time pix loop transparency against sprite blits, 64x64 disc icon with soft edge
+
+  constexpr int kDim = 64;
+  uint16_t pixels[kDim*kDim];
+  uint8_t alpha[kDim*kDim];
+  for (int y = 0; y < kDim; y++)
+    for (int x = 0; x < kDim; x++) {
+      float r = sqrtf (float((x - kDim/2) * (x - kDim/2) + (y - kDim/2) * (y - kDim/2)));
+      float a = (kDim/2 - r) * 64.f;
+      alpha[(y*kDim) + x] = a <= 0.f ? 0 : a >= 255.f ? 255 : uint8_t(a);
+      pixels[(y*kDim) + x] = alpha[(y*kDim) + x] ? ((x / 8 + y / 8) & 1 ? kYellow : kRed) : kMagenta;
+      }
+
+  cSprite alphaSprite (kDim, kDim, pixels, alpha);
+  cSprite keySprite (kDim, kDim, pixels, kMagenta);
+  cSprite rleSprite (kDim, kDim, pixels, alpha);
+  rleSprite.compressRle();
+
+  constexpr int kRepeat = 100;
+  double times[4];
+  for (int i = 0; i < 4; i++) {
+    lcd->clear (kBlue);
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++) {
+      cPoint p ((repeat * 7) % (lcd->getWidth() - kDim/2), (repeat * 5) % (lcd->getHeight() - kDim/2));
+      if (i == 0) {
+        for (int y = 0; y < kDim; y++)
+          for (int x = 0; x < kDim; x++)
+            lcd->pix (pixels[(y*kDim) + x], alpha[(y*kDim) + x], p + cPoint (x, y));
+        }
+      else
+        lcd->blit (i == 1 ? alphaSprite : i == 2 ? keySprite : rleSprite, p);
+      }
+    times[i] = (lcd->timeUs() - time) / kRepeat;
+    lcd->present();
+    }
+
+  cLog::log (LOGINFO, "pix:" + dec(int(times[0]*1000000.)) +
+                      " alpha:" + dec(int(times[1]*1000000.)) +
+                      " key:" + dec(int(times[2]*1000000.)) +
+                      " rle:" + dec(int(times[3]*1000000.)) + " uS");
+  }
+//}}}
+
+//{{{
+void scaled (cLcd* lcd) {
+// time 640x480 image scaled to whole screen, nearest, box and bilinear
+
+  constexpr int kWidth = 640;
+  constexpr int kHeight = 480;
+  uint16_t* image = (uint16_t*)malloc (kWidth * kHeight * 2);
+  for (int y = 0; y < kHeight; y++)
+    for (int x = 0; x < kWidth; x++)
+      image[(y*kWidth) + x] = ((x / 16 + y / 16) & 1) ? kWhite : uint16_t(((x * 31 / kWidth) << 11) | (y * 63 / kHeight) << 5);
+
+  constexpr int kRepeat = 20;
+  double times[3];
+  for (int i = 0; i < 3; i++) {
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++)
+      lcd->copyScaled (image, cRect (0,0, kWidth,kHeight), kWidth, lcd->getRect(), cLcd::eFilter(i));
+    times[i] = (lcd->timeUs() - time) / kRepeat;
+    lcd->present();
+    }
+
+  free (image);
+
+  cLog::log (LOGINFO, "nearest:" + dec(int(times[0]*1000000.)) +
+                      " box:" + dec(int(times[1]*1000000.)) +
+                      " bilinear:" + dec(int(times[2]*1000000.)) + " uS");
+  }
+//}}}
+
+//{{{
+void sortAA (cLcd* lcd) {
+// time renderAA with radix and qsort cell sort, text like small rings and complex star path
+
+  const int width = lcd->getWidth();
+  const int height = lcd->getHeight();
+  uint16_t* frameBuf = (uint16_t*)aligned_alloc (128, width * height * 2);
+  cDrawAA drawAA;
+
+  constexpr int kRepeat = 20;
+  double times[2][2];
+  for (int path = 0; path < 2; path++)
+    for (int radix = 0; radix < 2; radix++) {
+      drawAA.setRadixSort (radix);
+      double time = lcd->timeUs();
+      for (int repeat = 0; repeat < kRepeat; repeat++) {
+        srand (repeat);
+        if (path == 0) {
+          //{{{  300 glyph sized rings
+          for (int glyph = 0; glyph < 300; glyph++) {
+            float x = rand() % width;
+            float y = rand() % height;
+            float r = 3.f + (rand() % 6);
+            drawAA.moveTo (int((x + r) * 256.f), int(y * 256.f));
+            for (int i = 1; i < 10; i++)
+              drawAA.lineTo (int((x + r * cosf (i * 0.628f)) * 256.f), int((y + r * sinf (i * 0.628f)) * 256.f));
+            drawAA.moveTo (int((x + r/2) * 256.f), int(y * 256.f));
+            for (int i = 9; i > 0; i--)
+              drawAA.lineTo (int((x + r/2 * cosf (i * 0.628f)) * 256.f), int((y + r/2 * sinf (i * 0.628f)) * 256.f));
+            }
+          }
+          //}}}
+        else {
+          //{{{  400 point star
+          float radius = (width < height ? width : height) / 2.f;
+          drawAA.moveTo (int(width * 128.f), int(height * 128.f));
+          for (int i = 0; i < 400; i++) {
+            float r = (i & 1) ? radius : radius * (rand() % 50) / 100.f;
+            drawAA.lineTo (int((width / 2.f + r * cosf (i * 0.0785f)) * 256.f),
+                           int((height / 2.f + r * sinf (i * 0.0785f)) * 256.f));
+            }
+          }
+          //}}}
+        drawAA.render (kWhite, true, frameBuf, width, cRect (0,0, width,height));
+        }
+      times[path][radix] = (lcd->timeUs() - time) / kRepeat;
+      }
+
+  free (frameBuf);
+
+  cLog::log (LOGINFO, "text qsort:" + dec(int(times[0][0]*1000000.)) +
+                      " radix:" + dec(int(times[0][1]*1000000.)) +
+                      " star qsort:" + dec(int(times[1][0]*1000000.)) +
+                      " radix:" + dec(int(times[1][1]*1000000.)) + " uS");
+  }
+//}}}
+
+//{{{
+void compoundAA (cLcd* lcd) {
+// time gauge face of many small shapes, each rendered on its own, then as one compound render
+
+  const int width = lcd->getWidth();
+  const int height = lcd->getHeight();
+  uint16_t* frameBuf = (uint16_t*)aligned_alloc (128, width * height * 2);
+  cDrawAA drawAA;
+
+  constexpr int kRepeat = 20;
+  double times[2];
+  for (int compound = 0; compound < 2; compound++) {
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++) {
+      float centreX = width / 2.f;
+      float centreY = height / 2.f;
+      float radius = (width < height ? width : height) / 2.f - 4.f;
+
+      // 60 ticks, major every 5, colours stepping round the dial
+      for (int tick = 0; tick < 60; tick++) {
+        uint16_t colour = (tick % 5) ? kLightGrey : (tick < 45) ? kWhite : kRed;
+        float angle = tick * 0.10472f;
+        float cosA = cosf (angle);
+        float sinA = sinf (angle);
+        float inner = radius - ((tick % 5) ? 8.f : 16.f);
+        float halfWidth = (tick % 5) ? 0.75f : 1.5f;
+        if (compound)
+          drawAA.addStyle (colour, true);
+        drawAA.moveTo (int((centreX + (inner * cosA) - (halfWidth * sinA)) * 256.f),
+                       int((centreY + (inner * sinA) + (halfWidth * cosA)) * 256.f));
+        drawAA.lineTo (int((centreX + (radius * cosA) - (halfWidth * sinA)) * 256.f),
+                       int((centreY + (radius * sinA) + (halfWidth * cosA)) * 256.f));
+        drawAA.lineTo (int((centreX + (radius * cosA) + (halfWidth * sinA)) * 256.f),
+                       int((centreY + (radius * sinA) - (halfWidth * cosA)) * 256.f));
+        drawAA.lineTo (int((centreX + (inner * cosA) + (halfWidth * sinA)) * 256.f),
+                       int((centreY + (inner * sinA) - (halfWidth * cosA)) * 256.f));
+        if (!compound)
+          drawAA.render (colour, true, frameBuf, width, cRect (0,0, width,height));
+        }
+
+      // needle over ticks, hub over needle
+      float angle = repeat * 0.3f;
+      if (compound)
+        drawAA.addStyle (kYellow, true);
+      drawAA.moveTo (int((centreX + (radius * cosf (angle))) * 256.f), int((centreY + (radius * sinf (angle))) * 256.f));
+      drawAA.lineTo (int((centreX + (6.f * cosf (angle + 1.57f))) * 256.f), int((centreY + (6.f * sinf (angle + 1.57f))) * 256.f));
+      drawAA.lineTo (int((centreX + (6.f * cosf (angle - 1.57f))) * 256.f), int((centreY + (6.f * sinf (angle - 1.57f))) * 256.f));
+      if (!compound)
+        drawAA.render (kYellow, true, frameBuf, width, cRect (0,0, width,height));
+
+      if (compound)
+        drawAA.addStyle (kBlue, true);
+      drawAA.moveTo (int((centreX + 8.f) * 256.f), int(centreY * 256.f));
+      for (int i = 1; i < 16; i++)
+        drawAA.lineTo (int((centreX + (8.f * cosf (i * 0.3927f))) * 256.f), int((centreY + (8.f * sinf (i * 0.3927f))) * 256.f));
+      if (compound)
+        drawAA.renderCompound (frameBuf, width, cRect (0,0, width,height));
+      else
+        drawAA.render (kBlue, true, frameBuf, width, cRect (0,0, width,height));
+      }
+    times[compound] = (lcd->timeUs() - time) / kRepeat;
+    }
+
+  free (frameBuf);
+
+  cLog::log (LOGINFO, "gauge separate:" + dec(int(times[0]*1000000.)) +
+                      " compound:" + dec(int(times[1]*1000000.)) + " uS");
+  }
+//}}}
+
+//{{{
+void cachedAA (cLcd* lcd) {
+// time 40 rounded button outlines a frame, rendered from path each time, then blitted from mask cache
+
+  cPath button;
+  button.moveTo (cPointF (-14.f, -6.f));
+  button.quadTo (cPointF (-14.f, -10.f), cPointF (-10.f, -10.f));
+  button.lineTo (cPointF (10.f, -10.f));
+  button.quadTo (cPointF (14.f, -10.f), cPointF (14.f, -6.f));
+  button.lineTo (cPointF (14.f, 6.f));
+  button.quadTo (cPointF (14.f, 10.f), cPointF (10.f, 10.f));
+  button.lineTo (cPointF (-10.f, 10.f));
+  button.quadTo (cPointF (-14.f, 10.f), cPointF (-14.f, 6.f));
+  button.close();
+
+  constexpr int kRepeat = 20;
+  double times[2];
+  for (int cached = 0; cached < 2; cached++) {
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++) {
+      lcd->clear (kBlack);
+      for (int i = 0; i < 40; i++) {
+        // drifting a quarter pixel a frame, so 16 subpixel masks
+        cPointF pos (20.f + ((i % 8) * 36) + ((repeat % 4) * 0.25f), 20.f + ((i / 8) * 40) + ((repeat / 4) % 4) * 0.25f);
+        if (cached)
+          lcd->strokeCachedAA (kWhite, button, pos, 2.f, cPath::eRoundJoin);
+        else {
+          cPath placed (button);
+          placed.translate (pos);
+          lcd->strokeAA (placed, 2.f, cPath::eRoundJoin);
+          lcd->renderAA (kWhite, true);
+          }
+        }
+      lcd->present();
+      }
+    times[cached] = (lcd->timeUs() - time) / kRepeat;
+    }
+
+  cLog::log (LOGINFO, "buttons path:" + dec(int(times[0]*1000000.)) +
+                      " cached:" + dec(int(times[1]*1000000.)) + " uS" +
+                      " hits:" + dec(lcd->getMaskCache()->getHits()) +
+                      " misses:" + dec(lcd->getMaskCache()->getMisses()));
+  }
+//}}}
+
+//{{{
+void threadsAA (cLcd* lcd) {
+// time full screen star and rings fill, 1 to 4 render threads
+
+  const int width = lcd->getWidth();
+  const int height = lcd->getHeight();
+  float centreX = width / 2.f;
+  float centreY = height / 2.f;
+  float radius = (width < height ? width : height) / 2.f;
+
+  constexpr int kRepeat = 20;
+  double times[4];
+  for (int threads = 1; threads <= 4; threads++) {
+    lcd->setThreadsAA (threads);
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++) {
+      lcd->clear (kBlack);
+      lcd->moveToAA (cPointF (centreX + radius, centreY));
+      for (int i = 1; i < 200; i++) {
+        float r = (i & 1) ? radius * 0.3f : radius;
+        lcd->lineToAA (cPointF (centreX + (r * cosf (i * 0.0314159f + repeat * 0.01f)),
+                                centreY + (r * sinf (i * 0.0314159f + repeat * 0.01f))));
+        }
+      for (int ring = 1; ring < 8; ring++)
+        lcd->ellipseOutlineAA (cPointF (centreX, centreY), cPointF (ring * radius / 8.f, ring * radius / 8.f), 1.5f);
+      lcd->renderAA (kWhite, true);
+      lcd->present();
+      }
+    times[threads-1] = (lcd->timeUs() - time) / kRepeat;
+    }
+  lcd->setThreadsAA (1);
+
+  cLog::log (LOGINFO, "fill threads 1:" + dec(int(times[0]*1000000.)) +
+                      " 2:" + dec(int(times[1]*1000000.)) +
+                      " 3:" + dec(int(times[2]*1000000.)) +
+                      " 4:" + dec(int(times[3]*1000000.)) + " uS");
+  }
+//}}}
+
+//{{{
+void sdfText (cLcd* lcd) {
+// time dashboard text at 6 heights, glyph outlines each time, then sampled from one sdf atlas
+
+  const float heights[6] = { 12.f, 16.f, 20.f, 24.f, 32.f, 48.f };
+
+  constexpr int kRepeat = 20;
+  double times[2];
+  for (int sdf = 0; sdf < 2; sdf++) {
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++) {
+      lcd->clear (kBlack);
+      float y = 0.f;
+      for (auto height : heights) {
+        if (sdf)
+          lcd->textSdf (kWhite, cPointF (4.f, y), height, "Speed 88 km/h");
+        else
+          lcd->textAA (kWhite, cPointF (4.f, y), height, "Speed 88 km/h");
+        y += height + 2.f;
+        }
+      lcd->present();
+      }
+    times[sdf] = (lcd->timeUs() - time) / kRepeat;
+    }
+
+  cLog::log (LOGINFO, "text outline:" + dec(int(times[0]*1000000.)) +
+                      " sdf:" + dec(int(times[1]*1000000.)) + " uS" +
+                      " atlas:" + dec(lcd->getSdfAtlas()->getWidth()) + "x" + dec(lcd->getSdfAtlas()->getHeight()));
+  }
+//}}}
+
+//{{{
+void subpixelText (cLcd* lcd) {
+// time small text greyscale outlines, then subpixel from mask cache, first frame of subpixel warms cache
+
+  const float heights[3] = { 12.f, 14.f, 16.f };
+
+  constexpr int kRepeat = 20;
+  double times[2];
+  for (int subpixel = 0; subpixel < 2; subpixel++) {
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++) {
+      lcd->clear (kBlack);
+      float y = 0.f;
+      for (int line = 0; line < 12; line++) {
+        float height = heights[line % 3];
+        if (subpixel)
+          lcd->textSubpixel (kWhite, cPointF (4.f, y), height, "Oil 4.2 bar  Temp 87C");
+        else
+          lcd->textAA (kWhite, cPointF (4.f, y), height, "Oil 4.2 bar  Temp 87C");
+        y += height + 4.f;
+        }
+      lcd->present();
+      }
+    times[subpixel] = (lcd->timeUs() - time) / kRepeat;
+    }
+
+  cLog::log (LOGINFO, "small text grey:" + dec(int(times[0]*1000000.)) +
+                      " subpixel:" + dec(int(times[1]*1000000.)) + " uS");
+  }
+//}}}
+
+//{{{
+void zoomAA (cLcd* lcd) {
+// time chart zoomed 50x, mostly off screen, segments made into cells, then clipped as added
+
+  const int width = lcd->getWidth();
+  const int height = lcd->getHeight();
+  uint16_t* frameBuf = (uint16_t*)aligned_alloc (128, width * height * 2);
+  cDrawAA drawAA;
+
+  constexpr int kRepeat = 20;
+  double times[2];
+  for (int clipped = 0; clipped < 2; clipped++) {
+    if (clipped)
+      drawAA.setClipBox (cRect (0,0, width,height));
+
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++) {
+      drawAA.moveTo (-8000 * 256, height * 256);
+      for (int i = 0; i <= 2000; i++)
+        drawAA.lineTo ((-8000 + (i * 8)) * 256, int(((height / 2.f) + (60.f * sinf ((i + repeat) * 0.05f))) * 256.f));
+      drawAA.lineTo (8000 * 256, height * 256);
+      drawAA.render (kGreen, true, frameBuf, width, cRect (0,0, width,height));
+      }
+    times[clipped] = (lcd->timeUs() - time) / kRepeat;
+    }
+
+  free (frameBuf);
+
+  cLog::log (LOGINFO, "zoomed chart unclipped:" + dec(int(times[0]*1000000.)) +
+                      " clipped:" + dec(int(times[1]*1000000.)) + " uS");
+  }
+//}}}
+
+//{{{
+void busBench (cLcd* lcd) {
+// time full screen of rows through lcd bus, then through in memory recorder, same pixels as presented
+
+  const int width = lcd->getWidth();
+  const int height = lcd->getHeight();
+
+  // vertical bars, each row the same
+  for (int x = 0; x < width; x += 8)
+    lcd->rect (uint16_t(x * 0x0821), cRect (x,0, x+8,height));
+  lcd->present();
+
+  uint16_t* row = (uint16_t*)malloc (width * 2);
+  for (int x = 0; x < width; x++)
+    row[x] = uint16_t((x & ~7) * 0x0821);
+
+  cLcdBusRecorder recorder;
+  cLcdBus* buses[2] = { lcd->getBus(), &recorder };
+
+  constexpr int kRepeat = 20;
+  double times[2];
+  for (int i = 0; i < 2; i++) {
+    double time = lcd->timeUs();
+    for (int repeat = 0; repeat < kRepeat; repeat++) {
+      recorder.clear();
+      for (int y = 0; y < height; y++)
+        buses[i]->pixels (row, width);
+      buses[i]->submit();
+      buses[i]->wait();
+      }
+    times[i] = (lcd->timeUs() - time) / kRepeat;
+    }
+
+  free (row);
+
+  cLog::log (LOGINFO, string ("frame bus ") + lcd->getBus()->getName() + ":" + dec(int(times[0]*1000000.)) +
+                      " recorder:" + dec(int(times[1]*1000000.)) + " uS " +
+                      dec((int)recorder.getBytes().size()) + " bytes");
+  }
+//}}}
+
+//{{{
+void dmaModel (cLcd* lcd) {
+// random windows of random frames through dma bus on simulated dma, wire compared with recorder of same calls
+// - odd window edges take the row fallback, every fourth frame of small windows overflows the chain
+
+  const int width = lcd->getWidth();
+  const int height = lcd->getHeight();
+  uint16_t* frame = (uint16_t*)aligned_alloc (128, width * height * 2);
+
+  cLcdBusRecorder recorder;
+  cLcdBusRecorder wire;
+  cDmaModel* model = new cDmaModel (&wire);
+  cLcdBusDmaSpi dma (0, 24, model);
+  dma.open();
+  cLcdBus* buses[2] = { &recorder, &dma };
+
+  constexpr int kFrames = 20;
+  double times[2] = { 0., 0. };
+  uint32_t transfers = 0;
+  uint32_t controlBlocks = 0;
+  int mismatches = 0;
+  int pendingErrors = 0;
+  for (int frameNum = 0; frameNum < kFrames; frameNum++) {
+    for (int i = 0; i < width * height; i++)
+      frame[i] = uint16_t(rand());
+
+    vector<cRect> windows ((frameNum % 4) == 3 ? 400 : 16);
+    int maxSize = (frameNum % 4) == 3 ? 8 : width;
+    for (auto& r : windows) {
+      int x = rand() % width;
+      int y = rand() % height;
+      r = cRect (x, y, x + 1 + (rand() % min (maxSize, width - x)), y + 1 + (rand() % min (maxSize, height - y)));
+      }
+    if (!frameNum)
+      windows[0] = lcd->getRect();
+
+    recorder.clear();
+    wire.clear();
+    for (int i = 0; i < 2; i++) {
+      double time = lcd->timeUs();
+      for (auto& r : windows) {
+        const uint8_t columns[4] = { uint8_t(r.left >> 8), uint8_t(r.left),
+                                     uint8_t((r.right-1) >> 8), uint8_t(r.right-1) };
+        buses[i]->commandData (0x2A, columns, 4);
+        buses[i]->command (0x2C);
+        buses[i]->pixelRows (frame, width, r);
+        }
+      if ((buses[i] == &dma) && !dma.getPending())
+        pendingErrors++;
+      buses[i]->submit();
+      times[i] += lcd->timeUs() - time;
+      buses[i]->wait();
+      if (buses[i]->getPending())
+        // delayUs relies on nothing pending after wait
+        pendingErrors++;
+      }
+
+    transfers += dma.getNumTransfers();
+    controlBlocks += dma.getNumControlBlocks();
+    if ((wire.getBytes() != recorder.getBytes()) ||
+        (wire.getNumCommands() != recorder.getNumCommands()) ||
+        (wire.getOps().size() != recorder.getOps().size()))
+      mismatches++;
+    }
+
+  free (frame);
+
+  cLog::log (LOGINFO, "dma model frames:" + dec(kFrames) + " mismatches:" + dec(mismatches) +
+                      " errors:" + dec(model->getNumErrors()) + " pending:" + dec(pendingErrors) +
+                      " last chain transfers:" + dec(transfers) + " cbs:" + dec(controlBlocks) +
+                      " queue dma:" + dec(int(times[1]*1000000./kFrames)) +
+                      " recorder:" + dec(int(times[0]*1000000./kFrames)) + " uS");
   }
 //}}}
 
@@ -301,6 +816,20 @@ int main (int numArgs, char* args[]) {
 
   bool draw = false;
   bool drawRadial = false;
+  bool drawSprites = false;
+  bool drawScaled = false;
+  bool drawRetained = false;
+  bool drawIndexed = false;
+  bool drawSortAA = false;
+  bool drawCompoundAA = false;
+  bool drawCachedAA = false;
+  bool drawThreadsAA = false;
+  bool drawSdfText = false;
+  bool drawSubpixelText = false;
+  bool drawZoomAA = false;
+  bool drawBusBench = false;
+  bool drawDmaModel = false;
+  cLcd::eSubpixel subpixel = cLcd::eSubpixelRGB;
   cLcd::eRotate rotate = cLcd::e0;
   cLcd::eInfo info = cLcd::eNone;
   cLcd::eMode mode = cLcd::eCoarse;
@@ -328,6 +857,20 @@ int main (int numArgs, char* args[]) {
 
     else if (str == "r") drawRadial = true;
     else if (str == "d") draw = true;
+    else if (str == "sprite") drawSprites = true;
+    else if (str == "scale") drawScaled = true;
+    else if (str == "retained") drawRetained = true;
+    else if (str == "indexed") drawIndexed = true;
+    else if (str == "sortaa") drawSortAA = true;
+    else if (str == "compound") drawCompoundAA = true;
+    else if (str == "cached") drawCachedAA = true;
+    else if (str == "threads") drawThreadsAA = true;
+    else if (str == "sdf") drawSdfText = true;
+    else if (str == "subpixel") drawSubpixelText = true;
+    else if (str == "bgr") subpixel = cLcd::eSubpixelBGR;
+    else if (str == "zoom") drawZoomAA = true;
+    else if (str == "bus") drawBusBench = true;
+    else if (str == "dmamodel") drawDmaModel = true;
 
     else if (str == "1289") lcdType = 1289;
     else if (str == "7601") lcdType = 7601;
@@ -336,6 +879,8 @@ int main (int numArgs, char* args[]) {
     else if (str == "9320") lcdType = 9320;
     else if (str == "9341p8") lcdType = 93418;
     else if (str == "9341p16") lcdType = 934116;
+    else if (str == "9341dma") lcdType = 93410;
+    else if (str == "9486") lcdType = 9486;
     else if (str == "100k") spiSpeed = 100000;
     else if (str == "400k") spiSpeed = 400000;
 
@@ -368,6 +913,8 @@ int main (int numArgs, char* args[]) {
     case 9341: lcd = new cLcd9341 (rotate, info, mode, spiSpeed); break; // 30000000
     case 93418: lcd = new cLcd9341p8 (rotate, info, mode); break;
     case 934116: lcd = new cLcd9341p16 (rotate, info, mode); break;
+    case 93410: lcd = new cLcd9341dma (rotate, info, mode, spiSpeed); break;
+    case 9486: lcd = new cLcd9486 (rotate, info, mode, spiSpeed); break; // 20000000
     default: exit(1);
     }
 
@@ -386,9 +933,76 @@ int main (int numArgs, char* args[]) {
       radial (lcd, i);
      }
     //}}}
+  if (drawSprites)
+    sprites (lcd);
+  if (drawScaled)
+    scaled (lcd);
+  if (drawSortAA)
+    sortAA (lcd);
+  if (drawCompoundAA)
+    compoundAA (lcd);
+  if (drawCachedAA)
+    cachedAA (lcd);
+  if (drawThreadsAA)
+    threadsAA (lcd);
+  if (drawSdfText)
+    sdfText (lcd);
+  if (drawSubpixelText) {
+    lcd->setSubpixel (subpixel);
+    subpixelText (lcd);
+    }
+  if (drawZoomAA)
+    zoomAA (lcd);
+  if (drawBusBench)
+    busBench (lcd);
+  if (drawDmaModel)
+    dmaModel (lcd);
+
+  //{{{  day, night palettes, index 0 background, 1 panel, 2 bar
+  uint16_t dayPalette[256] = { kWhite, kLightGrey, kBlue };
+  uint16_t nightPalette[256] = { kBlack, kNavy, kMaroon };
+  if (drawIndexed)
+    lcd->setIndexed (dayPalette);
+  //}}}
+
+  cDisplayList displayList;
+  int frame = 0;
 
   while (true) {
-    if (draw) {
+    if (drawRetained) {
+      //{{{  retained dashboard, only changed commands rendered and sent
+      displayList.begin();
+      displayList.clear (kNavy);
+      displayList.hGrad (kBlack, kBlue, cRect (0,0, lcd->getWidth(), 30));
+      displayList.text (kWhite, cPoint (4,0), 24, "dashboard");
+      displayList.text (kYellow, cPoint (4,40), 40, dec(frame / 10));
+      displayList.radialGrad (cPoint (lcd->getWidth() / 2, lcd->getHeight() / 2), 40, kWhite, kNavy);
+      displayList.rect (kGreen, cRect (4, lcd->getHeight() - 20, 4 + (frame % lcd->getWidth()), lcd->getHeight() - 4));
+      lcd->present (displayList);
+
+      frame++;
+      lcd->delayUs (5000);
+      }
+      //}}}
+    else if (drawIndexed) {
+      //{{{  indexed, colours are indices, palette swap resends everything without redrawing
+      if ((frame % (lcd->getWidth() - 32)) == 0) {
+        lcd->clear (0);
+        lcd->rect (1, cRect (8,8, lcd->getWidth() - 8, lcd->getHeight() - 8));
+        lcd->text (2, cPoint (16,16), 24, "indexed");
+        }
+      lcd->rect (2, cRect (16, lcd->getHeight() - 40, 16 + (frame % (lcd->getWidth() - 32)), lcd->getHeight() - 16));
+      if ((frame % 200) == 100)
+        lcd->setPalette (nightPalette);
+      else if ((frame % 200) == 0)
+        lcd->setPalette (dayPalette);
+      lcd->present();
+
+      frame++;
+      lcd->delayUs (5000);
+      }
+      //}}}
+    else if (draw) {
       //{{{  draw test
       float height = 30.f;
       float maxHeight = 60.f;
@@ -409,9 +1023,9 @@ int main (int numArgs, char* args[]) {
         int16_t z;
         if (ts->getTouchPos (&x,&y,&z, lcd->getWidth(), lcd->getHeight())) {
           cPointF p (x-2,y-2);
-          lcd->ellipseAA (p, cPointF(height/2.f, height/2.f), 16);
+          lcd->ellipseAA (p, cPointF(height/2.f, height/2.f));
           lcd->renderAA (kYellow, true);
-          lcd->ellipseOutlineAA (p, cPointF(height/2.f, height/2.f), height / 4.f, 16);
+          lcd->ellipseOutlineAA (p, cPointF(height/2.f, height/2.f), height / 4.f);
           lcd->renderAA (kBlue, true);
           }
         else